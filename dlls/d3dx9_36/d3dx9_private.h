@@ -33,6 +33,16 @@
 
 #define ULONG64_MAX (~(ULONG64)0)
 
+/* Only on x86_64, where the scalar code uses SSE arithmetic as well and
+ * both paths round the same way; the x87 FPU of i386 doesn't.
+ * The SSE code uses the compiler's vector extensions, the intrinsics headers
+ * can't be used with msvcrt. */
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_D3DX_SSE
+typedef float d3dx_vec4 __attribute__((vector_size(16)));
+typedef float d3dx_vec4_unaligned __attribute__((vector_size(16), aligned(4), may_alias));
+#endif
+
 struct vec4
 {
     float x, y, z, w;
@@ -111,6 +121,11 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     const struct volume *src_size, const struct pixel_format_desc *src_format,
     BYTE *dst, UINT dst_row_pitch, UINT dst_slice_pitch, const struct volume *dst_size,
     const struct pixel_format_desc *dst_format, D3DCOLOR color_key, const PALETTEENTRY *palette) DECLSPEC_HIDDEN;
+void filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch,
+    const struct volume *src_size, const struct pixel_format_desc *src_format,
+    BYTE *dst, UINT dst_row_pitch, UINT dst_slice_pitch, const struct volume *dst_size,
+    const struct pixel_format_desc *dst_format, D3DCOLOR color_key, const PALETTEENTRY *palette,
+    DWORD filter) DECLSPEC_HIDDEN;
 
 HRESULT load_texture_from_dds(IDirect3DTexture9 *texture, const void *src_data, const PALETTEENTRY *palette,
         DWORD filter, D3DCOLOR color_key, const D3DXIMAGE_INFO *src_info, unsigned int skip_levels,
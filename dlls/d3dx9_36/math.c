@@ -41,6 +41,124 @@ struct ID3DXMatrixStackImpl
 
 static const unsigned int INITIAL_STACK_SIZE = 32;
 
+/*_________________SSE___________________________*/
+
+#ifdef HAVE_D3DX_SSE
+
+static inline void sse_load_matrix(d3dx_vec4 *rows, const D3DXMATRIX *m)
+{
+    rows[0] = *(const d3dx_vec4_unaligned *)m->u.m[0];
+    rows[1] = *(const d3dx_vec4_unaligned *)m->u.m[1];
+    rows[2] = *(const d3dx_vec4_unaligned *)m->u.m[2];
+    rows[3] = *(const d3dx_vec4_unaligned *)m->u.m[3];
+}
+
+static inline d3dx_vec4 sse_splat(float f)
+{
+    return (d3dx_vec4){f, f, f, f};
+}
+
+/* Multiplies the row vector (x, y, z, w) by the matrix. The terms are summed
+ * in the same order as in the scalar code. */
+static inline d3dx_vec4 sse_transform(float x, float y, float z, float w, const d3dx_vec4 *rows)
+{
+    return rows[0] * sse_splat(x) + rows[1] * sse_splat(y) + rows[2] * sse_splat(z) + rows[3] * sse_splat(w);
+}
+
+static void matrix_multiply_sse(D3DXMATRIX *out, const D3DXMATRIX *m1, const D3DXMATRIX *m2,
+        BOOL transpose)
+{
+    d3dx_vec4 rows[4], res[4];
+    unsigned int i, j;
+
+    sse_load_matrix(rows, m2);
+    for (i = 0; i < 4; ++i)
+        res[i] = sse_transform(m1->u.m[i][0], m1->u.m[i][1], m1->u.m[i][2], m1->u.m[i][3], rows);
+    if (transpose)
+    {
+        for (i = 0; i < 4; ++i)
+            for (j = 0; j < 4; ++j)
+                out->u.m[j][i] = res[i][j];
+        return;
+    }
+    for (i = 0; i < 4; ++i)
+        *(d3dx_vec4_unaligned *)out->u.m[i] = res[i];
+}
+
+static void vec3_transform_array_sse(D3DXVECTOR4 *out, UINT outstride, const D3DXVECTOR3 *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    const D3DXVECTOR3 *v;
+    d3dx_vec4 rows[4];
+    UINT i;
+
+    sse_load_matrix(rows, matrix);
+    if (!((ULONG_PTR)out & 15) && !(outstride & 15))
+    {
+        for (i = 0; i < elements; ++i)
+        {
+            v = (const D3DXVECTOR3 *)((const char *)in + instride * i);
+            *(d3dx_vec4 *)((char *)out + outstride * i) = sse_transform(v->x, v->y, v->z, 1.0f, rows);
+        }
+    }
+    else
+    {
+        for (i = 0; i < elements; ++i)
+        {
+            v = (const D3DXVECTOR3 *)((const char *)in + instride * i);
+            *(d3dx_vec4_unaligned *)((char *)out + outstride * i) = sse_transform(v->x, v->y, v->z, 1.0f, rows);
+        }
+    }
+}
+
+static void vec3_transform_coord_array_sse(D3DXVECTOR3 *out, UINT outstride, const D3DXVECTOR3 *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    const D3DXVECTOR3 *v;
+    d3dx_vec4 rows[4], r;
+    D3DXVECTOR3 *dst;
+    UINT i;
+
+    sse_load_matrix(rows, matrix);
+    for (i = 0; i < elements; ++i)
+    {
+        v = (const D3DXVECTOR3 *)((const char *)in + instride * i);
+        dst = (D3DXVECTOR3 *)((char *)out + outstride * i);
+        r = sse_transform(v->x, v->y, v->z, 1.0f, rows);
+        r = r / sse_splat(r[3]);
+        dst->x = r[0];
+        dst->y = r[1];
+        dst->z = r[2];
+    }
+}
+
+static void vec4_transform_array_sse(D3DXVECTOR4 *out, UINT outstride, const D3DXVECTOR4 *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    d3dx_vec4 rows[4], v;
+    UINT i;
+
+    sse_load_matrix(rows, matrix);
+    if (!((ULONG_PTR)out & 15) && !(outstride & 15) && !((ULONG_PTR)in & 15) && !(instride & 15))
+    {
+        for (i = 0; i < elements; ++i)
+        {
+            v = *(const d3dx_vec4 *)((const char *)in + instride * i);
+            *(d3dx_vec4 *)((char *)out + outstride * i) = sse_transform(v[0], v[1], v[2], v[3], rows);
+        }
+    }
+    else
+    {
+        for (i = 0; i < elements; ++i)
+        {
+            v = *(const d3dx_vec4_unaligned *)((const char *)in + instride * i);
+            *(d3dx_vec4_unaligned *)((char *)out + outstride * i) = sse_transform(v[0], v[1], v[2], v[3], rows);
+        }
+    }
+}
+
+#endif
+
 /*_________________D3DXColor____________________*/
 
 D3DXCOLOR* WINAPI D3DXColorAdjustContrast(D3DXCOLOR *pout, const D3DXCOLOR *pc, FLOAT s)
@@ -397,6 +515,11 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, c
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+#ifdef HAVE_D3DX_SSE
+    matrix_multiply_sse(pout, pm1, pm2, FALSE);
+    return pout;
+#endif
+
     for (i=0; i<4; i++)
     {
         for (j=0; j<4; j++)
@@ -416,6 +539,11 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiplyTranspose(D3DXMATRIX *pout, const D3DXMATRI
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+#ifdef HAVE_D3DX_SSE
+    matrix_multiply_sse(pout, pm1, pm2, TRUE);
+    return pout;
+#endif
+
     for (i = 0; i < 4; i++)
         for (j = 0; j < 4; j++)
             temp.u.m[j][i] = pm1->u.m[i][0] * pm2->u.m[0][j] + pm1->u.m[i][1] * pm2->u.m[1][j] + pm1->u.m[i][2] * pm2->u.m[2][j] + pm1->u.m[i][3] * pm2->u.m[3][j];
@@ -1879,6 +2007,11 @@ D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef HAVE_D3DX_SSE
+    vec3_transform_array_sse(out, outstride, in, instride, matrix, elements);
+    return out;
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1912,6 +2045,11 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef HAVE_D3DX_SSE
+    vec3_transform_coord_array_sse(out, outstride, in, instride, matrix, elements);
+    return out;
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformCoord(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -2086,6 +2224,11 @@ D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef HAVE_D3DX_SSE
+    vec4_transform_array_sse(out, outstride, in, instride, matrix, elements);
+    return out;
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec4Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1634,6 +1634,310 @@ static HRESULT remap_faces_for_attrsort(struct d3dx9_mesh *This, const DWORD *in
     return D3D_OK;
 }
 
+/* Vertex cache optimization, using Tom Forsyth's "Linear-speed vertex cache
+ * optimisation" algorithm. Faces are added greedily, always picking the face
+ * whose vertices score highest. A vertex scores higher when it is near the
+ * front of a simulated LRU cache, and when few faces are left to use it. */
+#define VCACHE_SIZE 32
+#define VCACHE_VALENCE_TABLE_SIZE 32
+
+struct vcache_vertex
+{
+    float score;
+    int cache_pos;
+    DWORD face_start;
+    DWORD active_faces;
+};
+
+struct vcache_scores
+{
+    float cache[VCACHE_SIZE];
+    float valence[VCACHE_VALENCE_TABLE_SIZE];
+};
+
+static void init_vcache_scores(struct vcache_scores *scores)
+{
+    unsigned int i;
+
+    /* The vertices of the last face get a fixed score, so that the order
+     * they were added in doesn't matter. */
+    for (i = 0; i < VCACHE_SIZE; i++)
+        scores->cache[i] = i < 3 ? 0.75f : powf(1.0f - (i - 3) / (float)(VCACHE_SIZE - 3), 1.5f);
+    scores->valence[0] = 0.0f;
+    for (i = 1; i < VCACHE_VALENCE_TABLE_SIZE; i++)
+        scores->valence[i] = 2.0f * powf(i, -0.5f);
+}
+
+static float vcache_vertex_score(const struct vcache_scores *scores, const struct vcache_vertex *vertex)
+{
+    float score;
+
+    if (!vertex->active_faces)
+        return -1.0f;
+
+    score = vertex->cache_pos < 0 ? 0.0f : scores->cache[vertex->cache_pos];
+    if (vertex->active_faces < VCACHE_VALENCE_TABLE_SIZE)
+        return score + scores->valence[vertex->active_faces];
+    return score + 2.0f * powf(vertex->active_faces, -0.5f);
+}
+
+/* Reorders a list of faces for the vertex cache. vertex_map needs an entry
+ * per mesh vertex, set to -1. It is used to number the vertices of the faces
+ * and is reset before returning. */
+static HRESULT optimize_faces_for_vertex_cache(const DWORD *indices, DWORD *faces, DWORD num_faces,
+        DWORD *vertex_map)
+{
+    DWORD cache[VCACHE_SIZE + 3], new_cache[VCACHE_SIZE + 3];
+    DWORD cache_size = 0, new_cache_size, num_vertices = 0;
+    DWORD *face_vertices, *vertex_faces = NULL, *new_faces = NULL;
+    DWORD best_face = 0, next_face = 0;
+    struct vcache_vertex *vertices = NULL;
+    struct vcache_scores scores;
+    float *face_scores = NULL;
+    HRESULT hr = E_OUTOFMEMORY;
+    DWORD i, j, k;
+
+    if (!(face_vertices = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*face_vertices))))
+        return E_OUTOFMEMORY;
+    for (i = 0; i < num_faces; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            DWORD index = indices[faces[i] * 3 + j];
+
+            if (vertex_map[index] == -1)
+                vertex_map[index] = num_vertices++;
+            face_vertices[i * 3 + j] = vertex_map[index];
+        }
+    }
+
+    vertices = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, num_vertices * sizeof(*vertices));
+    vertex_faces = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*vertex_faces));
+    face_scores = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*face_scores));
+    new_faces = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*new_faces));
+    if (!vertices || !vertex_faces || !face_scores || !new_faces)
+        goto cleanup;
+
+    /* List the faces using each vertex. */
+    for (i = 0; i < num_faces * 3; i++)
+        vertices[face_vertices[i]].active_faces++;
+    for (i = 0, j = 0; i < num_vertices; i++)
+    {
+        vertices[i].face_start = j;
+        j += vertices[i].active_faces;
+        vertices[i].active_faces = 0;
+    }
+    for (i = 0; i < num_faces * 3; i++)
+    {
+        struct vcache_vertex *vertex = &vertices[face_vertices[i]];
+        vertex_faces[vertex->face_start + vertex->active_faces++] = i / 3;
+    }
+
+    init_vcache_scores(&scores);
+    for (i = 0; i < num_vertices; i++)
+    {
+        vertices[i].cache_pos = -1;
+        vertices[i].score = vcache_vertex_score(&scores, &vertices[i]);
+    }
+    for (i = 0; i < num_faces; i++)
+    {
+        face_scores[i] = vertices[face_vertices[i * 3]].score + vertices[face_vertices[i * 3 + 1]].score
+                + vertices[face_vertices[i * 3 + 2]].score;
+        if (face_scores[i] > face_scores[best_face])
+            best_face = i;
+    }
+
+    for (i = 0; i < num_faces; i++)
+    {
+        float best_score = -1.0f;
+
+        /* None of the cached vertices is used by the remaining faces. Any
+         * face will do, so take the next one in the original order. */
+        if (best_face == -1)
+        {
+            while (face_scores[next_face] < 0.0f)
+                next_face++;
+            best_face = next_face;
+        }
+
+        new_faces[i] = faces[best_face];
+        /* Faces that have been added are marked with a negative score. */
+        face_scores[best_face] = -1.0f;
+
+        /* Move the vertices of the face to the front of the cache. */
+        new_cache_size = 0;
+        for (j = 0; j < 3; j++)
+        {
+            DWORD index = face_vertices[best_face * 3 + j];
+            struct vcache_vertex *vertex = &vertices[index];
+            DWORD *list = vertex_faces + vertex->face_start;
+
+            for (k = 0; list[k] != best_face; k++);
+            list[k] = list[--vertex->active_faces];
+
+            for (k = 0; k < new_cache_size && new_cache[k] != index; k++);
+            if (k == new_cache_size)
+                new_cache[new_cache_size++] = index;
+        }
+        for (j = 0; j < cache_size; j++)
+        {
+            for (k = 0; k < 3 && face_vertices[best_face * 3 + k] != cache[j]; k++);
+            if (k == 3)
+                new_cache[new_cache_size++] = cache[j];
+        }
+
+        /* Update the scores of the vertices whose position in the cache
+         * changed, and of the faces that still use them. */
+        for (j = 0; j < new_cache_size; j++)
+        {
+            struct vcache_vertex *vertex = &vertices[new_cache[j]];
+            float delta;
+
+            vertex->cache_pos = j < VCACHE_SIZE ? j : -1;
+            delta = vcache_vertex_score(&scores, vertex) - vertex->score;
+            vertex->score += delta;
+            for (k = 0; k < vertex->active_faces; k++)
+                face_scores[vertex_faces[vertex->face_start + k]] += delta;
+        }
+
+        best_face = -1;
+        for (j = 0; j < new_cache_size; j++)
+        {
+            const struct vcache_vertex *vertex = &vertices[new_cache[j]];
+
+            for (k = 0; k < vertex->active_faces; k++)
+            {
+                DWORD face = vertex_faces[vertex->face_start + k];
+
+                if (face_scores[face] > best_score)
+                {
+                    best_score = face_scores[face];
+                    best_face = face;
+                }
+            }
+        }
+
+        cache_size = min(new_cache_size, VCACHE_SIZE);
+        memcpy(cache, new_cache, cache_size * sizeof(*cache));
+    }
+
+    memcpy(faces, new_faces, num_faces * sizeof(*faces));
+    hr = D3D_OK;
+
+cleanup:
+    for (i = 0; i < num_faces * 3; i++)
+        vertex_map[indices[faces[i / 3] * 3 + i % 3]] = -1;
+    HeapFree(GetProcessHeap(), 0, new_faces);
+    HeapFree(GetProcessHeap(), 0, face_scores);
+    HeapFree(GetProcessHeap(), 0, vertex_faces);
+    HeapFree(GetProcessHeap(), 0, vertices);
+    HeapFree(GetProcessHeap(), 0, face_vertices);
+    return hr;
+}
+
+/* Reorder the faces of each attribute range for the vertex cache, updating
+ * face_remap. */
+static HRESULT remap_faces_for_vertex_cache(struct d3dx9_mesh *This, const DWORD *indices,
+        const DWORD *sorted_attrib_buffer, DWORD *face_remap)
+{
+    DWORD *new_faces, *vertex_map;
+    HRESULT hr = D3D_OK;
+    DWORD i, start;
+
+    new_faces = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(*new_faces));
+    vertex_map = HeapAlloc(GetProcessHeap(), 0, This->numvertices * sizeof(*vertex_map));
+    if (!new_faces || !vertex_map)
+    {
+        HeapFree(GetProcessHeap(), 0, new_faces);
+        HeapFree(GetProcessHeap(), 0, vertex_map);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < This->numfaces; i++)
+        new_faces[face_remap[i]] = i;
+    memset(vertex_map, 0xff, This->numvertices * sizeof(*vertex_map));
+
+    for (start = 0; start < This->numfaces; start = i)
+    {
+        for (i = start + 1; i < This->numfaces && sorted_attrib_buffer[i] == sorted_attrib_buffer[start]; i++);
+        hr = optimize_faces_for_vertex_cache(indices, new_faces + start, i - start, vertex_map);
+        if (FAILED(hr)) break;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        for (i = 0; i < This->numfaces; i++)
+            face_remap[new_faces[i]] = i;
+    }
+
+    HeapFree(GetProcessHeap(), 0, vertex_map);
+    HeapFree(GetProcessHeap(), 0, new_faces);
+    return hr;
+}
+
+/* Order the vertices by first use in the new face order, so that they are
+ * fetched sequentially. Unused vertices are removed when compacting, and moved
+ * to the end otherwise. */
+static HRESULT remap_vertices_for_vertex_cache(struct d3dx9_mesh *This, DWORD *indices, const DWORD *face_remap,
+        BOOL compact, DWORD *new_num_vertices, ID3DXBuffer **vertex_remap)
+{
+    DWORD *vertex_remap_ptr, *new_faces, *old_to_new;
+    DWORD num_used_vertices = 0;
+    HRESULT hr;
+    DWORD i, j;
+
+    hr = D3DXCreateBuffer(This->numvertices * sizeof(DWORD), vertex_remap);
+    if (FAILED(hr)) return hr;
+    vertex_remap_ptr = ID3DXBuffer_GetBufferPointer(*vertex_remap);
+
+    new_faces = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(*new_faces));
+    old_to_new = HeapAlloc(GetProcessHeap(), 0, This->numvertices * sizeof(*old_to_new));
+    if (!new_faces || !old_to_new)
+    {
+        HeapFree(GetProcessHeap(), 0, new_faces);
+        HeapFree(GetProcessHeap(), 0, old_to_new);
+        ID3DXBuffer_Release(*vertex_remap);
+        *vertex_remap = NULL;
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < This->numfaces; i++)
+        new_faces[face_remap[i]] = i;
+    memset(old_to_new, 0xff, This->numvertices * sizeof(*old_to_new));
+
+    /* create new->old vertex mapping */
+    for (i = 0; i < This->numfaces; i++) {
+        for (j = 0; j < 3; j++) {
+            DWORD index = indices[new_faces[i] * 3 + j];
+
+            if (old_to_new[index] == -1) {
+                old_to_new[index] = num_used_vertices;
+                vertex_remap_ptr[num_used_vertices++] = index;
+            }
+        }
+    }
+    *new_num_vertices = num_used_vertices;
+    for (i = 0; i < This->numvertices; i++) {
+        if (old_to_new[i] != -1)
+            continue;
+        if (compact) {
+            vertex_remap_ptr[num_used_vertices++] = -1;
+        } else {
+            old_to_new[i] = num_used_vertices;
+            vertex_remap_ptr[num_used_vertices++] = i;
+            *new_num_vertices = num_used_vertices;
+        }
+    }
+
+    /* convert indices */
+    for (i = 0; i < This->numfaces * 3; i++)
+        indices[i] = old_to_new[indices[i]];
+
+    HeapFree(GetProcessHeap(), 0, old_to_new);
+    HeapFree(GetProcessHeap(), 0, new_faces);
+    return D3D_OK;
+}
+
 static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags, const DWORD *adjacency_in,
         DWORD *adjacency_out, DWORD *face_remap_out, ID3DXBuffer **vertex_remap_out)
 {
@@ -1660,14 +1964,14 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
     if ((flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER)) == (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
         return D3DERR_INVALIDCALL;
 
-    if (flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
+    if (flags & D3DXMESHOPT_STRIPREORDER)
     {
-        if (flags & D3DXMESHOPT_VERTEXCACHE)
-            FIXME("D3DXMESHOPT_VERTEXCACHE not implemented.\n");
-        if (flags & D3DXMESHOPT_STRIPREORDER)
-            FIXME("D3DXMESHOPT_STRIPREORDER not implemented.\n");
+        FIXME("D3DXMESHOPT_STRIPREORDER not implemented.\n");
         return E_NOTIMPL;
     }
+    /* The faces are only reordered for the vertex cache within attribute ranges. */
+    if (flags & D3DXMESHOPT_VERTEXCACHE)
+        flags |= D3DXMESHOPT_ATTRSORT;
 
     hr = iface->lpVtbl->LockIndexBuffer(iface, 0, &indices);
     if (FAILED(hr)) goto cleanup;
@@ -1688,7 +1992,7 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
         hr = compact_mesh(This, dword_indices, &new_num_vertices, &vertex_remap);
         if (FAILED(hr)) goto cleanup;
     } else if (flags & D3DXMESHOPT_ATTRSORT) {
-        if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+        if (!(flags & (D3DXMESHOPT_IGNOREVERTS | D3DXMESHOPT_VERTEXCACHE)))
             FIXME("D3DXMESHOPT_ATTRSORT vertex reordering not implemented.\n");
 
         hr = iface->lpVtbl->LockAttributeBuffer(iface, 0, &attrib_buffer);
@@ -1696,6 +2000,20 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
 
         hr = remap_faces_for_attrsort(This, dword_indices, attrib_buffer, &sorted_attrib_buffer, &face_remap);
         if (FAILED(hr)) goto cleanup;
+
+        if (flags & D3DXMESHOPT_VERTEXCACHE)
+        {
+            hr = remap_faces_for_vertex_cache(This, dword_indices, sorted_attrib_buffer, face_remap);
+            if (FAILED(hr)) goto cleanup;
+
+            if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+            {
+                new_num_alloc_vertices = This->numvertices;
+                hr = remap_vertices_for_vertex_cache(This, dword_indices, face_remap,
+                        flags & D3DXMESHOPT_COMPACT, &new_num_vertices, &vertex_remap);
+                if (FAILED(hr)) goto cleanup;
+            }
+        }
     }
 
     if (vertex_remap)
@@ -1785,12 +2103,9 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
 
     if (adjacency_out) {
         if (face_remap) {
-            for (i = 0; i < This->numfaces; i++) {
-                DWORD old_pos = i * 3;
-                DWORD new_pos = face_remap[i] * 3;
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
+            for (i = 0; i < This->numfaces * 3; i++) {
+                DWORD adjacent_face = adjacency_in[i];
+                adjacency_out[face_remap[i / 3] * 3 + i % 3] = adjacent_face == -1 ? -1 : face_remap[adjacent_face];
             }
         } else {
             memcpy(adjacency_out, adjacency_in, This->numfaces * 3 * sizeof(*adjacency_out));
@@ -33,6 +33,17 @@ struct bone
     FLOAT *weights;
 };
 
+/* The bone influences, grouped by vertex. The influences of vertex i are
+ * stored from offsets[i] to offsets[i + 1], in bone order. They are built
+ * when the mesh is first skinned, and freed when the influences change.
+ * The arrays are allocated in the same block, right after the structure. */
+struct skin_influences
+{
+    DWORD *offsets;
+    DWORD *bones;
+    FLOAT *weights;
+};
+
 struct d3dx9_skin_info
 {
     ID3DXSkinInfo ID3DXSkinInfo_iface;
@@ -43,6 +54,7 @@ struct d3dx9_skin_info
     DWORD num_vertices;
     DWORD num_bones;
     struct bone *bones;
+    struct skin_influences *influences;
 };
 
 static inline struct d3dx9_skin_info *impl_from_ID3DXSkinInfo(ID3DXSkinInfo *iface)
@@ -50,6 +62,11 @@ static inline struct d3dx9_skin_info *impl_from_ID3DXSkinInfo(ID3DXSkinInfo *ifa
     return CONTAINING_RECORD(iface, struct d3dx9_skin_info, ID3DXSkinInfo_iface);
 }
 
+static void free_skin_influences(struct d3dx9_skin_info *skin)
+{
+    HeapFree(GetProcessHeap(), 0, InterlockedExchangePointer((void **)&skin->influences, NULL));
+}
+
 static HRESULT WINAPI d3dx9_skin_info_QueryInterface(ID3DXSkinInfo *iface, REFIID riid, void **out)
 {
     TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
@@ -94,6 +111,7 @@ static ULONG WINAPI d3dx9_skin_info_Release(ID3DXSkinInfo *iface)
             HeapFree(GetProcessHeap(), 0, skin->bones[i].weights);
         }
         HeapFree(GetProcessHeap(), 0, skin->bones);
+        free_skin_influences(skin);
         HeapFree(GetProcessHeap(), 0, skin);
     }
 
@@ -132,6 +150,7 @@ static HRESULT WINAPI d3dx9_skin_info_SetBoneInfluence(ID3DXSkinInfo *iface,
     HeapFree(GetProcessHeap(), 0, bone->weights);
     bone->vertices = new_vertices;
     bone->weights = new_weights;
+    free_skin_influences(skin);
 
     return D3D_OK;
 }
@@ -373,12 +392,251 @@ static HRESULT WINAPI d3dx9_skin_info_GetDeclaration(ID3DXSkinInfo *iface,
     return D3D_OK;
 }
 
+/* Vertices are skinned in ranges on the thread pool once there are enough of
+ * them to pay for the synchronization. */
+#define SKIN_MAX_JOBS 16
+#define SKIN_MIN_JOB_VERTICES 4096
+
+/* Per-bone matrices. The normals are transformed by the inverse of the bone
+ * offset matrix first, then by the offset matrix multiplied with the bone
+ * transform. */
+struct skin_bone_matrices
+{
+    D3DXMATRIX position;
+    D3DXMATRIX normal_inverse;
+    D3DXMATRIX normal;
+};
+
+struct skin_job
+{
+    const struct skin_bone_matrices *matrices;
+    const struct skin_influences *influences;
+    const BYTE *src;
+    BYTE *dst;
+    DWORD size;
+    BOOL normals;
+    DWORD first_vertex;
+    DWORD last_vertex;
+    LONG *pending;
+    HANDLE done_event;
+};
+
+static HRESULT init_skin_influences(struct d3dx9_skin_info *skin, const struct skin_influences **out)
+{
+    struct skin_influences *influences, *prev;
+    DWORD i, j, count = 0;
+
+    if ((influences = skin->influences))
+    {
+        *out = influences;
+        return D3D_OK;
+    }
+
+    for (i = 0; i < skin->num_bones; i++)
+        count += skin->bones[i].num_influences;
+
+    influences = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*influences)
+            + (skin->num_vertices + 1) * sizeof(*influences->offsets)
+            + count * (sizeof(*influences->bones) + sizeof(*influences->weights)));
+    if (!influences)
+        return E_OUTOFMEMORY;
+    influences->offsets = (DWORD *)(influences + 1);
+    influences->bones = influences->offsets + skin->num_vertices + 1;
+    influences->weights = (FLOAT *)(influences->bones + count);
+
+    for (i = 0; i < skin->num_bones; i++)
+    {
+        for (j = 0; j < skin->bones[i].num_influences; j++)
+        {
+            DWORD vertex = skin->bones[i].vertices[j];
+
+            if (vertex < skin->num_vertices)
+                influences->offsets[vertex + 1]++;
+            else
+                WARN("Ignoring influence of bone %u on invalid vertex %u.\n", i, vertex);
+        }
+    }
+    for (i = 0; i < skin->num_vertices; i++)
+        influences->offsets[i + 1] += influences->offsets[i];
+
+    /* Use the offsets as insertion points while filling the arrays, then
+     * shift them back into place. */
+    for (i = 0; i < skin->num_bones; i++)
+    {
+        for (j = 0; j < skin->bones[i].num_influences; j++)
+        {
+            DWORD vertex = skin->bones[i].vertices[j], index;
+
+            if (vertex >= skin->num_vertices)
+                continue;
+            index = influences->offsets[vertex]++;
+            influences->bones[index] = i;
+            influences->weights[index] = skin->bones[i].weights[j];
+        }
+    }
+    for (i = skin->num_vertices; i > 0; i--)
+        influences->offsets[i] = influences->offsets[i - 1];
+    influences->offsets[0] = 0;
+
+    /* Another thread may be skinning the same mesh, keep the first result. */
+    if ((prev = InterlockedCompareExchangePointer((void **)&skin->influences, influences, NULL)))
+    {
+        HeapFree(GetProcessHeap(), 0, influences);
+        influences = prev;
+    }
+    *out = influences;
+    return D3D_OK;
+}
+
+#ifndef HAVE_D3DX_SSE
+/* The influences of each vertex are accumulated in bone order. */
+static void skin_vertices(const struct skin_job *job)
+{
+    const struct skin_influences *influences = job->influences;
+    DWORD i, j;
+
+    for (i = job->first_vertex; i < job->last_vertex; i++)
+    {
+        const D3DXVECTOR3 *position_src = (const D3DXVECTOR3 *)(job->src + job->size * i);
+        D3DXVECTOR3 *position_dest = (D3DXVECTOR3 *)(job->dst + job->size * i);
+        D3DXVECTOR3 position_sum = {0.0f, 0.0f, 0.0f}, normal_sum = {0.0f, 0.0f, 0.0f};
+
+        for (j = influences->offsets[i]; j < influences->offsets[i + 1]; j++)
+        {
+            const struct skin_bone_matrices *matrices = &job->matrices[influences->bones[j]];
+            FLOAT weight = influences->weights[j];
+            D3DXVECTOR3 position, normal;
+
+            D3DXVec3TransformCoord(&position, position_src, &matrices->position);
+            position_sum.x += weight * position.x;
+            position_sum.y += weight * position.y;
+            position_sum.z += weight * position.z;
+
+            if (job->normals)
+            {
+                D3DXVec3TransformNormal(&normal, position_src + 1, &matrices->normal_inverse);
+                D3DXVec3TransformNormal(&normal, &normal, &matrices->normal);
+                normal_sum.x += weight * normal.x;
+                normal_sum.y += weight * normal.y;
+                normal_sum.z += weight * normal.z;
+            }
+        }
+
+        *position_dest = position_sum;
+        if (job->normals)
+            position_dest[1] = normal_sum;
+    }
+}
+
+#else
+static inline d3dx_vec4 skin_splat_sse(float f)
+{
+    return (d3dx_vec4){f, f, f, f};
+}
+
+static inline d3dx_vec4 skin_transform_sse(d3dx_vec4 v, const D3DXMATRIX *m, BOOL translate)
+{
+    d3dx_vec4 r;
+
+    r = *(const d3dx_vec4_unaligned *)m->u.m[0] * skin_splat_sse(v[0])
+            + *(const d3dx_vec4_unaligned *)m->u.m[1] * skin_splat_sse(v[1])
+            + *(const d3dx_vec4_unaligned *)m->u.m[2] * skin_splat_sse(v[2]);
+    if (translate)
+        r += *(const d3dx_vec4_unaligned *)m->u.m[3];
+    return r;
+}
+
+static inline d3dx_vec4 skin_load_vec3_sse(const D3DXVECTOR3 *v)
+{
+    return (d3dx_vec4){v->x, v->y, v->z, 0.0f};
+}
+
+static inline void skin_store_vec3_sse(D3DXVECTOR3 *v, d3dx_vec4 r)
+{
+    v->x = r[0];
+    v->y = r[1];
+    v->z = r[2];
+}
+
+/* Same operations in the same order as the scalar code, for the same results. */
+static void skin_vertices(const struct skin_job *job)
+{
+    const struct skin_influences *influences = job->influences;
+    DWORD i, j;
+
+    for (i = job->first_vertex; i < job->last_vertex; i++)
+    {
+        const D3DXVECTOR3 *position_src = (const D3DXVECTOR3 *)(job->src + job->size * i);
+        D3DXVECTOR3 *position_dest = (D3DXVECTOR3 *)(job->dst + job->size * i);
+        d3dx_vec4 position_sum = skin_splat_sse(0.0f), normal_sum = skin_splat_sse(0.0f);
+        d3dx_vec4 position = skin_load_vec3_sse(position_src);
+        d3dx_vec4 normal = job->normals ? skin_load_vec3_sse(position_src + 1) : skin_splat_sse(0.0f);
+
+        for (j = influences->offsets[i]; j < influences->offsets[i + 1]; j++)
+        {
+            const struct skin_bone_matrices *matrices = &job->matrices[influences->bones[j]];
+            d3dx_vec4 weight = skin_splat_sse(influences->weights[j]), r;
+
+            r = skin_transform_sse(position, &matrices->position, TRUE);
+            r /= skin_splat_sse(r[3]);
+            position_sum += weight * r;
+
+            if (job->normals)
+            {
+                r = skin_transform_sse(normal, &matrices->normal_inverse, FALSE);
+                r = skin_transform_sse(r, &matrices->normal, FALSE);
+                normal_sum += weight * r;
+            }
+        }
+
+        skin_store_vec3_sse(position_dest, position_sum);
+        if (job->normals)
+            skin_store_vec3_sse(position_dest + 1, normal_sum);
+    }
+}
+#endif
+
+static void skin_vertex_range(const struct skin_job *job)
+{
+    DWORD i;
+
+    skin_vertices(job);
+
+    if (!job->normals)
+        return;
+
+    /* Normalize all normals that are influenced by bones */
+    for (i = job->first_vertex; i < job->last_vertex; i++)
+    {
+        D3DXVECTOR3 *normal_dest = (D3DXVECTOR3 *)(job->dst + job->size * i + sizeof(D3DXVECTOR3));
+        if ((normal_dest->x != 0.0f) && (normal_dest->y != 0.0f) && (normal_dest->z != 0.0f))
+            D3DXVec3Normalize(normal_dest, normal_dest);
+    }
+}
+
+static DWORD WINAPI skin_job_proc(void *arg)
+{
+    struct skin_job *job = arg;
+
+    skin_vertex_range(job);
+    if (!InterlockedDecrement(job->pending))
+        SetEvent(job->done_event);
+    return 0;
+}
+
 static HRESULT WINAPI d3dx9_skin_info_UpdateSkinnedMesh(ID3DXSkinInfo *iface, const D3DXMATRIX *bone_transforms,
         const D3DXMATRIX *bone_inv_transpose_transforms, const void *src_vertices, void *dst_vertices)
 {
     struct d3dx9_skin_info *skin = impl_from_ID3DXSkinInfo(iface);
     DWORD size = D3DXGetFVFVertexSize(skin->fvf);
-    DWORD i, j;
+    const struct skin_influences *influences;
+    struct skin_job jobs[SKIN_MAX_JOBS];
+    struct skin_bone_matrices *matrices;
+    HANDLE done_event = NULL;
+    DWORD i, job_count;
+    LONG pending = 0;
+    SYSTEM_INFO info;
+    HRESULT hr;
 
     TRACE("iface %p, bone_transforms %p, bone_inv_transpose_transforms %p, src_vertices %p, dst_vertices %p\n",
             skin, bone_transforms, bone_inv_transpose_transforms, src_vertices, dst_vertices);
@@ -391,72 +649,57 @@ static HRESULT WINAPI d3dx9_skin_info_UpdateSkinnedMesh(ID3DXSkinInfo *iface, co
         return E_FAIL;
     }
 
-    /* Reset all positions */
-    for (i = 0; i < skin->num_vertices; i++) {
-        D3DXVECTOR3 *position = (D3DXVECTOR3*)((BYTE*)dst_vertices + size * i);
-        position->x = 0.0f;
-        position->y = 0.0f;
-        position->z = 0.0f;
-    }
-
-    /* Update positions that are influenced by bones */
-    for (i = 0; i < skin->num_bones; i++) {
-        D3DXMATRIX bone_inverse, matrix;
-
-        D3DXMatrixInverse(&bone_inverse, NULL, &skin->bones[i].transform);
-        D3DXMatrixMultiply(&matrix, &bone_transforms[i], &bone_inverse);
-        D3DXMatrixMultiply(&matrix, &matrix, &skin->bones[i].transform);
+    if (FAILED(hr = init_skin_influences(skin, &influences)))
+        return hr;
+    matrices = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, max(skin->num_bones, 1) * sizeof(*matrices));
+    if (!matrices)
+        return E_OUTOFMEMORY;
 
-        for (j = 0; j < skin->bones[i].num_influences; j++) {
-            D3DXVECTOR3 position;
-            D3DXVECTOR3 *position_src = (D3DXVECTOR3*)((BYTE*)src_vertices + size * skin->bones[i].vertices[j]);
-            D3DXVECTOR3 *position_dest = (D3DXVECTOR3*)((BYTE*)dst_vertices + size * skin->bones[i].vertices[j]);
-            FLOAT weight = skin->bones[i].weights[j];
+    for (i = 0; i < skin->num_bones; i++)
+    {
+        D3DXMATRIX *bone_inverse = &matrices[i].normal_inverse;
 
-            D3DXVec3TransformCoord(&position, position_src, &matrix);
-            position_dest->x += weight * position.x;
-            position_dest->y += weight * position.y;
-            position_dest->z += weight * position.z;
-        }
+        D3DXMatrixInverse(bone_inverse, NULL, &skin->bones[i].transform);
+        D3DXMatrixMultiply(&matrices[i].position, &bone_transforms[i], bone_inverse);
+        D3DXMatrixMultiply(&matrices[i].position, &matrices[i].position, &skin->bones[i].transform);
+        D3DXMatrixMultiply(&matrices[i].normal, &skin->bones[i].transform, &bone_transforms[i]);
     }
 
-    if (skin->fvf & D3DFVF_NORMAL) {
-        /* Reset all normals */
-        for (i = 0; i < skin->num_vertices; i++) {
-            D3DXVECTOR3 *normal = (D3DXVECTOR3*)((BYTE*)dst_vertices + size * i + sizeof(D3DXVECTOR3));
-            normal->x = 0.0f;
-            normal->y = 0.0f;
-            normal->z = 0.0f;
-        }
-
-        /* Update normals that are influenced by bones */
-        for (i = 0; i < skin->num_bones; i++) {
-            D3DXMATRIX bone_inverse, matrix;
-
-            D3DXMatrixInverse(&bone_inverse, NULL, &skin->bones[i].transform);
-            D3DXMatrixMultiply(&matrix, &skin->bones[i].transform, &bone_transforms[i]);
-
-            for (j = 0; j < skin->bones[i].num_influences; j++) {
-                D3DXVECTOR3 normal;
-                D3DXVECTOR3 *normal_src = (D3DXVECTOR3*)((BYTE*)src_vertices + size * skin->bones[i].vertices[j] + sizeof(D3DXVECTOR3));
-                D3DXVECTOR3 *normal_dest = (D3DXVECTOR3*)((BYTE*)dst_vertices + size * skin->bones[i].vertices[j] + sizeof(D3DXVECTOR3));
-                FLOAT weight = skin->bones[i].weights[j];
+    GetSystemInfo(&info);
+    job_count = min(info.dwNumberOfProcessors, SKIN_MAX_JOBS);
+    job_count = min(job_count, skin->num_vertices / SKIN_MIN_JOB_VERTICES);
+    job_count = max(job_count, 1);
+    if (job_count > 1 && !(done_event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        job_count = 1;
 
-                D3DXVec3TransformNormal(&normal, normal_src, &bone_inverse);
-                D3DXVec3TransformNormal(&normal, &normal, &matrix);
-                normal_dest->x += weight * normal.x;
-                normal_dest->y += weight * normal.y;
-                normal_dest->z += weight * normal.z;
-            }
-        }
+    for (i = 0; i < job_count; i++)
+    {
+        jobs[i].matrices = matrices;
+        jobs[i].influences = influences;
+        jobs[i].src = src_vertices;
+        jobs[i].dst = dst_vertices;
+        jobs[i].size = size;
+        jobs[i].normals = !!(skin->fvf & D3DFVF_NORMAL);
+        jobs[i].first_vertex = (UINT64)skin->num_vertices * i / job_count;
+        jobs[i].last_vertex = (UINT64)skin->num_vertices * (i + 1) / job_count;
+        jobs[i].pending = &pending;
+        jobs[i].done_event = done_event;
+    }
 
-        /* Normalize all normals that are influenced by bones*/
-        for (i = 0; i < skin->num_vertices; i++) {
-            D3DXVECTOR3 *normal_dest = (D3DXVECTOR3*)((BYTE*)dst_vertices + (i * size) + sizeof(D3DXVECTOR3));
-            if ((normal_dest->x != 0.0f) && (normal_dest->y != 0.0f) && (normal_dest->z != 0.0f))
-                D3DXVec3Normalize(normal_dest, normal_dest);
-        }
+    pending = job_count - 1;
+    for (i = 1; i < job_count; i++)
+    {
+        if (!QueueUserWorkItem(skin_job_proc, &jobs[i], WT_EXECUTEDEFAULT))
+            skin_job_proc(&jobs[i]);
     }
+    skin_vertex_range(&jobs[0]);
+    if (done_event)
+    {
+        WaitForSingleObject(done_event, INFINITE);
+        CloseHandle(done_event);
+    }
+
+    HeapFree(GetProcessHeap(), 0, matrices);
 
     return D3D_OK;
 }
@@ -541,6 +784,7 @@ HRESULT WINAPI D3DXCreateSkinInfo(DWORD num_vertices, const D3DVERTEXELEMENT9 *d
     object->num_bones = num_bones;
     object->vertex_declaration[0] = empty_declaration;
     object->fvf = 0;
+    memset(&object->influences, 0, sizeof(object->influences));
 
     object->bones = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, num_bones * sizeof(*object->bones));
     if (!object->bones) {
@@ -1924,6 +1924,399 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     }
 }
 
+/* Source contributions to each destination position along one axis. The taps
+ * of position i are stored from offsets[i] to offsets[i + 1] - 1. */
+struct filter_axis
+{
+    unsigned int *offsets;
+    unsigned int *indices;
+    float *weights;
+    unsigned int max_taps;
+};
+
+struct filter_context
+{
+    const BYTE *src;
+    UINT src_row_pitch, src_slice_pitch;
+    const struct volume *src_size;
+    const struct pixel_format_desc *src_format;
+    BYTE *dst;
+    UINT dst_row_pitch, dst_slice_pitch;
+    const struct volume *dst_size;
+    const struct pixel_format_desc *dst_format;
+    const struct pixel_format_desc *ck_format;
+    D3DCOLOR color_key;
+    const PALETTEENTRY *palette;
+    struct filter_axis axes[3];
+    unsigned int cache_rows;
+};
+
+/* A range of destination rows, counted across all the slices. Each band keeps
+ * its own cache of horizontally filtered source rows. */
+struct filter_band
+{
+    const struct filter_context *ctx;
+    unsigned int first_row, last_row;
+    struct vec4 *src_row;
+    struct vec4 *accum;
+    struct vec4 *cache;
+    unsigned int *cache_tags;
+    LONG *pending;
+    HANDLE done_event;
+};
+
+#define FILTER_MAX_CACHE_ROWS 64
+#define FILTER_MAX_BANDS 16
+#define FILTER_MIN_BAND_PIXELS (64 * 1024)
+
+/* map a source coordinate outside of the image according to the addressing mode */
+static unsigned int filter_address(int i, unsigned int size, BOOL mirror)
+{
+    int n = size;
+
+    if (mirror)
+    {
+        i %= 2 * n;
+        if (i < 0)
+            i += 2 * n;
+        return i < n ? i : 2 * n - 1 - i;
+    }
+    i %= n;
+    return i < 0 ? i + n : i;
+}
+
+static void free_filter_axis(struct filter_axis *axis)
+{
+    heap_free(axis->offsets);
+    heap_free(axis->indices);
+    heap_free(axis->weights);
+}
+
+static BOOL init_filter_axis(struct filter_axis *axis, unsigned int src_size, unsigned int dst_size,
+        DWORD filter, BOOL mirror)
+{
+    float scale = (float)src_size / dst_size, radius = max(scale, 1.0f);
+    unsigned int i, k, first, count = 0, max_count = (unsigned int)ceilf(2.0f * radius) + 3;
+
+    axis->offsets = heap_alloc((dst_size + 1) * sizeof(*axis->offsets));
+    axis->indices = heap_alloc(dst_size * max_count * sizeof(*axis->indices));
+    axis->weights = heap_alloc(dst_size * max_count * sizeof(*axis->weights));
+    axis->max_taps = 0;
+    if (!axis->offsets || !axis->indices || !axis->weights)
+    {
+        free_filter_axis(axis);
+        return FALSE;
+    }
+
+    for (i = 0; i < dst_size; ++i)
+    {
+        float start = 0.0f, end = 0.0f, center = 0.0f, total = 0.0f;
+        int j, j0, j1;
+
+        switch (filter & 0xf)
+        {
+            case D3DX_FILTER_LINEAR:
+                center = (i + 0.5f) * scale - 0.5f;
+                j0 = floorf(center);
+                j1 = j0 + 1;
+                break;
+
+            case D3DX_FILTER_TRIANGLE:
+                center = (i + 0.5f) * scale;
+                j0 = floorf(center - radius);
+                j1 = ceilf(center + radius);
+                break;
+
+            default: /* D3DX_FILTER_BOX */
+                start = i * scale;
+                end = (i + 1) * scale;
+                j0 = floorf(start);
+                j1 = min((int)ceilf(end) - 1, (int)src_size - 1);
+                break;
+        }
+
+        axis->offsets[i] = first = count;
+        for (j = j0; j <= j1; ++j)
+        {
+            float w;
+
+            switch (filter & 0xf)
+            {
+                case D3DX_FILTER_LINEAR:
+                    w = 1.0f - fabsf(j - center);
+                    break;
+
+                case D3DX_FILTER_TRIANGLE:
+                    w = 1.0f - fabsf(j + 0.5f - center) / radius;
+                    break;
+
+                default:
+                    w = min(end, j + 1.0f) - max(start, (float)j);
+                    break;
+            }
+            if (w <= 0.0f)
+                continue;
+
+            axis->indices[count] = filter_address(j, src_size, mirror);
+            axis->weights[count++] = w;
+            total += w;
+        }
+
+        if (count == first)
+        {
+            axis->indices[count] = min(i * src_size / dst_size, src_size - 1);
+            axis->weights[count++] = total = 1.0f;
+        }
+        for (k = first; k < count; ++k)
+            axis->weights[k] /= total;
+        axis->max_taps = max(axis->max_taps, count - first);
+    }
+    axis->offsets[dst_size] = count;
+
+    return TRUE;
+}
+
+/* Return the source row y of slice z, converted to RGBA and filtered horizontally. */
+static const struct vec4 *get_filtered_row(struct filter_band *band, unsigned int z, unsigned int y)
+{
+    const struct filter_context *ctx = band->ctx;
+    const struct filter_axis *axis = &ctx->axes[0];
+    unsigned int id = z * ctx->src_size->height + y, slot = id % ctx->cache_rows;
+    struct vec4 *row = band->cache + slot * ctx->dst_size->width;
+    const BYTE *src_ptr;
+    unsigned int x, k;
+
+    if (band->cache_tags[slot] == id)
+        return row;
+    band->cache_tags[slot] = id;
+
+    src_ptr = ctx->src + z * ctx->src_slice_pitch + y * ctx->src_row_pitch;
+    for (x = 0; x < ctx->src_size->width; ++x)
+    {
+        struct vec4 color;
+
+        format_to_vec4(ctx->src_format, src_ptr, &color);
+        if (ctx->src_format->to_rgba)
+            ctx->src_format->to_rgba(&color, &band->src_row[x], ctx->palette);
+        else
+            band->src_row[x] = color;
+
+        if (ctx->ck_format)
+        {
+            DWORD ck_pixel;
+
+            format_from_vec4(ctx->ck_format, &band->src_row[x], (BYTE *)&ck_pixel);
+            if (ck_pixel == ctx->color_key)
+                band->src_row[x].w = 0.0f;
+        }
+        src_ptr += ctx->src_format->bytes_per_pixel;
+    }
+
+    for (x = 0; x < ctx->dst_size->width; ++x)
+    {
+        struct vec4 sum = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        for (k = axis->offsets[x]; k < axis->offsets[x + 1]; ++k)
+        {
+            const struct vec4 *color = &band->src_row[axis->indices[k]];
+            float w = axis->weights[k];
+
+            sum.x += color->x * w;
+            sum.y += color->y * w;
+            sum.z += color->z * w;
+            sum.w += color->w * w;
+        }
+        row[x] = sum;
+    }
+
+    return row;
+}
+
+static void filter_band_rows(struct filter_band *band)
+{
+    const struct filter_context *ctx = band->ctx;
+    const struct filter_axis *axis_y = &ctx->axes[1], *axis_z = &ctx->axes[2];
+    unsigned int row, x, ky, kz, width = ctx->dst_size->width;
+
+    for (row = band->first_row; row < band->last_row; ++row)
+    {
+        unsigned int z = row / ctx->dst_size->height, y = row % ctx->dst_size->height;
+        BYTE *dst_ptr = ctx->dst + z * ctx->dst_slice_pitch + y * ctx->dst_row_pitch;
+
+        memset(band->accum, 0, width * sizeof(*band->accum));
+        for (kz = axis_z->offsets[z]; kz < axis_z->offsets[z + 1]; ++kz)
+        {
+            for (ky = axis_y->offsets[y]; ky < axis_y->offsets[y + 1]; ++ky)
+            {
+                const struct vec4 *src_row = get_filtered_row(band, axis_z->indices[kz], axis_y->indices[ky]);
+                float w = axis_z->weights[kz] * axis_y->weights[ky];
+
+                for (x = 0; x < width; ++x)
+                {
+                    band->accum[x].x += src_row[x].x * w;
+                    band->accum[x].y += src_row[x].y * w;
+                    band->accum[x].z += src_row[x].z * w;
+                    band->accum[x].w += src_row[x].w * w;
+                }
+            }
+        }
+
+        for (x = 0; x < width; ++x)
+        {
+            struct vec4 color;
+
+            if (ctx->dst_format->from_rgba)
+                ctx->dst_format->from_rgba(&band->accum[x], &color);
+            else
+                color = band->accum[x];
+
+            format_from_vec4(ctx->dst_format, &color, dst_ptr);
+            dst_ptr += ctx->dst_format->bytes_per_pixel;
+        }
+    }
+}
+
+static DWORD WINAPI filter_band_proc(void *arg)
+{
+    struct filter_band *band = arg;
+
+    filter_band_rows(band);
+    if (!InterlockedDecrement(band->pending))
+        SetEvent(band->done_event);
+    return 0;
+}
+
+static void free_filter_band(struct filter_band *band)
+{
+    heap_free(band->src_row);
+    heap_free(band->accum);
+    heap_free(band->cache);
+    heap_free(band->cache_tags);
+}
+
+static BOOL init_filter_band(struct filter_band *band, const struct filter_context *ctx)
+{
+    unsigned int width = ctx->dst_size->width;
+
+    band->ctx = ctx;
+    band->src_row = heap_alloc(ctx->src_size->width * sizeof(*band->src_row));
+    band->accum = heap_alloc(width * sizeof(*band->accum));
+    band->cache = heap_alloc(ctx->cache_rows * width * sizeof(*band->cache));
+    band->cache_tags = heap_alloc(ctx->cache_rows * sizeof(*band->cache_tags));
+    if (!band->src_row || !band->accum || !band->cache || !band->cache_tags)
+    {
+        free_filter_band(band);
+        return FALSE;
+    }
+    memset(band->cache_tags, 0xff, ctx->cache_rows * sizeof(*band->cache_tags));
+
+    return TRUE;
+}
+
+/************************************************************
+ * filter_argb_pixels
+ *
+ * Resamples the source buffer into the destination buffer with the
+ * D3DX_FILTER_LINEAR, D3DX_FILTER_TRIANGLE or D3DX_FILTER_BOX filter.
+ * The image is processed one axis at a time; large images are split
+ * into bands of rows which are filtered on the thread pool.
+ * Falls back to point filtering if memory can't be allocated.
+ */
+void filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch, const struct volume *src_size,
+        const struct pixel_format_desc *src_format, BYTE *dst, UINT dst_row_pitch, UINT dst_slice_pitch,
+        const struct volume *dst_size, const struct pixel_format_desc *dst_format, D3DCOLOR color_key,
+        const PALETTEENTRY *palette, DWORD filter)
+{
+    static const DWORD mirror_flags[3] = {D3DX_FILTER_MIRROR_U, D3DX_FILTER_MIRROR_V, D3DX_FILTER_MIRROR_W};
+    const UINT src_dims[3] = {src_size->width, src_size->height, src_size->depth};
+    const UINT dst_dims[3] = {dst_size->width, dst_size->height, dst_size->depth};
+    unsigned int i, band_count, total_rows, axis_count = 0;
+    struct filter_band bands[FILTER_MAX_BANDS];
+    struct filter_context ctx;
+    HANDLE done_event = NULL;
+    LONG pending = 0;
+    SYSTEM_INFO info;
+
+    TRACE("Filtering %ux%ux%u to %ux%ux%u, filter %#x.\n", src_size->width, src_size->height, src_size->depth,
+            dst_size->width, dst_size->height, dst_size->depth, filter);
+
+    ctx.src = src;
+    ctx.src_row_pitch = src_row_pitch;
+    ctx.src_slice_pitch = src_slice_pitch;
+    ctx.src_size = src_size;
+    ctx.src_format = src_format;
+    ctx.dst = dst;
+    ctx.dst_row_pitch = dst_row_pitch;
+    ctx.dst_slice_pitch = dst_slice_pitch;
+    ctx.dst_size = dst_size;
+    ctx.dst_format = dst_format;
+    /* Color keys are always represented in D3DFMT_A8R8G8B8 format. */
+    ctx.ck_format = color_key ? get_format_info(D3DFMT_A8R8G8B8) : NULL;
+    ctx.color_key = color_key;
+    ctx.palette = palette;
+
+    for (; axis_count < 3; ++axis_count)
+    {
+        if (!init_filter_axis(&ctx.axes[axis_count], src_dims[axis_count], dst_dims[axis_count],
+                filter, !!(filter & mirror_flags[axis_count])))
+            goto fallback;
+    }
+    ctx.cache_rows = min(ctx.axes[1].max_taps * ctx.axes[2].max_taps, FILTER_MAX_CACHE_ROWS);
+
+    total_rows = dst_size->height * dst_size->depth;
+    GetSystemInfo(&info);
+    band_count = min(info.dwNumberOfProcessors, FILTER_MAX_BANDS);
+    band_count = min(band_count, (UINT64)dst_size->width * total_rows / FILTER_MIN_BAND_PIXELS);
+    band_count = max(min(band_count, total_rows), 1);
+
+    for (i = 0; i < band_count; ++i)
+    {
+        if (!init_filter_band(&bands[i], &ctx))
+            break;
+        bands[i].pending = &pending;
+    }
+    if (!(band_count = i))
+        goto fallback;
+    if (band_count > 1 && !(done_event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        while (band_count > 1)
+            free_filter_band(&bands[--band_count]);
+    }
+
+    for (i = 0; i < band_count; ++i)
+    {
+        bands[i].first_row = total_rows * i / band_count;
+        bands[i].last_row = total_rows * (i + 1) / band_count;
+        bands[i].done_event = done_event;
+    }
+
+    pending = band_count - 1;
+    for (i = 1; i < band_count; ++i)
+    {
+        if (!QueueUserWorkItem(filter_band_proc, &bands[i], WT_EXECUTEDEFAULT))
+            filter_band_proc(&bands[i]);
+    }
+    filter_band_rows(&bands[0]);
+    if (done_event)
+    {
+        WaitForSingleObject(done_event, INFINITE);
+        CloseHandle(done_event);
+    }
+
+    for (i = 0; i < band_count; ++i)
+        free_filter_band(&bands[i]);
+    for (i = 0; i < 3; ++i)
+        free_filter_axis(&ctx.axes[i]);
+    return;
+
+fallback:
+    WARN("Failed to allocate memory, using a point filter.\n");
+    for (i = 0; i < axis_count; ++i)
+        free_filter_axis(&ctx.axes[i]);
+    point_filter_argb_pixels(src, src_row_pitch, src_slice_pitch, src_size, src_format,
+            dst, dst_row_pitch, dst_slice_pitch, dst_size, dst_format, color_key, palette);
+}
+
 /************************************************************
  * D3DXLoadSurfaceFromMemory
  *
@@ -2160,16 +2553,21 @@ HRESULT WINAPI D3DXLoadSurfaceFromMemory(IDirect3DSurface9 *dst_surface,
             convert_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
                     dst_mem, dst_pitch, 0, &dst_size, dst_format, color_key, src_palette);
         }
-        else /* if ((filter & 0xf) == D3DX_FILTER_POINT) */
+        else if ((filter & 0xf) == D3DX_FILTER_POINT || (filter & 0xf) > D3DX_FILTER_BOX
+                || (src_size.width == dst_size.width && src_size.height == dst_size.height))
         {
-            if ((filter & 0xf) != D3DX_FILTER_POINT)
+            if ((filter & 0xf) > D3DX_FILTER_BOX)
                 FIXME("Unhandled filter %#x.\n", filter);
 
-            /* Always apply a point filter until D3DX_FILTER_LINEAR,
-             * D3DX_FILTER_TRIANGLE and D3DX_FILTER_BOX are implemented. */
+            /* Without resizing, the point filter gives the same result. */
             point_filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
                     dst_mem, dst_pitch, 0, &dst_size, dst_format, color_key, src_palette);
         }
+        else
+        {
+            filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
+                    dst_mem, dst_pitch, 0, &dst_size, dst_format, color_key, src_palette, filter);
+        }
 
         heap_free(src_uncompressed);
 
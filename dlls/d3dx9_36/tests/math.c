@@ -3200,6 +3200,85 @@ static void test_D3DXVec_Array(void)
     }
 }
 
+static void test_D3DXVec_Array_large(void)
+{
+    static const unsigned int count = 4096;
+    D3DXVECTOR4 *out4, *exp4, *in4;
+    D3DXVECTOR3 *out3, *exp3, *in3;
+    D3DXMATRIX mat, mat2, out_mat, exp_mat;
+    unsigned int i;
+
+    in3 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*in3));
+    out3 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*out3));
+    exp3 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*exp3));
+    in4 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*in4));
+    out4 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*out4));
+    exp4 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*exp4));
+
+    /* Positive values only, to avoid cancellation in the sums. The products and sums
+     * are exact, so the array functions must match the single-vector ones exactly. */
+    for (i = 0; i < count; ++i)
+    {
+        in3[i].x = in4[i].x = (i % 17) * 0.25f;
+        in3[i].y = in4[i].y = (i % 29) * 0.5f;
+        in3[i].z = in4[i].z = (i % 31) * 0.125f + 1.0f;
+        in4[i].w = (i % 7) * 0.75f + 0.5f;
+    }
+    set_matrix(&mat,
+            1.0f, 2.0f, 3.0f, 4.0f,
+            5.0f, 6.0f, 7.0f, 8.0f,
+            9.0f, 10.0f, 11.0f, 12.0f,
+            13.0f, 14.0f, 15.0f, 16.0f);
+    set_matrix(&mat2,
+            0.5f, 0.25f, 1.5f, 2.0f,
+            3.0f, 0.75f, 1.25f, 0.5f,
+            2.5f, 1.0f, 0.125f, 4.0f,
+            1.0f, 2.0f, 3.0f, 0.25f);
+
+    D3DXMatrixMultiply(&out_mat, &mat, &mat2);
+    set_matrix(&exp_mat,
+            18.0f, 12.75f, 16.375f, 16.0f,
+            46.0f, 28.75f, 39.875f, 43.0f,
+            74.0f, 44.75f, 63.375f, 70.0f,
+            102.0f, 60.75f, 86.875f, 97.0f);
+    expect_matrix(&exp_mat, &out_mat, 0);
+    out_mat = mat;
+    D3DXMatrixMultiply(&out_mat, &out_mat, &mat2);
+    expect_matrix(&exp_mat, &out_mat, 0);
+    D3DXMatrixMultiplyTranspose(&out_mat, &mat, &mat2);
+    D3DXMatrixTranspose(&exp_mat, &exp_mat);
+    expect_matrix(&exp_mat, &out_mat, 0);
+
+    for (i = 0; i < count; ++i)
+        D3DXVec3TransformCoord(&exp3[i], &in3[i], &mat);
+    D3DXVec3TransformCoordArray(out3, sizeof(*out3), in3, sizeof(*in3), &mat, count);
+    for (i = 0; i < count; ++i)
+        expect_vec3(&exp3[i], &out3[i], 0);
+
+    for (i = 0; i < count; ++i)
+        D3DXVec3Transform(&exp4[i], &in3[i], &mat);
+    D3DXVec3TransformArray(out4, sizeof(*out4), in3, sizeof(*in3), &mat, count);
+    for (i = 0; i < count; ++i)
+        expect_vec4(&exp4[i], &out4[i], 0);
+    /* Unaligned destination. */
+    D3DXVec3TransformArray((D3DXVECTOR4 *)&out4[0].y, sizeof(*out4), in3, sizeof(*in3), &mat, count - 1);
+    for (i = 0; i < count - 1; ++i)
+        expect_vec4(&exp4[i], (D3DXVECTOR4 *)&out4[i].y, 0);
+
+    for (i = 0; i < count; ++i)
+        D3DXVec4Transform(&exp4[i], &in4[i], &mat);
+    D3DXVec4TransformArray(out4, sizeof(*out4), in4, sizeof(*in4), &mat, count);
+    for (i = 0; i < count; ++i)
+        expect_vec4(&exp4[i], &out4[i], 0);
+
+    HeapFree(GetProcessHeap(), 0, in3);
+    HeapFree(GetProcessHeap(), 0, out3);
+    HeapFree(GetProcessHeap(), 0, exp3);
+    HeapFree(GetProcessHeap(), 0, in4);
+    HeapFree(GetProcessHeap(), 0, out4);
+    HeapFree(GetProcessHeap(), 0, exp4);
+}
+
 static void test_D3DXFloat_Array(void)
 {
     unsigned int i;
@@ -4379,6 +4458,7 @@ START_TEST(math)
     test_Matrix_Decompose();
     test_Matrix_Transformation2D();
     test_D3DXVec_Array();
+    test_D3DXVec_Array_large();
     test_D3DXFloat_Array();
     test_D3DXSHAdd();
     test_D3DXSHDot();
@@ -5275,6 +5275,122 @@ static void test_update_skinned_mesh(void)
     skin_info->lpVtbl->Release(skin_info);
 }
 
+/* Blend a vertex transformed by two bones, the bone offsets being identity matrices. */
+static void get_skinned_vertex(struct vertex *out, const struct vertex *in, const D3DXMATRIX *matrix0,
+        float weight0, const D3DXMATRIX *matrix1, float weight1)
+{
+    D3DXVECTOR3 position0, position1, normal0, normal1;
+
+    D3DXVec3TransformCoord(&position0, &in->position, matrix0);
+    D3DXVec3TransformCoord(&position1, &in->position, matrix1);
+    D3DXVec3TransformNormal(&normal0, &in->normal, matrix0);
+    D3DXVec3TransformNormal(&normal1, &in->normal, matrix1);
+    out->position.x = weight0 * position0.x + weight1 * position1.x;
+    out->position.y = weight0 * position0.y + weight1 * position1.y;
+    out->position.z = weight0 * position0.z + weight1 * position1.z;
+    out->normal.x = weight0 * normal0.x + weight1 * normal1.x;
+    out->normal.y = weight0 * normal0.y + weight1 * normal1.y;
+    out->normal.z = weight0 * normal0.z + weight1 * normal1.z;
+}
+
+static void test_update_skinned_mesh_large(void)
+{
+    static const DWORD num_vertices = 65536, num_bones = 8;
+    static const D3DXVECTOR3 normal = {0.48f, 0.6f, 0.64f};
+    struct vertex *src, *dst, expect;
+    ID3DXSkinInfo *skin_info;
+    D3DXMATRIX *matrices, rotation;
+    DWORD *vertices;
+    FLOAT *weights;
+    DWORD i, j;
+    HRESULT hr;
+
+    hr = D3DXCreateSkinInfoFVF(num_vertices, D3DFVF_XYZ | D3DFVF_NORMAL, num_bones, &skin_info);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    src = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*src));
+    dst = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*dst));
+    vertices = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*vertices));
+    weights = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*weights));
+    matrices = HeapAlloc(GetProcessHeap(), 0, num_bones * sizeof(*matrices));
+
+    for (i = 0; i < num_vertices; i++)
+    {
+        src[i].position.x = (i % 17) * 0.25f;
+        src[i].position.y = (i % 29) * 0.5f;
+        src[i].position.z = (i % 31) * 0.125f;
+        src[i].normal = normal;
+    }
+
+    /* Vertex i is influenced by bone i % num_bones with a weight of 0.25, and
+     * by the next bone with a weight of 0.75. */
+    for (i = 0; i < num_bones; i++)
+    {
+        DWORD count = 0;
+
+        for (j = 0; j < num_vertices; j++)
+        {
+            if (j % num_bones == i)
+            {
+                vertices[count] = j;
+                weights[count++] = 0.25f;
+            }
+            else if ((j + 1) % num_bones == i)
+            {
+                vertices[count] = j;
+                weights[count++] = 0.75f;
+            }
+        }
+        hr = skin_info->lpVtbl->SetBoneInfluence(skin_info, i, count, vertices, weights);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        D3DXMatrixIdentity(&matrices[i]);
+        hr = skin_info->lpVtbl->SetBoneOffsetMatrix(skin_info, i, &matrices[i]);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        /* Each bone rotates the mesh differently, so that the normals change too. */
+        D3DXMatrixRotationYawPitchRoll(&rotation, i * 0.25f, i * 0.125f, i * -0.5f);
+        D3DXMatrixTranslation(&matrices[i], i * 1.0f, i * 2.0f, i * -1.0f);
+        D3DXMatrixMultiply(&matrices[i], &rotation, &matrices[i]);
+    }
+
+    hr = skin_info->lpVtbl->UpdateSkinnedMesh(skin_info, matrices, NULL, src, dst);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    for (i = 0; i < num_vertices; i++)
+    {
+        DWORD bone0 = i % num_bones, bone1 = (i + 1) % num_bones;
+
+        get_skinned_vertex(&expect, &src[i], &matrices[bone0], 0.25f, &matrices[bone1], 0.75f);
+        if (!compare_vec3(dst[i].position, expect.position) || !compare_vec3(dst[i].normal, expect.normal))
+            break;
+    }
+    ok(i == num_vertices, "Vertex %u doesn't match.\n", i);
+    /* Vertex 1 is only rotated by bones 1 and 2. */
+    ok(!compare_vec3(dst[1].normal, normal), "Got unexpected normal {%.8e, %.8e, %.8e}.\n",
+            dst[1].normal.x, dst[1].normal.y, dst[1].normal.z);
+
+    /* Changing the influences after skinning the mesh once. */
+    hr = skin_info->lpVtbl->SetBoneInfluence(skin_info, 0, 0, vertices, weights);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    hr = skin_info->lpVtbl->UpdateSkinnedMesh(skin_info, matrices, NULL, src, dst);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    for (i = 0; i < num_vertices; i++)
+    {
+        DWORD bone0 = i % num_bones, bone1 = (i + 1) % num_bones;
+        float weight0 = bone0 ? 0.25f : 0.0f, weight1 = bone1 ? 0.75f : 0.0f;
+
+        get_skinned_vertex(&expect, &src[i], &matrices[bone0], weight0, &matrices[bone1], weight1);
+        if (!compare_vec3(dst[i].position, expect.position) || !compare_vec3(dst[i].normal, expect.normal))
+            break;
+    }
+    ok(i == num_vertices, "Vertex %u doesn't match.\n", i);
+
+    HeapFree(GetProcessHeap(), 0, matrices);
+    HeapFree(GetProcessHeap(), 0, weights);
+    HeapFree(GetProcessHeap(), 0, vertices);
+    HeapFree(GetProcessHeap(), 0, dst);
+    HeapFree(GetProcessHeap(), 0, src);
+    skin_info->lpVtbl->Release(skin_info);
+}
+
 static void test_convert_adjacency_to_point_reps(void)
 {
     HRESULT hr;
@@ -10725,6 +10841,150 @@ static HRESULT compute_normals_D3DXComputeTangentFrameEx(ID3DXMesh *mesh, const
             adjacency, -1.01f, -0.01f, -1.01f, NULL, NULL);
 }
 
+/* Average number of vertices transformed per face, with a FIFO cache. */
+static float get_acmr(const DWORD *indices, DWORD num_faces, DWORD num_vertices, DWORD cache_size)
+{
+    DWORD *timestamps, i, time = 0;
+
+    timestamps = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, num_vertices * sizeof(*timestamps));
+    for (i = 0; i < num_faces * 3; i++)
+    {
+        if (!timestamps[indices[i]] || time - timestamps[indices[i]] >= cache_size)
+            timestamps[indices[i]] = ++time;
+    }
+    HeapFree(GetProcessHeap(), 0, timestamps);
+
+    return (float)time / num_faces;
+}
+
+static void test_optimize_inplace_vertex_cache(void)
+{
+    static const D3DVERTEXELEMENT9 declaration[] =
+    {
+        {0, 0, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0},
+        D3DDECL_END()
+    };
+    static const DWORD options = D3DXMESH_32BIT | D3DXMESH_SYSTEMMEM;
+    const DWORD size = 32, num_vertices = (size + 1) * (size + 1), num_faces = size * size * 2;
+    DWORD *indices, *attributes, *adjacency, *new_adjacency, *face_remap, *new_indices, *new_attributes;
+    DWORD *vertex_remap, i, j, x, y, face, attribute_table_size;
+    struct test_context *test_context;
+    D3DXVECTOR3 *vertices, *new_vertices;
+    ID3DXBuffer *vertex_remap_buffer;
+    ID3DXMesh *mesh;
+    float acmr;
+    HRESULT hr;
+
+    if (!(test_context = new_test_context()))
+    {
+        skip("Couldn't create test context\n");
+        return;
+    }
+
+    vertices = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*vertices));
+    indices = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*indices));
+    attributes = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*attributes));
+    adjacency = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*adjacency));
+    new_adjacency = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*new_adjacency));
+    face_remap = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*face_remap));
+
+    /* A grid, with the faces in a scrambled order, and the top and bottom
+     * halves using different attributes. */
+    for (i = 0; i < num_vertices; i++)
+    {
+        vertices[i].x = i % (size + 1);
+        vertices[i].y = i / (size + 1);
+        vertices[i].z = 0.0f;
+    }
+    for (i = 0; i < num_faces; i++)
+    {
+        DWORD vertex;
+
+        face = (i * 389) % num_faces;
+        x = face / 2 % size;
+        y = face / 2 / size;
+        vertex = y * (size + 1) + x;
+        indices[i * 3] = vertex;
+        indices[i * 3 + 1] = face & 1 ? vertex + 1 : vertex + size + 2;
+        indices[i * 3 + 2] = face & 1 ? vertex + size + 2 : vertex + size + 1;
+        attributes[i] = y >= size / 2;
+    }
+    hr = init_test_mesh(num_faces, num_vertices, options, declaration, test_context->device, &mesh,
+            vertices, sizeof(*vertices), indices, attributes);
+    if (FAILED(hr))
+    {
+        skip("Couldn't initialize test mesh, hr %#x.\n", hr);
+        goto cleanup;
+    }
+    hr = mesh->lpVtbl->GenerateAdjacency(mesh, 0.0f, adjacency);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    hr = mesh->lpVtbl->OptimizeInplace(mesh, D3DXMESHOPT_VERTEXCACHE, adjacency, new_adjacency,
+            face_remap, &vertex_remap_buffer);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(mesh->lpVtbl->GetNumFaces(mesh) == num_faces, "Got unexpected face count %u.\n",
+            mesh->lpVtbl->GetNumFaces(mesh));
+    ok(mesh->lpVtbl->GetNumVertices(mesh) == num_vertices, "Got unexpected vertex count %u.\n",
+            mesh->lpVtbl->GetNumVertices(mesh));
+    vertex_remap = ID3DXBuffer_GetBufferPointer(vertex_remap_buffer);
+
+    mesh->lpVtbl->LockVertexBuffer(mesh, D3DLOCK_READONLY, (void **)&new_vertices);
+    mesh->lpVtbl->LockIndexBuffer(mesh, D3DLOCK_READONLY, (void **)&new_indices);
+    mesh->lpVtbl->LockAttributeBuffer(mesh, D3DLOCK_READONLY, &new_attributes);
+
+    for (i = 0; i < num_vertices; i++)
+    {
+        if (memcmp(&new_vertices[i], &vertices[vertex_remap[i]], sizeof(*vertices)))
+            break;
+    }
+    ok(i == num_vertices, "Vertex %u doesn't match.\n", i);
+
+    /* The faces are sorted by attribute, and keep their vertices and winding. */
+    for (i = 0; i < num_faces; i++)
+    {
+        face = face_remap[i];
+        if (face >= num_faces || new_attributes[i] != attributes[face]
+                || (i && new_attributes[i] < new_attributes[i - 1]))
+            break;
+        for (j = 0; j < 3; j++)
+        {
+            if (memcmp(&new_vertices[new_indices[i * 3 + j]], &vertices[indices[face * 3 + j]], sizeof(*vertices)))
+                break;
+        }
+        if (j < 3)
+            break;
+    }
+    ok(i == num_faces, "Face %u doesn't match.\n", i);
+
+    /* The scrambled order has no reuse at all, with an ACMR of 3. */
+    acmr = get_acmr(new_indices, num_faces, num_vertices, 16);
+    ok(acmr < 1.0f, "Got ACMR %.3f.\n", acmr);
+
+    mesh->lpVtbl->UnlockAttributeBuffer(mesh);
+    mesh->lpVtbl->UnlockIndexBuffer(mesh);
+    mesh->lpVtbl->UnlockVertexBuffer(mesh);
+
+    hr = mesh->lpVtbl->GetAttributeTable(mesh, NULL, &attribute_table_size);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(attribute_table_size == 2, "Got unexpected attribute table size %u.\n", attribute_table_size);
+
+    hr = mesh->lpVtbl->GenerateAdjacency(mesh, 0.0f, adjacency);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(!memcmp(adjacency, new_adjacency, num_faces * 3 * sizeof(*adjacency)), "Adjacency doesn't match.\n");
+
+    ID3DXBuffer_Release(vertex_remap_buffer);
+    mesh->lpVtbl->Release(mesh);
+
+cleanup:
+    HeapFree(GetProcessHeap(), 0, face_remap);
+    HeapFree(GetProcessHeap(), 0, new_adjacency);
+    HeapFree(GetProcessHeap(), 0, adjacency);
+    HeapFree(GetProcessHeap(), 0, attributes);
+    HeapFree(GetProcessHeap(), 0, indices);
+    HeapFree(GetProcessHeap(), 0, vertices);
+    free_test_context(test_context);
+}
+
 static void test_compute_normals(void)
 {
     HRESULT hr;
@@ -11520,6 +11780,7 @@ START_TEST(mesh)
     test_update_semantics();
     test_create_skin_info();
     test_update_skinned_mesh();
+    test_update_skinned_mesh_large();
     test_convert_adjacency_to_point_reps();
     test_convert_point_reps_to_adjacency();
     test_weld_vertices();
@@ -11527,6 +11788,7 @@ START_TEST(mesh)
     test_valid_mesh();
     test_optimize_vertices();
     test_optimize_faces();
+    test_optimize_inplace_vertex_cache();
     test_compute_normals();
     test_D3DXFrameFind();
     test_load_skin_mesh_from_xof();
@@ -1487,6 +1487,72 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
     if(testbitmap_ok) DeleteFileA("testbitmap.bmp");
 }
 
+static void test_dxt_compression(IDirect3DDevice9 *device)
+{
+    static const D3DFORMAT formats[] = {D3DFMT_DXT1, D3DFMT_DXT3, D3DFMT_DXT5};
+    static const unsigned int size = 512;
+    IDirect3DSurface9 *surface, *uncompressed;
+    unsigned int i, x, y, c, max_diff;
+    D3DLOCKED_RECT lock_rect;
+    IDirect3DTexture9 *tex;
+    DWORD *pixels;
+    RECT rect;
+    HRESULT hr;
+
+    pixels = HeapAlloc(GetProcessHeap(), 0, size * size * sizeof(*pixels));
+    for (y = 0; y < size; ++y)
+    {
+        for (x = 0; x < size; ++x)
+            pixels[y * size + x] = 0xff000000 | (x / 2) << 16 | (y / 2) << 8 | ((x + y) / 4);
+    }
+    SetRect(&rect, 0, 0, size, size);
+
+    hr = IDirect3DDevice9_CreateOffscreenPlainSurface(device, size, size, D3DFMT_A8R8G8B8,
+            D3DPOOL_SYSTEMMEM, &uncompressed, NULL);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(formats); ++i)
+    {
+        hr = IDirect3DDevice9_CreateTexture(device, size, size, 1, 0, formats[i], D3DPOOL_SYSTEMMEM, &tex, NULL);
+        if (FAILED(hr))
+        {
+            skip("Failed to create texture with format %#x, hr %#x.\n", formats[i], hr);
+            continue;
+        }
+        hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &surface);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+        hr = D3DXLoadSurfaceFromMemory(surface, NULL, NULL, pixels, D3DFMT_A8R8G8B8,
+                size * sizeof(*pixels), NULL, &rect, D3DX_FILTER_NONE, 0);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+        hr = D3DXLoadSurfaceFromSurface(uncompressed, NULL, NULL, surface, NULL, NULL, D3DX_FILTER_NONE, 0);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        hr = IDirect3DSurface9_LockRect(uncompressed, &lock_rect, NULL, D3DLOCK_READONLY);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        /* The gradient changes slowly enough that every block compresses well. */
+        max_diff = 0;
+        for (y = 0; y < size; ++y)
+        {
+            for (x = 0; x < size; ++x)
+            {
+                DWORD color = ((DWORD *)((BYTE *)lock_rect.pBits + y * lock_rect.Pitch))[x];
+
+                for (c = 0; c < 32; c += 8)
+                    max_diff = max(max_diff, abs((int)((color >> c) & 0xff) - (int)((pixels[y * size + x] >> c) & 0xff)));
+            }
+        }
+        ok(max_diff <= 16, "Format %#x: got unexpected difference %u.\n", formats[i], max_diff);
+        IDirect3DSurface9_UnlockRect(uncompressed);
+
+        check_release((IUnknown *)surface, 1);
+        check_release((IUnknown *)tex, 0);
+    }
+
+    check_release((IUnknown *)uncompressed, 0);
+    HeapFree(GetProcessHeap(), 0, pixels);
+}
+
 static void test_D3DXSaveSurfaceToFileInMemory(IDirect3DDevice9 *device)
 {
     static const struct
@@ -1750,6 +1816,7 @@ START_TEST(surface)
 
     test_D3DXGetImageInfo();
     test_D3DXLoadSurface(device);
+    test_dxt_compression(device);
     test_D3DXSaveSurfaceToFileInMemory(device);
     test_D3DXSaveSurfaceToFile(device);
 
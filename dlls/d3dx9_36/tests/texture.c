@@ -914,9 +914,13 @@ static void test_D3DXCreateTexture(IDirect3DDevice9 *device)
 
 static void test_D3DXFilterTexture(IDirect3DDevice9 *device)
 {
+    static const DWORD block[] = {0x00000000, 0x40404040, 0x80808080, 0xc0c0c0c0};
     IDirect3DTexture9 *tex;
     IDirect3DCubeTexture9 *cubetex;
     IDirect3DVolumeTexture9 *voltex;
+    D3DLOCKED_RECT lock_rect;
+    unsigned int i, x, y;
+    DWORD color;
     HRESULT hr;
 
     hr = IDirect3DDevice9_CreateTexture(device, 256, 256, 5, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &tex, NULL);
@@ -943,6 +947,42 @@ static void test_D3DXFilterTexture(IDirect3DDevice9 *device)
     hr = D3DXFilterTexture(NULL, NULL, 0, D3DX_FILTER_NONE);
     ok(hr == D3DERR_INVALIDCALL, "D3DXFilterTexture returned %#x, expected %#x\n", hr, D3DERR_INVALIDCALL);
 
+    /* Each 2x2 block of the top level averages to the same color. */
+    hr = IDirect3DDevice9_CreateTexture(device, 4, 4, 3, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &tex, NULL);
+    if (SUCCEEDED(hr))
+    {
+        hr = IDirect3DTexture9_LockRect(tex, 0, &lock_rect, NULL, 0);
+        ok(hr == D3D_OK, "Failed to lock texture, hr %#x.\n", hr);
+        for (y = 0; y < 4; ++y)
+        {
+            for (x = 0; x < 4; ++x)
+                ((DWORD *)((BYTE *)lock_rect.pBits + y * lock_rect.Pitch))[x] = block[(y % 2) * 2 + x % 2];
+        }
+        IDirect3DTexture9_UnlockRect(tex, 0);
+
+        hr = D3DXFilterTexture((IDirect3DBaseTexture9 *)tex, NULL, 0, D3DX_FILTER_BOX);
+        ok(hr == D3D_OK, "D3DXFilterTexture returned %#x, expected %#x\n", hr, D3D_OK);
+
+        for (i = 1; i < 3; ++i)
+        {
+            hr = IDirect3DTexture9_LockRect(tex, i, &lock_rect, NULL, D3DLOCK_READONLY);
+            ok(hr == D3D_OK, "Failed to lock texture, hr %#x.\n", hr);
+            for (y = 0; y < 4 >> i; ++y)
+            {
+                for (x = 0; x < 4 >> i; ++x)
+                {
+                    color = ((DWORD *)((BYTE *)lock_rect.pBits + y * lock_rect.Pitch))[x];
+                    ok(compare_color(color, 0x60606060, 1), "Level %u, pixel (%u, %u): got unexpected color %#x.\n",
+                            i, x, y, color);
+                }
+            }
+            IDirect3DTexture9_UnlockRect(tex, i);
+        }
+        IDirect3DTexture9_Release(tex);
+    }
+    else
+        skip("Failed to create texture\n");
+
     /* Test different pools */
     hr = IDirect3DDevice9_CreateTexture(device, 256, 256, 0, 0, D3DFMT_A8R8G8B8, D3DPOOL_SYSTEMMEM, &tex, NULL);
 
@@ -22,9 +22,11 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "txc_dxtn.h"
+#include "winbase.h"
 
 /* weights used for error function, basically weights (unsquared 2/4/1) according to rgb->luminance conversion
    not sure if this really reflects visual perception */
@@ -755,87 +757,141 @@ static void extractsrccolors( GLubyte srcpixels[4][4][4], const GLchan *srcaddr,
 }
 
 
+/* number of block rows compressed by each thread pool work item, at least */
+#define MIN_BLOCK_ROWS_PER_JOB 8
+#define MAX_JOBS 16
+
+struct dxtn_job {
+   GLint srccomps, width, height;
+   const GLubyte *srcPixData;
+   GLenum destFormat;
+   GLubyte *dest;
+   GLint blockSize, blockRowStride;
+   GLint firstRow, lastRow;
+   LONG *pending;
+   HANDLE doneEvent;
+};
+
+static void compressblockrows( const struct dxtn_job *job )
+{
+   GLubyte srcpixels[4][4][4];
+   const GLchan *srcaddr;
+   GLubyte *blkaddr;
+   GLint numxpixels, numypixels;
+   GLint i, j;
+
+   for (j = job->firstRow * 4; j < job->lastRow * 4; j += 4) {
+      if (job->height > j + 3) numypixels = 4;
+      else numypixels = job->height - j;
+      srcaddr = job->srcPixData + j * job->width * job->srccomps;
+      blkaddr = job->dest + (j / 4) * job->blockRowStride;
+      for (i = 0; i < job->width; i += 4) {
+         if (job->width > i + 3) numxpixels = 4;
+         else numxpixels = job->width - i;
+         extractsrccolors(srcpixels, srcaddr, job->width, numxpixels, numypixels, job->srccomps);
+         switch (job->destFormat) {
+         case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+            blkaddr[0] = (srcpixels[0][0][3] >> 4) | (srcpixels[0][1][3] & 0xf0);
+            blkaddr[1] = (srcpixels[0][2][3] >> 4) | (srcpixels[0][3][3] & 0xf0);
+            blkaddr[2] = (srcpixels[1][0][3] >> 4) | (srcpixels[1][1][3] & 0xf0);
+            blkaddr[3] = (srcpixels[1][2][3] >> 4) | (srcpixels[1][3][3] & 0xf0);
+            blkaddr[4] = (srcpixels[2][0][3] >> 4) | (srcpixels[2][1][3] & 0xf0);
+            blkaddr[5] = (srcpixels[2][2][3] >> 4) | (srcpixels[2][3][3] & 0xf0);
+            blkaddr[6] = (srcpixels[3][0][3] >> 4) | (srcpixels[3][1][3] & 0xf0);
+            blkaddr[7] = (srcpixels[3][2][3] >> 4) | (srcpixels[3][3][3] & 0xf0);
+            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, job->destFormat);
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            encodedxt5alpha(blkaddr, srcpixels, numxpixels, numypixels);
+            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, job->destFormat);
+            break;
+         default:
+            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, job->destFormat);
+            break;
+         }
+         srcaddr += job->srccomps * numxpixels;
+         blkaddr += job->blockSize;
+      }
+   }
+}
+
+static DWORD WINAPI compressblockrowsproc( void *arg )
+{
+   struct dxtn_job *job = arg;
+
+   compressblockrows(job);
+   if (!InterlockedDecrement(job->pending))
+      SetEvent(job->doneEvent);
+   return 0;
+}
+
+/* The blocks are independent, so ranges of block rows are compressed in parallel on
+   the thread pool, each with the same encoder as a single thread would use. There is
+   only one quality level: d3dx9 has no way to ask for a faster, lossier compression. */
 void tx_compress_dxtn(GLint srccomps, GLint width, GLint height, const GLubyte *srcPixData,
                      GLenum destFormat, GLubyte *dest, GLint dstRowStride)
 {
-      GLubyte *blkaddr = dest;
-      GLubyte srcpixels[4][4][4];
-      const GLchan *srcaddr = srcPixData;
-      GLint numxpixels, numypixels;
-      GLint i, j;
-      GLint dstRowDiff;
+   struct dxtn_job jobs[MAX_JOBS];
+   GLint blockRows = (height + 3) / 4;
+   GLint blockRowSize, dstRowDiff;
+   GLint i, numjobs;
+   HANDLE doneEvent = NULL;
+   LONG pending = 0;
+   SYSTEM_INFO info;
 
    switch (destFormat) {
    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
       /* hmm we used to get called without dstRowStride... */
-      dstRowDiff = dstRowStride >= (width * 2) ? dstRowStride - (((width + 3) & ~3) * 2) : 0;
-/*      fprintf(stderr, "dxt1 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 8;
-         }
-         blkaddr += dstRowDiff;
-      }
+      blockRowSize = ((width + 3) & ~3) * 2;
+      dstRowDiff = dstRowStride >= (width * 2) ? dstRowStride - blockRowSize : 0;
+      jobs[0].blockSize = 8;
       break;
    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-      dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - (((width + 3) & ~3) * 4) : 0;
-/*      fprintf(stderr, "dxt3 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            *blkaddr++ = (srcpixels[0][0][3] >> 4) | (srcpixels[0][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[0][2][3] >> 4) | (srcpixels[0][3][3] & 0xf0);
-            *blkaddr++ = (srcpixels[1][0][3] >> 4) | (srcpixels[1][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[1][2][3] >> 4) | (srcpixels[1][3][3] & 0xf0);
-            *blkaddr++ = (srcpixels[2][0][3] >> 4) | (srcpixels[2][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[2][2][3] >> 4) | (srcpixels[2][3][3] & 0xf0);
-            *blkaddr++ = (srcpixels[3][0][3] >> 4) | (srcpixels[3][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[3][2][3] >> 4) | (srcpixels[3][3][3] & 0xf0);
-            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 8;
-         }
-         blkaddr += dstRowDiff;
-      }
-      break;
    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-      dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - (((width + 3) & ~3) * 4) : 0;
-/*      fprintf(stderr, "dxt5 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            encodedxt5alpha(blkaddr, srcpixels, numxpixels, numypixels);
-            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 16;
-         }
-         blkaddr += dstRowDiff;
-      }
+      blockRowSize = ((width + 3) & ~3) * 4;
+      dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - blockRowSize : 0;
+      jobs[0].blockSize = 16;
       break;
    default:
       /* fprintf(stderr, "libdxtn: Bad dstFormat %d in tx_compress_dxtn\n", destFormat); */
       return;
    }
+
+   jobs[0].srccomps = srccomps;
+   jobs[0].width = width;
+   jobs[0].height = height;
+   jobs[0].srcPixData = srcPixData;
+   jobs[0].destFormat = destFormat;
+   jobs[0].dest = dest;
+   jobs[0].blockRowStride = blockRowSize + dstRowDiff;
+   jobs[0].pending = &pending;
+   jobs[0].doneEvent = NULL;
+
+   /* block rows are independent, spread them over the thread pool */
+   GetSystemInfo(&info);
+   numjobs = min(info.dwNumberOfProcessors, MAX_JOBS);
+   numjobs = min(numjobs, blockRows / MIN_BLOCK_ROWS_PER_JOB);
+   if (numjobs > 1 && !(doneEvent = CreateEventW(NULL, TRUE, FALSE, NULL)))
+      numjobs = 1;
+   if (numjobs < 1)
+      numjobs = 1;
+
+   for (i = 0; i < numjobs; i++) {
+      jobs[i] = jobs[0];
+      jobs[i].firstRow = blockRows * i / numjobs;
+      jobs[i].lastRow = blockRows * (i + 1) / numjobs;
+      jobs[i].doneEvent = doneEvent;
+   }
+
+   pending = numjobs - 1;
+   for (i = 1; i < numjobs; i++) {
+      if (!QueueUserWorkItem(compressblockrowsproc, &jobs[i], WT_EXECUTEDEFAULT))
+         compressblockrowsproc(&jobs[i]);
+   }
+   compressblockrows(&jobs[0]);
+   if (doneEvent) {
+      WaitForSingleObject(doneEvent, INFINITE);
+      CloseHandle(doneEvent);
+   }
 }
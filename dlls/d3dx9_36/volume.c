@@ -207,15 +207,23 @@ HRESULT WINAPI D3DXLoadVolumeFromMemory(IDirect3DVolume9 *dst_volume,
                     locked_box.pBits, locked_box.RowPitch, locked_box.SlicePitch, &dst_size, dst_format_desc, color_key,
                     src_palette);
         }
-        else
+        else if ((filter & 0xf) == D3DX_FILTER_POINT || (filter & 0xf) > D3DX_FILTER_BOX
+                || (src_size.width == dst_size.width && src_size.height == dst_size.height
+                && src_size.depth == dst_size.depth))
         {
-            if ((filter & 0xf) != D3DX_FILTER_POINT)
+            if ((filter & 0xf) > D3DX_FILTER_BOX)
                 FIXME("Unhandled filter %#x.\n", filter);
 
             point_filter_argb_pixels(src_addr, src_row_pitch, src_slice_pitch, &src_size, src_format_desc,
                     locked_box.pBits, locked_box.RowPitch, locked_box.SlicePitch, &dst_size, dst_format_desc, color_key,
                     src_palette);
         }
+        else
+        {
+            filter_argb_pixels(src_addr, src_row_pitch, src_slice_pitch, &src_size, src_format_desc,
+                    locked_box.pBits, locked_box.RowPitch, locked_box.SlicePitch, &dst_size, dst_format_desc, color_key,
+                    src_palette, filter);
+        }
 
         IDirect3DVolume9_UnlockBox(dst_volume);
     }
@@ -543,6 +543,7 @@ struct windrv_physdev
     struct dibdrv_physdev *dibdrv;
     struct window_surface *surface;
     DWORD                  start_ticks;
+    RECT                   bounds;  /* bounds of the current operation, if the surface tracks them */
 };
 
 static const struct gdi_dc_funcs window_driver;
@@ -556,11 +557,17 @@ static inline void lock_surface( struct windrv_physdev *dev )
 {
     GDI_CheckNotLock();
     dev->surface->funcs->lock( dev->surface );
-    if (is_rect_empty( dev->dibdrv->bounds )) dev->start_ticks = GetTickCount();
+    if (is_rect_empty( dev->surface->funcs->get_bounds( dev->surface ))) dev->start_ticks = GetTickCount();
 }
 
 static inline void unlock_surface( struct windrv_physdev *dev )
 {
+    if (dev->dibdrv->bounds == &dev->bounds && !is_rect_empty( &dev->bounds ))
+    {
+        /* let the surface know exactly which area the operation touched */
+        dev->surface->funcs->add_bounds( dev->surface, &dev->bounds );
+        reset_bounds( &dev->bounds );
+    }
     dev->surface->funcs->unlock( dev->surface );
     if (GetTickCount() - dev->start_ticks > FLUSH_PERIOD) dev->surface->funcs->flush( dev->surface );
 }
@@ -603,7 +610,12 @@ void dibdrv_set_window_surface( DC *dc, struct window_surface *surface )
         init_dib_info_from_bitmapinfo( &dibdrv->dib, info, bits );
         dibdrv->dib.rect = dc->vis_rect;
         offset_rect( &dibdrv->dib.rect, -dc->device_rect.left, -dc->device_rect.top );
-        dibdrv->bounds = surface->funcs->get_bounds( surface );
+        if (surface->funcs->add_bounds)
+        {
+            reset_bounds( &physdev->bounds );
+            dibdrv->bounds = &physdev->bounds;
+        }
+        else dibdrv->bounds = surface->funcs->get_bounds( surface );
         DC_InitDC( dc );
     }
     else if (windev)
@@ -45,8 +45,9 @@ enum glyph_type
 
 struct cached_font
 {
-    struct list           entry;
+    struct cached_font   *next;        /* next font in the same shard */
     LONG                  ref;
+    LONG                  last_used;   /* font_cache_clock value of the last lookup */
     DWORD                 hash;
     LOGFONTW              lf;
     XFORM                 xform;
@@ -54,16 +55,20 @@ struct cached_font
     struct cached_glyph **glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
 };
 
-static struct list font_cache = LIST_INIT( font_cache );
+/* the font cache is split in shards selected by the font hash, so that threads using
+ * different fonts don't contend on the same lock; lookups only take a shared lock */
 
-static CRITICAL_SECTION font_cache_cs;
-static CRITICAL_SECTION_DEBUG critsect_debug =
+#define FONT_CACHE_SHARDS       8
+#define FONT_CACHE_MAX_UNUSED   2  /* unused fonts kept in each shard */
+
+struct font_cache_shard
 {
-    0, 0, &font_cache_cs,
-    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
-      0, 0, { (DWORD_PTR)(__FILE__ ": font_cache_cs") }
+    SRWLOCK             lock;
+    struct cached_font *fonts;
 };
-static CRITICAL_SECTION font_cache_cs = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static struct font_cache_shard font_cache[FONT_CACHE_SHARDS];
+static LONG font_cache_clock;
 
 
 static BOOL brush_rect( dibdrv_physdev *pdev, dib_brush *brush, const RECT *rect, HRGN clip )
@@ -634,10 +639,42 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+static void free_cached_glyphs( struct cached_font *font )
+{
+    UINT i, j, k;
+
+    for (i = 0; i < GLYPH_NBTYPES; i++)
+    {
+        for (j = 0; j < GLYPH_CACHE_PAGES; j++)
+        {
+            if (!font->glyphs[i][j]) continue;
+            for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
+                HeapFree( GetProcessHeap(), 0, font->glyphs[i][j][k] );
+            HeapFree( GetProcessHeap(), 0, font->glyphs[i][j] );
+        }
+    }
+}
+
+/* find a font in a shard and grab a reference to it; the shard lock must be held */
+static struct cached_font *find_cached_font( struct font_cache_shard *shard, const struct cached_font *font )
+{
+    struct cached_font *ptr;
+
+    for (ptr = shard->fonts; ptr; ptr = ptr->next)
+    {
+        if (font_cache_cmp( font, ptr )) continue;
+        InterlockedIncrement( &ptr->ref );
+        ptr->last_used = InterlockedIncrement( &font_cache_clock );
+        return ptr;
+    }
+    return NULL;
+}
+
 static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 {
-    struct cached_font font, *ptr, *last_unused = NULL;
-    UINT i = 0, j, k;
+    struct cached_font font, *ptr, *last_unused = NULL, **prev, **last_unused_prev = NULL;
+    struct font_cache_shard *shard;
+    UINT unused = 0;
 
     GetObjectW( hfont, sizeof(font.lf), &font.lf );
     font.xform = dc->xformWorld2Vport;
@@ -651,50 +688,51 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
     font.lf.lfWidth = abs( font.lf.lfWidth );
     font.aa_flags = aa_flags;
     font.hash = font_cache_hash( &font );
+    shard = &font_cache[font.hash % FONT_CACHE_SHARDS];
 
-    EnterCriticalSection( &font_cache_cs );
-    LIST_FOR_EACH_ENTRY( ptr, &font_cache, struct cached_font, entry )
+    AcquireSRWLockShared( &shard->lock );
+    ptr = find_cached_font( shard, &font );
+    ReleaseSRWLockShared( &shard->lock );
+    if (ptr) goto done;
+
+    AcquireSRWLockExclusive( &shard->lock );
+    if ((ptr = find_cached_font( shard, &font )))  /* added by another thread in the meantime */
     {
-        if (!font_cache_cmp( &font, ptr ))
-        {
-            InterlockedIncrement( &ptr->ref );
-            list_remove( &ptr->entry );
-            goto done;
-        }
-        if (!ptr->ref)
+        ReleaseSRWLockExclusive( &shard->lock );
+        goto done;
+    }
+
+    for (prev = &shard->fonts; *prev; prev = &(*prev)->next)
+    {
+        if ((*prev)->ref) continue;
+        unused++;
+        if (!last_unused || (*prev)->last_used - last_unused->last_used < 0)
         {
-            i++;
-            last_unused = ptr;
+            last_unused = *prev;
+            last_unused_prev = prev;
         }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
+    if (unused > FONT_CACHE_MAX_UNUSED)  /* keep the most-recently used fonts around */
     {
         ptr = last_unused;
-        for (i = 0; i < GLYPH_NBTYPES; i++)
-        {
-            for (j = 0; j < GLYPH_CACHE_PAGES; j++)
-            {
-                if (!ptr->glyphs[i][j]) continue;
-                for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
-                    HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j][k] );
-                HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j] );
-            }
-        }
-        list_remove( &ptr->entry );
+        *last_unused_prev = ptr->next;
+        free_cached_glyphs( ptr );
     }
     else if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
     {
-        LeaveCriticalSection( &font_cache_cs );
+        ReleaseSRWLockExclusive( &shard->lock );
         return NULL;
     }
 
     *ptr = font;
     ptr->ref = 1;
+    ptr->last_used = InterlockedIncrement( &font_cache_clock );
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
+    ptr->next = shard->fonts;
+    shard->fonts = ptr;
+    ReleaseSRWLockExclusive( &shard->lock );
 done:
-    list_add_head( &font_cache, &ptr->entry );
-    LeaveCriticalSection( &font_cache_cs );
     TRACE( "%d %s -> %p\n", ptr->lf.lfHeight, debugstr_w(ptr->lf.lfFaceName), ptr );
     return ptr;
 }
@@ -761,27 +799,22 @@ static inline void get_text_bkgnd_masks( DC *dc, const dib_info *dib, rop_mask *
     }
 }
 
-static void draw_glyph( dib_info *dib, int x, int y, const GLYPHMETRICS *metrics,
-                        const dib_info *glyph_dib, DWORD text_color,
-                        const struct font_intensities *intensity,
-                        const struct clipped_rects *clipped_rects, RECT *bounds )
+static void draw_glyph_rect( dib_info *dib, const RECT *rect, const dib_info *glyph_dib, DWORD text_color,
+                             const struct font_intensities *intensity,
+                             const struct clipped_rects *clipped_rects, RECT *bounds )
 {
     int i;
-    RECT rect, clipped_rect;
+    RECT clipped_rect;
     POINT src_origin;
 
-    rect.left   = x          + metrics->gmptGlyphOrigin.x;
-    rect.top    = y          - metrics->gmptGlyphOrigin.y;
-    rect.right  = rect.left  + metrics->gmBlackBoxX;
-    rect.bottom = rect.top   + metrics->gmBlackBoxY;
-    if (bounds) add_bounds_rect( bounds, &rect );
+    if (bounds) add_bounds_rect( bounds, rect );
 
     for (i = 0; i < clipped_rects->count; i++)
     {
-        if (intersect_rect( &clipped_rect, &rect, clipped_rects->rects + i ))
+        if (intersect_rect( &clipped_rect, rect, clipped_rects->rects + i ))
         {
-            src_origin.x = clipped_rect.left - rect.left;
-            src_origin.y = clipped_rect.top  - rect.top;
+            src_origin.x = clipped_rect.left - rect->left;
+            src_origin.y = clipped_rect.top  - rect->top;
 
             if (glyph_dib->bit_count == 32)
                 dib->funcs->draw_subpixel_glyph( dib, &clipped_rect, glyph_dib, &src_origin,
@@ -793,6 +826,14 @@ static void draw_glyph( dib_info *dib, int x, int y, const GLYPHMETRICS *metrics
     }
 }
 
+static inline void get_glyph_rect( const struct cached_glyph *glyph, int x, int y, RECT *rect )
+{
+    rect->left   = x           + glyph->metrics.gmptGlyphOrigin.x;
+    rect->top    = y           - glyph->metrics.gmptGlyphOrigin.y;
+    rect->right  = rect->left  + glyph->metrics.gmBlackBoxX;
+    rect->bottom = rect->top   + glyph->metrics.gmBlackBoxY;
+}
+
 static int get_glyph_depth( UINT aa_flags )
 {
     switch (aa_flags)
@@ -888,15 +929,91 @@ done:
     return add_cached_glyph( font, index, flags, glyph );
 }
 
+struct glyph_pos
+{
+    struct cached_glyph *glyph;
+    RECT                 rect;
+};
+
+#define MAX_GLYPH_RUN_SIZE  0x100000  /* max size of the coverage mask of a glyph run */
+
+/***********************************************************************
+ *         build_glyph_run
+ *
+ * Combine the glyphs of a string into a single coverage mask covering the run rectangle,
+ * so that it can be clipped and blended in one go. Fails if some glyphs overlap, since
+ * blending them one after the other gives different results.
+ */
+static BOOL build_glyph_run( const struct glyph_pos *glyphs, UINT count, const RECT *run_rect,
+                             dib_info *run_dib )
+{
+    int width = run_rect->right - run_rect->left, height = run_rect->bottom - run_rect->top;
+    int bytes_pp = run_dib->bit_count / 8;
+    UINT i;
+    int x, y;
+
+    run_dib->width       = width;
+    run_dib->height      = height;
+    run_dib->rect.right  = width;
+    run_dib->rect.bottom = height;
+    run_dib->stride      = get_dib_stride( width, run_dib->bit_count );
+    if ((ULONGLONG)run_dib->stride * height > MAX_GLYPH_RUN_SIZE) return FALSE;
+    if (!(run_dib->bits.ptr = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, run_dib->stride * height )))
+        return FALSE;
+
+    for (i = 0; i < count; i++)
+    {
+        const struct cached_glyph *glyph = glyphs[i].glyph;
+        int glyph_width = glyph->metrics.gmBlackBoxX;
+        int glyph_stride = get_dib_stride( glyph_width, run_dib->bit_count );
+        BYTE *dst = (BYTE *)run_dib->bits.ptr + (glyphs[i].rect.top - run_rect->top) * run_dib->stride +
+                    (glyphs[i].rect.left - run_rect->left) * bytes_pp;
+        const BYTE *src = glyph->bits;
+
+        for (y = 0; y < glyph->metrics.gmBlackBoxY; y++, dst += run_dib->stride, src += glyph_stride)
+        {
+            if (bytes_pp == 4)
+            {
+                DWORD *dst32 = (DWORD *)dst;
+                const DWORD *src32 = (const DWORD *)src;
+
+                for (x = 0; x < glyph_width; x++)
+                {
+                    if (!src32[x]) continue;
+                    if (dst32[x]) goto overlap;
+                    dst32[x] = src32[x];
+                }
+            }
+            else
+            {
+                /* levels 0 and 1 leave the destination untouched */
+                for (x = 0; x < glyph_width; x++)
+                {
+                    if (src[x] <= 1) continue;
+                    if (dst[x] > 1) goto overlap;
+                    dst[x] = src[x];
+                }
+            }
+        }
+    }
+    return TRUE;
+
+overlap:
+    HeapFree( GetProcessHeap(), 0, run_dib->bits.ptr );
+    return FALSE;
+}
+
 static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT x, INT y,
                            UINT flags, const WCHAR *str, UINT count, const INT *dx,
                            const struct clipped_rects *clipped_rects, RECT *bounds )
 {
-    UINT i;
+    UINT i, glyph_count = 0;
     struct cached_glyph *glyph;
+    struct glyph_pos glyphs_buffer[64], *glyphs = glyphs_buffer;
     dib_info glyph_dib;
     DWORD text_color;
     struct font_intensities intensity;
+    RECT run_rect;
 
     glyph_dib.bit_count    = get_glyph_depth( font->aa_flags );
     glyph_dib.rect.left    = 0;
@@ -911,19 +1028,23 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
     else
         get_aa_ranges( dib->funcs->pixel_to_colorref( dib, text_color ), intensity.ranges );
 
+    if (count > ARRAY_SIZE( glyphs_buffer ) &&
+        !(glyphs = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*glyphs) )))
+        return;
+
+    /* first resolve all the glyphs and their positions */
+    reset_bounds( &run_rect );
     for (i = 0; i < count; i++)
     {
         if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
             !(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
 
-        glyph_dib.width       = glyph->metrics.gmBlackBoxX;
-        glyph_dib.height      = glyph->metrics.gmBlackBoxY;
-        glyph_dib.rect.right  = glyph->metrics.gmBlackBoxX;
-        glyph_dib.rect.bottom = glyph->metrics.gmBlackBoxY;
-        glyph_dib.stride      = get_dib_stride( glyph->metrics.gmBlackBoxX, glyph_dib.bit_count );
-        glyph_dib.bits.ptr    = glyph->bits;
-
-        draw_glyph( dib, x, y, &glyph->metrics, &glyph_dib, text_color, &intensity, clipped_rects, bounds );
+        get_glyph_rect( glyph, x, y, &glyphs[glyph_count].rect );
+        if (!is_rect_empty( &glyphs[glyph_count].rect ))
+        {
+            add_bounds_rect( &run_rect, &glyphs[glyph_count].rect );
+            glyphs[glyph_count++].glyph = glyph;
+        }
 
         if (dx)
         {
@@ -941,6 +1062,27 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
             y += glyph->metrics.gmCellIncY;
         }
     }
+
+    /* then draw them as a single run if possible, clipping it only once */
+    if (glyph_count > 1 && build_glyph_run( glyphs, glyph_count, &run_rect, &glyph_dib ))
+    {
+        draw_glyph_rect( dib, &run_rect, &glyph_dib, text_color, &intensity, clipped_rects, bounds );
+        HeapFree( GetProcessHeap(), 0, glyph_dib.bits.ptr );
+    }
+    else for (i = 0; i < glyph_count; i++)
+    {
+        glyph = glyphs[i].glyph;
+        glyph_dib.width       = glyph->metrics.gmBlackBoxX;
+        glyph_dib.height      = glyph->metrics.gmBlackBoxY;
+        glyph_dib.rect.right  = glyph->metrics.gmBlackBoxX;
+        glyph_dib.rect.bottom = glyph->metrics.gmBlackBoxY;
+        glyph_dib.stride      = get_dib_stride( glyph->metrics.gmBlackBoxX, glyph_dib.bit_count );
+        glyph_dib.bits.ptr    = glyph->bits;
+
+        draw_glyph_rect( dib, &glyphs[i].rect, &glyph_dib, text_color, &intensity, clipped_rects, bounds );
+    }
+
+    if (glyphs != glyphs_buffer) HeapFree( GetProcessHeap(), 0, glyphs );
 }
 
 BOOL render_aa_text_bitmapinfo( DC *dc, BITMAPINFO *info, struct gdi_image_bits *bits,
@@ -1930,14 +1930,12 @@ static void get_family_names( FT_Face ft_face, WCHAR **name, WCHAR **english, BO
     }
 }
 
-static Family *get_family( FT_Face ft_face, BOOL vertical )
+/****************************************************************
+ * NB This function takes ownership of the strings.
+ */
+static Family *find_or_create_family( WCHAR *name, WCHAR *english_name )
 {
-    Family *family;
-    WCHAR *name, *english_name;
-
-    get_family_names( ft_face, &name, &english_name, vertical );
-
-    family = find_family_from_name( name );
+    Family *family = find_family_from_name( name );
 
     if (!family)
     {
@@ -1962,6 +1960,14 @@ static Family *get_family( FT_Face ft_face, BOOL vertical )
     return family;
 }
 
+static Family *get_family( FT_Face ft_face, BOOL vertical )
+{
+    WCHAR *name, *english_name;
+
+    get_family_names( ft_face, &name, &english_name, vertical );
+    return find_or_create_family( name, english_name );
+}
+
 static inline FT_Fixed get_font_version( FT_Face ft_face )
 {
     FT_Fixed version = 0;
@@ -2145,6 +2151,8 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const char *file,
     return face;
 }
 
+static void index_add_face( const Face *face, const Family *family );
+
 static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr, DWORD font_data_size,
                           FT_Long face_index, DWORD flags )
 {
@@ -2153,6 +2161,7 @@ static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr
 
     face = create_face( ft_face, face_index, file, font_data_ptr, font_data_size, flags );
     family = get_family( ft_face, flags & ADDFONT_VERTICAL_FONT );
+    index_add_face( face, family );
 
     if (insert_face_in_family_list( face, family ))
     {
@@ -2242,11 +2251,498 @@ fail:
     return NULL;
 }
 
+/* The font index stores the faces found in each font file, keyed by the file path, size and
+ * modification time. It is kept in the prefix and used when building the font list, so that
+ * only the font files that changed need to be opened. The file is laid out as a header,
+ * followed by the file entries sorted by path, the face entries and the strings. */
+
+#define FONT_INDEX_MAGIC    0x78646966  /* "fidx" */
+#define FONT_INDEX_VERSION  1
+
+struct font_index_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD size;            /* total size of the index */
+    DWORD langid;          /* language used for the face names */
+    DWORD file_count;
+    DWORD face_count;
+};
+
+struct font_index_file
+{
+    DWORD     path;        /* offset of the unix path */
+    DWORD     result;      /* value returned by AddFontToList */
+    ULONGLONG size;
+    ULONGLONG mtime;
+    DWORD     first_face;
+    DWORD     face_count;
+    DWORD     flags;       /* ADDFONT_ALLOW_BITMAP */
+    DWORD     reserved;
+};
+
+struct font_index_face
+{
+    DWORD         family_name;   /* string offsets, 0 if not present */
+    DWORD         english_name;
+    DWORD         style_name;
+    DWORD         full_name;
+    LONG          face_index;
+    DWORD         ntm_flags;
+    LONG          font_version;
+    DWORD         flags;         /* ADDFONT_VERTICAL_FONT */
+    FONTSIGNATURE fs;
+    DWORD         scalable;
+    SHORT         height;
+    SHORT         width;
+    LONG          size;
+    LONG          x_ppem;
+    LONG          y_ppem;
+    LONG          internal_leading;
+};
+
+/* in-memory version of the entries, used while building the font list */
+struct index_face
+{
+    WCHAR                 *family_name;
+    WCHAR                 *english_name;
+    WCHAR                 *style_name;
+    WCHAR                 *full_name;
+    struct font_index_face data;
+};
+
+struct index_file
+{
+    char             *path;
+    DWORD             flags;
+    DWORD             result;
+    ULONGLONG         size;
+    ULONGLONG         mtime;
+    unsigned int      first_face;
+    unsigned int      face_count;
+};
+
+static const struct font_index_header *font_index;  /* mapped index, only valid during init */
+static struct index_file *index_files;
+static unsigned int index_file_count, index_file_size;
+static struct index_face *index_faces;
+static unsigned int index_face_count, index_face_size;
+static struct index_file *index_current;     /* file whose faces are being recorded */
+static BOOL index_building;  /* set while building the font list */
+static BOOL index_dirty;     /* some font files were not found in the index */
+
+static const WCHAR font_index_nameW[] = {'\\','f','o','n','t','i','n','d','e','x',0};
+
+/* get the unix name of the font index file */
+static char *get_font_index_path(void)
+{
+    static const WCHAR wineconfigdirW[] = {'W','I','N','E','C','O','N','F','I','G','D','I','R',0};
+    WCHAR path[MAX_PATH];
+    DWORD len = GetEnvironmentVariableW( wineconfigdirW, path, MAX_PATH );
+
+    if (!len || len + ARRAY_SIZE(font_index_nameW) > MAX_PATH) return NULL;
+    strcatW( path, font_index_nameW );
+    path[1] = '\\';  /* change \??\ to \\?\ */
+    return wine_get_unix_file_name( path );
+}
+
+static inline const WCHAR *get_index_string( DWORD offset )
+{
+    return offset ? (const WCHAR *)((const char *)font_index + offset) : NULL;
+}
+
+/* check that a string offset of the index points to a null-terminated string inside it */
+static BOOL check_index_string( const struct font_index_header *header, DWORD start, DWORD offset, BOOL wide )
+{
+    const char *ptr = (const char *)header;
+
+    if (offset < start || offset >= header->size) return FALSE;
+    if (!wide) return memchr( ptr + offset, 0, header->size - offset ) != NULL;
+    if (offset % sizeof(WCHAR)) return FALSE;
+    for (; header->size - offset >= sizeof(WCHAR); offset += sizeof(WCHAR))
+        if (!*(const WCHAR *)(ptr + offset)) return TRUE;
+    return FALSE;
+}
+
+/* validate the entries of a mapped index, the counts have already been checked against the size */
+static BOOL check_font_index( const struct font_index_header *header )
+{
+    const struct font_index_file *files = (const struct font_index_file *)(header + 1);
+    const struct font_index_face *faces = (const struct font_index_face *)(files + header->file_count);
+    DWORD start = (const char *)(faces + header->face_count) - (const char *)header;
+    unsigned int i;
+
+    for (i = 0; i < header->file_count; i++)
+    {
+        if (!check_index_string( header, start, files[i].path, FALSE )) return FALSE;
+        if ((ULONGLONG)files[i].first_face + files[i].face_count > header->face_count) return FALSE;
+    }
+    for (i = 0; i < header->face_count; i++)
+    {
+        if (!check_index_string( header, start, faces[i].family_name, TRUE )) return FALSE;
+        if (!check_index_string( header, start, faces[i].style_name, TRUE )) return FALSE;
+        if (faces[i].english_name && !check_index_string( header, start, faces[i].english_name, TRUE ))
+            return FALSE;
+        if (faces[i].full_name && !check_index_string( header, start, faces[i].full_name, TRUE ))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void load_font_index(void)
+{
+    const struct font_index_header *header;
+    struct stat st;
+    char *path;
+    void *ptr;
+    int fd;
+
+    if (!(path = get_font_index_path())) return;
+    fd = open( path, O_RDONLY );
+    HeapFree( GetProcessHeap(), 0, path );
+    if (fd == -1) return;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(*header) ||
+        (ptr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 )) == MAP_FAILED)
+    {
+        close( fd );
+        return;
+    }
+    close( fd );
+
+    header = ptr;
+    if (header->magic != FONT_INDEX_MAGIC || header->version != FONT_INDEX_VERSION ||
+        header->size != st.st_size || header->langid != GetSystemDefaultLangID() ||
+        sizeof(*header) + (ULONGLONG)header->file_count * sizeof(struct font_index_file) +
+        (ULONGLONG)header->face_count * sizeof(struct font_index_face) > header->size ||
+        !check_font_index( header ))
+    {
+        TRACE( "ignoring invalid or outdated font index\n" );
+        munmap( ptr, st.st_size );
+        return;
+    }
+    TRACE( "loaded font index with %u files\n", header->file_count );
+    font_index = header;
+}
+
+static int compare_index_file_path( const void *key, const void *entry )
+{
+    const struct font_index_file *file = entry;
+    return strcmp( key, (const char *)font_index + file->path );
+}
+
+static int compare_index_files( const void *a, const void *b )
+{
+    const struct index_file *file1 = a, *file2 = b;
+    return strcmp( file1->path, file2->path );
+}
+
+static struct index_file *add_index_file( const char *path, const struct stat *st, DWORD flags, DWORD result )
+{
+    struct index_file *file;
+
+    if (index_file_count == index_file_size)
+    {
+        unsigned int new_size = max( 256, index_file_size * 2 );
+        struct index_file *new_files;
+
+        if (index_files)
+            new_files = HeapReAlloc( GetProcessHeap(), 0, index_files, new_size * sizeof(*new_files) );
+        else
+            new_files = HeapAlloc( GetProcessHeap(), 0, new_size * sizeof(*new_files) );
+        if (!new_files) return NULL;
+        index_files = new_files;
+        index_file_size = new_size;
+    }
+    file = &index_files[index_file_count];
+    if (!(file->path = HeapAlloc( GetProcessHeap(), 0, strlen(path) + 1 ))) return NULL;
+    strcpy( file->path, path );
+    index_file_count++;
+    file->flags = flags & ADDFONT_ALLOW_BITMAP;
+    file->result = result;
+    file->size = st->st_size;
+    file->mtime = st->st_mtime;
+    file->first_face = index_face_count;
+    file->face_count = 0;
+    return file;
+}
+
+static struct index_face *add_index_face(void)
+{
+    if (index_face_count == index_face_size)
+    {
+        unsigned int new_size = max( 256, index_face_size * 2 );
+        struct index_face *new_faces;
+
+        if (index_faces)
+            new_faces = HeapReAlloc( GetProcessHeap(), 0, index_faces, new_size * sizeof(*new_faces) );
+        else
+            new_faces = HeapAlloc( GetProcessHeap(), 0, new_size * sizeof(*new_faces) );
+        if (!new_faces) return NULL;
+        index_faces = new_faces;
+        index_face_size = new_size;
+    }
+    return &index_faces[index_face_count++];
+}
+
+static inline WCHAR *strdup_opt( const WCHAR *str )
+{
+    return str ? strdupW( str ) : NULL;
+}
+
+/* record a face of the font file being loaded */
+static void index_add_face( const Face *face, const Family *family )
+{
+    struct index_face *entry;
+
+    if (!index_current || !(entry = add_index_face())) return;
+
+    entry->family_name  = strdupW( family->FamilyName );
+    entry->english_name = strdup_opt( family->EnglishName );
+    entry->style_name   = strdupW( face->StyleName );
+    entry->full_name    = strdup_opt( face->FullName );
+    entry->data.face_index       = face->face_index;
+    entry->data.ntm_flags        = face->ntmFlags;
+    entry->data.font_version     = face->font_version;
+    entry->data.flags            = face->flags & ADDFONT_VERTICAL_FONT;
+    entry->data.fs               = face->fs;
+    entry->data.scalable         = face->scalable;
+    entry->data.height           = face->size.height;
+    entry->data.width            = face->size.width;
+    entry->data.size             = face->size.size;
+    entry->data.x_ppem           = face->size.x_ppem;
+    entry->data.y_ppem           = face->size.y_ppem;
+    entry->data.internal_leading = face->size.internal_leading;
+    index_current->face_count++;
+}
+
+/* create a face from its index entry, the same way AddFaceToList does */
+static void add_face_from_index( const struct font_index_face *data, const char *file,
+                                 const struct stat *st, DWORD flags )
+{
+    Face *face = HeapAlloc( GetProcessHeap(), 0, sizeof(*face) );
+    Family *family;
+
+    face->refcount = 1;
+    face->StyleName = strdupW( get_index_string( data->style_name ));
+    face->FullName = strdup_opt( get_index_string( data->full_name ));
+    face->file = towstr( CP_UNIXCP, file );
+    face->dev = st->st_dev;
+    face->ino = st->st_ino;
+    face->font_data_ptr = NULL;
+    face->font_data_size = 0;
+    face->face_index = data->face_index;
+    face->fs = data->fs;
+    face->ntmFlags = data->ntm_flags;
+    face->font_version = data->font_version;
+    face->scalable = data->scalable;
+    face->size.height = data->height;
+    face->size.width = data->width;
+    face->size.size = data->size;
+    face->size.x_ppem = data->x_ppem;
+    face->size.y_ppem = data->y_ppem;
+    face->size.internal_leading = data->internal_leading;
+
+    flags |= data->flags;
+    if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+    face->flags  = flags;
+    face->family = NULL;
+    face->cached_enum_data = NULL;
+
+    family = find_or_create_family( strdupW( get_index_string( data->family_name )),
+                                    strdup_opt( get_index_string( data->english_name )));
+    index_add_face( face, family );
+
+    if (insert_face_in_family_list( face, family ))
+    {
+        if (flags & ADDFONT_ADD_TO_CACHE)
+            add_face_to_cache( face );
+
+        TRACE("Added font %s %s from index\n", debugstr_w(family->FamilyName),
+              debugstr_w(face->StyleName));
+    }
+    release_face( face );
+    release_family( family );
+}
+
+/* add the faces of a font file from the index; returns -1 if the file is not indexed or changed */
+static INT add_font_from_index( const char *file, const struct stat *st, DWORD flags )
+{
+    const struct font_index_file *entry;
+    const struct font_index_face *faces;
+    unsigned int i;
+
+    if (!font_index) return -1;
+    if (!(entry = bsearch( file, font_index + 1, font_index->file_count, sizeof(*entry),
+                           compare_index_file_path )))
+        return -1;
+    if (entry->size != st->st_size || entry->mtime != st->st_mtime) return -1;
+    if (entry->flags != (flags & ADDFONT_ALLOW_BITMAP)) return -1;
+
+    faces = (const struct font_index_face *)((const struct font_index_file *)(font_index + 1) +
+                                             font_index->file_count);
+    index_current = add_index_file( file, st, flags, entry->result );
+    for (i = 0; i < entry->face_count; i++)
+        add_face_from_index( &faces[entry->first_face + i], file, st, flags );
+    index_current = NULL;
+    return entry->result;
+}
+
+static DWORD add_index_string( char *buffer, DWORD *pos, const WCHAR *str )
+{
+    DWORD ret = *pos, len;
+
+    if (!str) return 0;
+    len = (strlenW( str ) + 1) * sizeof(WCHAR);
+    if (buffer) memcpy( buffer + ret, str, len );
+    *pos += len;
+    return ret;
+}
+
+static DWORD add_index_path( char *buffer, DWORD *pos, const char *path )
+{
+    DWORD ret = *pos, len = strlen( path ) + 1;
+
+    if (buffer) memcpy( buffer + ret, path, len );
+    *pos = (*pos + len + sizeof(WCHAR) - 1) & ~(sizeof(WCHAR) - 1);
+    return ret;
+}
+
+/* lay out the index in a buffer, or only compute its size if buffer is NULL */
+static DWORD build_font_index( char *buffer, unsigned int file_count, unsigned int face_count )
+{
+    struct font_index_header *header = (struct font_index_header *)buffer;
+    struct font_index_file *files = NULL;
+    struct font_index_face *faces = NULL;
+    unsigned int i, j, file_pos = 0, face_pos = 0;
+    DWORD pos = sizeof(*header) + file_count * sizeof(*files) + face_count * sizeof(*faces);
+
+    if (buffer)
+    {
+        files = (struct font_index_file *)(header + 1);
+        faces = (struct font_index_face *)(files + file_count);
+    }
+
+    for (i = 0; i < index_file_count; i++)
+    {
+        const struct index_file *file = &index_files[i];
+        struct font_index_file file_data;
+
+        if (i && !strcmp( file->path, index_files[i - 1].path )) continue;
+        for (j = 0; j < file->face_count; j++)
+        {
+            const struct index_face *face = &index_faces[file->first_face + j];
+            struct font_index_face data = face->data;
+
+            data.family_name  = add_index_string( buffer, &pos, face->family_name );
+            data.english_name = add_index_string( buffer, &pos, face->english_name );
+            data.style_name   = add_index_string( buffer, &pos, face->style_name );
+            data.full_name    = add_index_string( buffer, &pos, face->full_name );
+            if (buffer) faces[face_pos + j] = data;
+        }
+        file_data.path       = add_index_path( buffer, &pos, file->path );
+        file_data.result     = file->result;
+        file_data.size       = file->size;
+        file_data.mtime      = file->mtime;
+        file_data.first_face = face_pos;
+        file_data.face_count = file->face_count;
+        file_data.flags      = file->flags;
+        file_data.reserved   = 0;
+        if (buffer) files[file_pos] = file_data;
+        file_pos++;
+        face_pos += file->face_count;
+    }
+
+    if (buffer)
+    {
+        header->magic      = FONT_INDEX_MAGIC;
+        header->version    = FONT_INDEX_VERSION;
+        header->size       = pos;
+        header->langid     = GetSystemDefaultLangID();
+        header->file_count = file_count;
+        header->face_count = face_count;
+    }
+    return pos;
+}
+
+/* write the index of the fonts found while building the font list, if it changed */
+static void save_font_index(void)
+{
+    struct font_index_header *header;
+    unsigned int i, file_count = 0, face_count = 0;
+    char *path, *tmp_path;
+    DWORD size;
+    int fd;
+
+    qsort( index_files, index_file_count, sizeof(*index_files), compare_index_files );
+    for (i = 0; i < index_file_count; i++)
+    {
+        if (i && !strcmp( index_files[i].path, index_files[i - 1].path )) continue;
+        file_count++;
+        face_count += index_files[i].face_count;
+    }
+    if (!index_dirty && font_index && font_index->file_count == file_count) return;
+
+    size = build_font_index( NULL, file_count, face_count );
+    if (!(header = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return;
+    build_font_index( (char *)header, file_count, face_count );
+
+    if ((path = get_font_index_path()))
+    {
+        /* each process writes its own temp file, the last rename wins */
+        if ((tmp_path = HeapAlloc( GetProcessHeap(), 0, strlen(path) + sizeof(".4294967295.tmp") )))
+        {
+            sprintf( tmp_path, "%s.%u.tmp", path, GetCurrentProcessId() );
+            unlink( tmp_path );  /* left over from a dead process with the same id */
+            if ((fd = open( tmp_path, O_CREAT | O_EXCL | O_WRONLY, 0666 )) != -1)
+            {
+                BOOL ok = write( fd, header, size ) == size;
+
+                close( fd );
+                /* replace the file atomically, other processes may be reading it */
+                if (!ok || rename( tmp_path, path ) == -1)
+                {
+                    WARN( "failed to write %s\n", debugstr_a(path) );
+                    unlink( tmp_path );
+                }
+                else TRACE( "saved font index with %u files\n", file_count );
+            }
+            HeapFree( GetProcessHeap(), 0, tmp_path );
+        }
+        HeapFree( GetProcessHeap(), 0, path );
+    }
+    HeapFree( GetProcessHeap(), 0, header );
+}
+
+static void free_font_index(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < index_file_count; i++) HeapFree( GetProcessHeap(), 0, index_files[i].path );
+    for (i = 0; i < index_face_count; i++)
+    {
+        HeapFree( GetProcessHeap(), 0, index_faces[i].family_name );
+        HeapFree( GetProcessHeap(), 0, index_faces[i].english_name );
+        HeapFree( GetProcessHeap(), 0, index_faces[i].style_name );
+        HeapFree( GetProcessHeap(), 0, index_faces[i].full_name );
+    }
+    HeapFree( GetProcessHeap(), 0, index_files );
+    HeapFree( GetProcessHeap(), 0, index_faces );
+    index_files = NULL;
+    index_faces = NULL;
+    index_file_count = index_file_size = index_face_count = index_face_size = 0;
+    index_dirty = FALSE;
+
+    if (font_index) munmap( (void *)font_index, font_index->size );
+    font_index = NULL;
+}
+
+static INT load_font_faces( const char *file, void *font_data_ptr, DWORD font_data_size, DWORD flags );
+
 static INT AddFontToList(const char *file, void *font_data_ptr, DWORD font_data_size, DWORD flags)
 {
-    FT_Face ft_face;
-    FT_Long face_index = 0, num_faces;
-    INT ret = 0;
+    struct stat st;
+    INT ret;
 
     /* we always load external fonts from files - otherwise we would get a crash in update_reg_entries */
     assert(file || !(flags & ADDFONT_EXTERNAL_FONT));
@@ -2272,6 +2768,25 @@ static INT AddFontToList(const char *file, void *font_data_ptr, DWORD font_data_
     }
 #endif /* HAVE_CARBON_CARBON_H */
 
+    if (!file || !(flags & ADDFONT_ADD_TO_CACHE) || !index_building || stat( file, &st ) == -1)
+        return load_font_faces( file, font_data_ptr, font_data_size, flags );
+
+    if ((ret = add_font_from_index( file, &st, flags )) != -1) return ret;
+
+    index_dirty = TRUE;
+    index_current = add_index_file( file, &st, flags, 0 );
+    ret = load_font_faces( file, font_data_ptr, font_data_size, flags );
+    if (index_current) index_current->result = ret;
+    index_current = NULL;
+    return ret;
+}
+
+static INT load_font_faces( const char *file, void *font_data_ptr, DWORD font_data_size, DWORD flags )
+{
+    FT_Face ft_face;
+    FT_Long face_index = 0, num_faces;
+    INT ret = 0;
+
     do {
         const DWORD FS_DBCS_MASK = FS_JISJAPAN|FS_CHINESESIMP|FS_WANSUNG|FS_CHINESETRAD|FS_JOHAB;
         FONTSIGNATURE fs;
@@ -4227,6 +4742,9 @@ static void init_font_list(void)
 
     delete_external_font_keys();
 
+    load_font_index();
+    index_building = TRUE;
+
     /* load the system bitmap fonts */
     load_system_fonts();
 
@@ -4336,6 +4854,10 @@ static void init_font_list(void)
         }
         RegCloseKey(hkey);
     }
+
+    index_building = FALSE;
+    save_font_index();
+    free_font_index();
 }
 
 static BOOL move_to_front(const WCHAR *name)
@@ -2311,6 +2311,263 @@ static void test_import_resolution(void)
     }
 }
 
+struct reloc_data
+{
+    ULONG_PTR ptr;  /* points to itself once relocated */
+    IMAGE_BASE_RELOCATION rel;
+    WORD relocs[2];
+    IMAGE_EXPORT_DIRECTORY exports;  /* exports ptr */
+    DWORD function;
+    DWORD name;
+    WORD ordinal;
+    char export_name[4];
+};
+
+static void create_reloc_dll( char dll_name[MAX_PATH] )
+{
+    char temp_path[MAX_PATH];
+    struct reloc_data data;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    DWORD dummy;
+    HANDLE hfile;
+
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x12340000;
+    nt.OptionalHeader.SizeOfImage = 2 * page_size;
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].VirtualAddress =
+        page_size + FIELD_OFFSET( struct reloc_data, rel );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].Size =
+        sizeof(data.rel) + sizeof(data.relocs);
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress =
+        page_size + FIELD_OFFSET( struct reloc_data, exports );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].Size =
+        sizeof(data) - FIELD_OFFSET( struct reloc_data, exports );
+
+    memset( &data, 0, sizeof(data) );
+    data.ptr = nt.OptionalHeader.ImageBase + page_size;
+    data.rel.VirtualAddress = page_size;
+    data.rel.SizeOfBlock = sizeof(data.rel) + sizeof(data.relocs);
+#ifdef _WIN64
+    data.relocs[0] = IMAGE_REL_BASED_DIR64 << 12;
+#else
+    data.relocs[0] = IMAGE_REL_BASED_HIGHLOW << 12;
+#endif
+    data.relocs[1] = IMAGE_REL_BASED_ABSOLUTE << 12;
+    data.exports.Base = 1;
+    data.exports.NumberOfFunctions = 1;
+    data.exports.NumberOfNames = 1;
+    data.exports.AddressOfFunctions = page_size + FIELD_OFFSET( struct reloc_data, function );
+    data.exports.AddressOfNames = page_size + FIELD_OFFSET( struct reloc_data, name );
+    data.exports.AddressOfNameOrdinals = page_size + FIELD_OFFSET( struct reloc_data, ordinal );
+    data.function = page_size;
+    data.name = page_size + FIELD_OFFSET( struct reloc_data, export_name );
+    strcpy( data.export_name, "ptr" );
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".data", sizeof(".data") );
+    section.PointerToRawData = nt.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = sizeof(data);
+    section.SizeOfRawData = sizeof(data);
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    GetTempPathA( MAX_PATH, temp_path );
+    GetTempFileNameA( temp_path, "ldr", 0, dll_name );
+
+    hfile = CreateFileA( dll_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "creation failed\n" );
+    WriteFile( hfile, &dos_header, sizeof(dos_header), &dummy, NULL );
+    WriteFile( hfile, &nt, sizeof(nt), &dummy, NULL );
+    WriteFile( hfile, &section, sizeof(section), &dummy, NULL );
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile( hfile, &data, sizeof(data), &dummy, NULL );
+    CloseHandle( hfile );
+}
+
+/* load the relocation test dll away from its base and check its relocated data */
+static HMODULE load_relocated_dll( const char *dll_name )
+{
+    struct reloc_data *data;
+    HMODULE mod;
+
+    mod = LoadLibraryA( dll_name );
+    ok( mod != NULL, "failed to load err %u\n", GetLastError() );
+    if (!mod) return NULL;
+    ok( mod != (HMODULE)0x12340000, "dll not relocated\n" );
+    data = (struct reloc_data *)((char *)mod + page_size);
+    ok( data->ptr == (ULONG_PTR)data, "wrong relocated pointer %p for %p\n", (void *)data->ptr, data );
+    return mod;
+}
+
+static void child_relocated_dll( const char *dll_name )
+{
+    void *reserved;
+    HMODULE mod;
+
+    reserved = VirtualAlloc( (void *)0x12340000, 2 * page_size, MEM_RESERVE, PAGE_NOACCESS );
+    ok( reserved != NULL, "VirtualAlloc failed err %u\n", GetLastError() );
+    if ((mod = load_relocated_dll( dll_name ))) FreeLibrary( mod );
+    VirtualFree( reserved, 0, MEM_RELEASE );
+}
+
+static void test_relocated_dll(void)
+{
+    char dll_name[MAX_PATH], cmdline[MAX_PATH * 2];
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    struct reloc_data *data;
+    void *reserved;
+    HMODULE mod;
+    char **argv;
+    BOOL ret;
+    int i;
+
+    winetest_get_mainargs( &argv );
+    create_reloc_dll( dll_name );
+
+    /* keep the preferred base busy so that the dll is always relocated */
+    reserved = VirtualAlloc( (void *)0x12340000, 2 * page_size, MEM_RESERVE, PAGE_NOACCESS );
+    ok( reserved != NULL, "VirtualAlloc failed err %u\n", GetLastError() );
+
+    /* changes to a loaded copy must not show up in later loads */
+    for (i = 0; i < 3; i++)
+    {
+        if (!(mod = load_relocated_dll( dll_name ))) break;
+        data = (struct reloc_data *)((char *)mod + page_size);
+        data->ptr = 0xdeadbeef;
+        FreeLibrary( mod );
+    }
+
+    /* nor in other processes loading it at the same time */
+    if ((mod = load_relocated_dll( dll_name )))
+    {
+        data = (struct reloc_data *)((char *)mod + page_size);
+        data->ptr = 0xdeadbeef;
+        for (i = 0; i < 2; i++)
+        {
+            sprintf( cmdline, "\"%s\" loader relocated_dll %s", argv[0], dll_name );
+            ret = CreateProcessA( argv[0], cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+            ok( ret, "CreateProcess(%s) error %d\n", cmdline, GetLastError() );
+            if (!ret) break;
+            wait_child_process( pi.hProcess );
+            CloseHandle( pi.hThread );
+            CloseHandle( pi.hProcess );
+        }
+        ok( data->ptr == 0xdeadbeef, "data changed to %p\n", (void *)data->ptr );
+        FreeLibrary( mod );
+    }
+
+    VirtualFree( reserved, 0, MEM_RELEASE );
+    DeleteFileA( dll_name );
+}
+
+/* a dll importing several independent dlls, which may be mapped in parallel */
+static void test_import_graph(void)
+{
+    char temp_path[MAX_PATH], dll_name[MAX_PATH], import_names[6][MAX_PATH];
+    struct imports
+    {
+        IMAGE_IMPORT_DESCRIPTOR descr[ARRAY_SIZE(import_names) + 1];
+        IMAGE_THUNK_DATA original_thunks[ARRAY_SIZE(import_names)][2];
+        IMAGE_THUNK_DATA thunks[ARRAY_SIZE(import_names)][2];
+        struct { WORD hint; char name[4]; } function;
+        char modules[ARRAY_SIZE(import_names)][MAX_PATH];
+    } *data, *ptr;
+    struct reloc_data *reloc;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+    HMODULE mod, imports[ARRAY_SIZE(import_names)];
+    void *reserved;
+    DWORD dummy;
+    HANDLE hfile;
+    int i;
+
+    /* keep the preferred base busy so that all the imports are relocated */
+    reserved = VirtualAlloc( (void *)0x12340000, 2 * page_size, MEM_RESERVE, PAGE_NOACCESS );
+    ok( reserved != NULL, "VirtualAlloc failed err %u\n", GetLastError() );
+
+    data = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*data) );
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)data))
+    for (i = 0; i < ARRAY_SIZE(import_names); i++)
+    {
+        create_reloc_dll( import_names[i] );
+        strcpy( data->modules[i], strrchr( import_names[i], '\\' ) + 1 );
+        U(data->descr[i]).OriginalFirstThunk = DATA_RVA( data->original_thunks[i] );
+        data->descr[i].FirstThunk = DATA_RVA( data->thunks[i] );
+        data->descr[i].Name = DATA_RVA( data->modules[i] );
+        data->original_thunks[i][0].u1.AddressOfData = DATA_RVA( &data->function );
+        data->thunks[i][0].u1.AddressOfData = DATA_RVA( &data->function );
+    }
+    strcpy( data->function.name, "ptr" );
+
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x10000000;
+    nt.OptionalHeader.SizeOfImage = page_size + ((sizeof(*data) + page_size - 1) & ~(page_size - 1));
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].Size = sizeof(data->descr);
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DATA_RVA( data->descr );
+#undef DATA_RVA
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".data", sizeof(".data") );
+    section.PointerToRawData = nt.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = sizeof(*data);
+    section.SizeOfRawData = sizeof(*data);
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    GetTempPathA( MAX_PATH, temp_path );
+    GetTempFileNameA( temp_path, "ldr", 0, dll_name );
+    hfile = CreateFileA( dll_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "creation failed\n" );
+    WriteFile( hfile, &dos_header, sizeof(dos_header), &dummy, NULL );
+    WriteFile( hfile, &nt, sizeof(nt), &dummy, NULL );
+    WriteFile( hfile, &section, sizeof(section), &dummy, NULL );
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile( hfile, data, sizeof(*data), &dummy, NULL );
+    CloseHandle( hfile );
+
+    mod = LoadLibraryExA( dll_name, 0, LOAD_WITH_ALTERED_SEARCH_PATH );
+    ok( mod != NULL, "failed to load err %u\n", GetLastError() );
+    if (mod)
+    {
+        ptr = (struct imports *)((char *)mod + page_size);
+        for (i = 0; i < ARRAY_SIZE(import_names); i++)
+        {
+            imports[i] = GetModuleHandleA( data->modules[i] );
+            ok( imports[i] != NULL, "%s not loaded\n", data->modules[i] );
+            if (!imports[i]) continue;
+            reloc = (struct reloc_data *)((char *)imports[i] + page_size);
+            ok( reloc->ptr == (ULONG_PTR)reloc, "%s: wrong relocated pointer %p for %p\n",
+                data->modules[i], (void *)reloc->ptr, reloc );
+            ok( ptr->thunks[i][0].u1.Function == (ULONG_PTR)reloc, "%s: thunk %p instead of %p\n",
+                data->modules[i], (void *)ptr->thunks[i][0].u1.Function, reloc );
+        }
+        FreeLibrary( mod );
+        for (i = 0; i < ARRAY_SIZE(import_names); i++)
+            ok( !GetModuleHandleA( data->modules[i] ), "%s still loaded\n", data->modules[i] );
+    }
+
+    for (i = 0; i < ARRAY_SIZE(import_names); i++) DeleteFileA( import_names[i] );
+    DeleteFileA( dll_name );
+    HeapFree( GetProcessHeap(), 0, data );
+    VirtualFree( reserved, 0, MEM_RELEASE );
+}
+
 #define MAX_COUNT 10
 static HANDLE attached_thread[MAX_COUNT];
 static DWORD attached_thread_count;
@@ -4181,6 +4438,11 @@ START_TEST(loader)
         *child_failures = -1;
 
     argc = winetest_get_mainargs(&argv);
+    if (argc > 3 && !strcmp( argv[2], "relocated_dll" ))
+    {
+        child_relocated_dll( argv[3] );
+        return;
+    }
     if (argc > 4)
     {
         test_dll_phase = atoi(argv[4]);
@@ -4194,6 +4456,8 @@ START_TEST(loader)
     test_ImportDescriptors();
     test_section_access();
     test_import_resolution();
+    test_relocated_dll();
+    test_import_graph();
     test_ExitProcess();
     test_InMemoryOrderModuleList();
     test_LoadPackagedLibrary();
@@ -52,6 +52,7 @@ static ULONG  (WINAPI *pRtlRemoveVectoredExceptionHandler)(PVOID);
 static BOOL   (WINAPI *pGetProcessDEPPolicy)(HANDLE, LPDWORD, PBOOL);
 static BOOL   (WINAPI *pIsWow64Process)(HANDLE, PBOOL);
 static NTSTATUS (WINAPI *pNtProtectVirtualMemory)(HANDLE, PVOID *, SIZE_T *, ULONG, ULONG *);
+static SIZE_T (WINAPI *pGetLargePageMinimum)(void);
 
 /* ############################### */
 
@@ -468,6 +469,90 @@ static void test_VirtualAlloc(void)
     ok(VirtualFree(addr1, 0, MEM_RELEASE), "VirtualFree failed\n");
 }
 
+static BOOL enable_lock_memory_privilege(void)
+{
+    TOKEN_PRIVILEGES privs;
+    HANDLE token;
+    BOOL ret;
+
+    if (!OpenProcessToken( GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token )) return FALSE;
+    privs.PrivilegeCount = 1;
+    privs.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    ret = LookupPrivilegeValueA( NULL, SE_LOCK_MEMORY_NAME, &privs.Privileges[0].Luid ) &&
+          AdjustTokenPrivileges( token, FALSE, &privs, sizeof(privs), NULL, NULL ) &&
+          GetLastError() == ERROR_SUCCESS;
+    CloseHandle( token );
+    return ret;
+}
+
+static void test_large_pages(void)
+{
+    MEMORY_BASIC_INFORMATION info;
+    SIZE_T size;
+    void *addr;
+    BOOL ret;
+    int i;
+
+    if (!pGetLargePageMinimum)
+    {
+        win_skip( "GetLargePageMinimum not supported\n" );
+        return;
+    }
+    if (!(size = pGetLargePageMinimum()))
+    {
+        skip( "large pages not supported\n" );
+        return;
+    }
+
+    SetLastError( 0xdeadbeef );
+    addr = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+    if (addr)
+    {
+        skip( "large pages are allowed without enabling the privilege\n" );
+        VirtualFree( addr, 0, MEM_RELEASE );
+    }
+    else ok( GetLastError() == ERROR_PRIVILEGE_NOT_HELD, "wrong error %u\n", GetLastError() );
+
+    if (!enable_lock_memory_privilege())
+    {
+        skip( "SeLockMemoryPrivilege not held\n" );
+        return;
+    }
+
+    SetLastError( 0xdeadbeef );
+    addr = VirtualAlloc( NULL, size - si.dwPageSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+    ok( !addr, "VirtualAlloc succeeded with unaligned size\n" );
+    ok( GetLastError() == ERROR_INVALID_PARAMETER, "wrong error %u\n", GetLastError() );
+
+    SetLastError( 0xdeadbeef );
+    addr = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE );
+    ok( !addr, "VirtualAlloc succeeded without MEM_COMMIT\n" );
+    ok( GetLastError() == ERROR_INVALID_PARAMETER, "wrong error %u\n", GetLastError() );
+
+    for (i = 1; i <= 3; i++)
+    {
+        addr = VirtualAlloc( NULL, i * size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+        if (!addr && GetLastError() == ERROR_NO_SYSTEM_RESOURCES)
+        {
+            skip( "not enough large pages available\n" );
+            break;
+        }
+        ok( addr != NULL, "VirtualAlloc failed %u\n", GetLastError() );
+        if (!addr) break;
+        ok( !((UINT_PTR)addr & (size - 1)), "%p is not aligned to %#lx\n", addr, size );
+
+        ok( VirtualQuery( addr, &info, sizeof(info) ) == sizeof(info), "VirtualQuery failed\n" );
+        ok( info.AllocationBase == addr, "wrong allocation base %p / %p\n", info.AllocationBase, addr );
+        ok( info.RegionSize == i * size, "wrong size %#lx / %#lx\n", info.RegionSize, i * size );
+        ok( info.State == MEM_COMMIT, "wrong state %#x\n", info.State );
+        ok( info.Protect == PAGE_READWRITE, "wrong protection %#x\n", info.Protect );
+        ((char *)addr)[i * size - 1] = 1;
+
+        ret = VirtualFree( addr, 0, MEM_RELEASE );
+        ok( ret, "VirtualFree failed %u\n", GetLastError() );
+    }
+}
+
 static void test_MapViewOfFile(void)
 {
     static const char testfile[] = "testfile.xxx";
@@ -4492,6 +4577,7 @@ START_TEST(virtual)
     pRtlAddVectoredExceptionHandler = (void *)GetProcAddress( hntdll, "RtlAddVectoredExceptionHandler" );
     pRtlRemoveVectoredExceptionHandler = (void *)GetProcAddress( hntdll, "RtlRemoveVectoredExceptionHandler" );
     pNtProtectVirtualMemory = (void *)GetProcAddress( hntdll, "NtProtectVirtualMemory" );
+    pGetLargePageMinimum = (void *)GetProcAddress( hkernel32, "GetLargePageMinimum" );
 
     GetSystemInfo(&si);
     trace("system page size %#x\n", si.dwPageSize);
@@ -4507,6 +4593,7 @@ START_TEST(virtual)
     test_VirtualProtect();
     test_VirtualAllocEx();
     test_VirtualAlloc();
+    test_large_pages();
     test_MapViewOfFile();
     test_NtAreMappedFilesTheSame();
     test_CreateFileMapping();
@@ -443,6 +443,7 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
         return STATUS_SUCCESS;
     }
 
+    get_thread_counters()->sync_waits++;
     for (;;)
     {
         EXCEPTION_RECORD rec;
@@ -191,6 +191,9 @@ LONG call_vectored_handlers( EXCEPTION_RECORD *rec, CONTEXT *context )
     except_ptrs.ExceptionRecord = rec;
     except_ptrs.ContextRecord = context;
 
+    /* this is the first step of every exception dispatch */
+    get_thread_counters()->exceptions++;
+
     RtlEnterCriticalSection( &vectored_handlers_section );
     ptr = list_head( &vectored_exception_handlers );
     while (ptr)
@@ -542,9 +545,8 @@ BOOLEAN CDECL RtlDeleteFunctionTable( RUNTIME_FUNCTION *table )
 }
 
 
-/* helper for lookup_function_info() */
-static RUNTIME_FUNCTION *find_function_info( ULONG_PTR pc, ULONG_PTR base,
-                                             RUNTIME_FUNCTION *func, ULONG size )
+/* find the function entry for an address in a function table */
+RUNTIME_FUNCTION *find_function_info( ULONG_PTR pc, ULONG_PTR base, RUNTIME_FUNCTION *func, ULONG size )
 {
     int min = 0;
     int max = size - 1;
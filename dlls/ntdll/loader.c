@@ -53,6 +53,7 @@ WINE_DECLARE_DEBUG_CHANNEL(relay);
 WINE_DECLARE_DEBUG_CHANNEL(snoop);
 WINE_DECLARE_DEBUG_CHANNEL(loaddll);
 WINE_DECLARE_DEBUG_CHANNEL(imports);
+WINE_DECLARE_DEBUG_CHANNEL(loadtime);
 
 #ifdef _WIN64
 #define DEFAULT_SECURITY_COOKIE_64  (((ULONGLONG)0x00002b99 << 32) | 0x2ddfa232)
@@ -141,6 +142,8 @@ typedef struct _wine_modref
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    DWORD                *export_hash;       /* hash table of exported names, built on first use */
+    DWORD                 export_hash_mask;  /* size of the hash table minus one */
 } WINE_MODREF;
 
 /* info about the current builtin dll load */
@@ -191,9 +194,14 @@ static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
 static WINE_MODREF *last_failed_modref;
 
+static ULONGLONG load_child_time;  /* time spent loading the dependencies of the current dll */
+
 static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, const WCHAR *default_ext,
                           DWORD flags, WINE_MODREF** pwm );
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved );
+static void queue_import_work( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *imports, int count,
+                               LPCWSTR load_path );
+static void cancel_import_work( WINE_MODREF *wm );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                     DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
 static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -806,6 +814,63 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+/*************************************************************************
+ *		get_load_time
+ *
+ * Return the current time in microseconds, for the loadtime channel.
+ */
+static ULONGLONG get_load_time(void)
+{
+    LARGE_INTEGER counter, freq;
+
+    NtQueryPerformanceCounter( &counter, &freq );
+    return counter.QuadPart / freq.QuadPart * 1000000 + counter.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart;
+}
+
+
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 0;
+
+    while (*name) hash = hash * 31 + (unsigned char)*name++;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Return the hash table of the exported names of a module, building it on first use.
+ * Entries are indices in the names table plus one, zero marks an empty slot.
+ * The loader_section must be locked while calling this function.
+ */
+static const DWORD *get_export_hash( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    const DWORD *names = get_rva( wm->ldr.DllBase, exports->AddressOfNames );
+    DWORD i, pos, size;
+    DWORD *table;
+
+    if (wm->export_hash) return wm->export_hash;
+    if (exports->NumberOfNames < 16) return NULL;  /* not worth it, use a binary search */
+
+    for (size = 32; size < 2 * exports->NumberOfNames; size *= 2) ;
+    if (!(table = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*table) ))) return NULL;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( wm->ldr.DllBase, names[i] )) & (size - 1);
+        while (table[pos]) pos = (pos + 1) & (size - 1);
+        table[pos] = i + 1;
+    }
+    wm->export_hash = table;
+    wm->export_hash_mask = size - 1;
+    return table;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -818,6 +883,9 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
+    const DWORD *hash;
+    WINE_MODREF *wm;
+    DWORD pos;
 
     /* first check the hint */
     if (hint >= 0 && hint <= max)
@@ -827,6 +895,19 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
+    /* then look it up in the hash table */
+    if ((wm = get_modref( module )) && (hash = get_export_hash( wm, exports )))
+    {
+        for (pos = hash_export_name( name ) & wm->export_hash_mask; hash[pos];
+             pos = (pos + 1) & wm->export_hash_mask)
+        {
+            char *ename = get_rva( module, names[hash[pos] - 1] );
+            if (!strcmp( ename, name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[hash[pos] - 1], load_path );
+        }
+        return NULL;
+    }
+
     /* then do a binary search */
     while (min <= max)
     {
@@ -1239,6 +1320,8 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     prev = current_modref;
     current_modref = wm;
     status = STATUS_SUCCESS;
+    /* map the other imports on worker threads while the first one is being loaded */
+    queue_import_work( wm, imports + 1, nb_imports - 1, load_path );
     for (i = 0; i < nb_imports; i++)
     {
         dep = wm->nDeps++;
@@ -1250,6 +1333,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
         }
         wm->deps[dep] = imp;
     }
+    cancel_import_work( wm );
     current_modref = prev;
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
@@ -1314,6 +1398,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
         WARN( "disabling no-exec because of %s\n", debugstr_w(wm->ldr.BaseDllName.Buffer) );
         NtSetInformationProcess( GetCurrentProcess(), ProcessExecuteFlags, &flags, sizeof(flags) );
     }
+    profile_add_module( hModule );
     return wm;
 }
 
@@ -1599,10 +1684,15 @@ static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
     if (status == STATUS_SUCCESS)
     {
         WINE_MODREF *prev = current_modref;
+        ULONGLONG start_time = TRACE_ON(loadtime) ? get_load_time() : 0;
+
         current_modref = wm;
 
         call_ldr_notifications( LDR_DLL_NOTIFICATION_REASON_LOADED, &wm->ldr );
         status = MODULE_InitDLL( wm, DLL_PROCESS_ATTACH, lpReserved );
+        if (start_time)
+            TRACE_(loadtime)( "%s: attach %s us\n", debugstr_w(wm->ldr.BaseDllName.Buffer),
+                              wine_dbgstr_longlong( get_load_time() - start_time ));
         if (status == STATUS_SUCCESS)
         {
             wm->ldr.Flags |= LDR_PROCESS_ATTACHED;
@@ -2255,6 +2345,17 @@ static NTSTATUS perform_relocations( void *module, IMAGE_NT_HEADERS *nt, SIZE_T
                                 &size, protect_old[i], &protect_old[i] );
     }
 
+    /* like on Windows, the mapped header reflects the actual load address */
+    {
+        void *addr = &nt->OptionalHeader.ImageBase;
+        SIZE_T size = sizeof(nt->OptionalHeader.ImageBase);
+        ULONG old;
+
+        NtProtectVirtualMemory( NtCurrentProcess(), &addr, &size, PAGE_READWRITE, &old );
+        nt->OptionalHeader.ImageBase = (ULONG_PTR)module;
+        NtProtectVirtualMemory( NtCurrentProcess(), &addr, &size, old, &old );
+    }
+
     return STATUS_SUCCESS;
 }
 
@@ -2501,6 +2602,8 @@ static NTSTATUS get_dll_load_path_search_flags( LPCWSTR module, DWORD flags, WCH
  *	open_dll_file
  *
  * Open a file for a new dll. Helper for find_dll_file.
+ * The loaded modules are not checked if pwm is NULL, which allows
+ * calling it without holding the loader_section.
  */
 static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
                                void **module, pe_image_info_t *image_info, struct stat *st )
@@ -2514,7 +2617,7 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
     HANDLE handle, mapping;
     int fd, needs_close;
 
-    if ((*pwm = find_fullname_module( nt_name )))
+    if (pwm && (*pwm = find_fullname_module( nt_name )))
     {
         NtUnmapViewOfSection( NtCurrentProcess(), *module );
         *module = NULL;
@@ -2546,7 +2649,7 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm,
     {
         fstat( fd, st );
         if (needs_close) close( fd );
-        if ((*pwm = find_fileid_module( st )))
+        if (pwm && (*pwm = find_fileid_module( st )))
         {
             TRACE( "%s is the same file as existing module %p %s\n", debugstr_w( nt_name->Buffer ),
                    (*pwm)->ldr.DllBase, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
@@ -3154,6 +3257,251 @@ done:
 }
 
 
+/* import mapped ahead of time by a loader worker thread */
+struct load_work
+{
+    struct list      entry;
+    WINE_MODREF     *owner;       /* module importing the dll */
+    LPCWSTR          load_path;
+    WCHAR           *name;
+    enum { WORK_QUEUED, WORK_RUNNING, WORK_DONE, WORK_TAKEN } state;
+    NTSTATUS         status;      /* search_dll_file results */
+    UNICODE_STRING   nt_name;
+    void            *module;
+    pe_image_info_t  image_info;
+    struct stat      st;
+};
+
+#define MAX_LOADER_WORKERS 3
+
+static struct list load_work_list = LIST_INIT( load_work_list );
+static RTL_CONDITION_VARIABLE load_work_queued;
+static RTL_CONDITION_VARIABLE load_work_done;
+static unsigned int load_worker_count;
+
+static RTL_CRITICAL_SECTION load_work_section;
+static RTL_CRITICAL_SECTION_DEBUG load_work_critsect_debug =
+{
+    0, 0, &load_work_section,
+    { &load_work_critsect_debug.ProcessLocksList, &load_work_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": load_work_section") }
+};
+static RTL_CRITICAL_SECTION load_work_section = { &load_work_critsect_debug, -1, 0, 0, 0, 0 };
+
+
+/***********************************************************************
+ *	loader_worker_thread
+ *
+ * Thread that maps and relocates the queued imports. It doesn't take the
+ * loader_section, LdrInitializeThunk and LdrShutdownThread skip it.
+ */
+static DWORD WINAPI loader_worker_thread( void *arg )
+{
+    LARGE_INTEGER timeout;
+    struct load_work *work;
+    ULONG wow64_old_value;
+
+    if (is_wow64) RtlWow64EnableFsRedirectionEx( 0, &wow64_old_value );
+
+    timeout.QuadPart = -10 * (ULONGLONG)1000 * 1000;  /* exit after one second without work */
+
+    RtlEnterCriticalSection( &load_work_section );
+    for (;;)
+    {
+        LIST_FOR_EACH_ENTRY( work, &load_work_list, struct load_work, entry )
+            if (work->state == WORK_QUEUED) break;
+
+        if (&work->entry == &load_work_list)
+        {
+            if (RtlSleepConditionVariableCS( &load_work_queued, &load_work_section, &timeout ) == STATUS_TIMEOUT)
+                break;
+            continue;
+        }
+        work->state = WORK_RUNNING;
+        RtlLeaveCriticalSection( &load_work_section );
+
+        work->status = search_dll_file( work->load_path, work->name, &work->nt_name, NULL,
+                                        &work->module, &work->image_info, &work->st );
+        if (!work->status && !(work->image_info.image_flags & (IMAGE_FLAGS_WineBuiltin | IMAGE_FLAGS_WineFakeDll)) &&
+            perform_relocations( work->module, RtlImageNtHeader( work->module ), work->image_info.map_size ))
+        {
+            /* let the main thread load it again and report the error */
+            NtUnmapViewOfSection( NtCurrentProcess(), work->module );
+            work->module = NULL;
+            work->status = STATUS_RETRY;
+        }
+
+        RtlEnterCriticalSection( &load_work_section );
+        work->state = WORK_DONE;
+        RtlWakeAllConditionVariable( &load_work_done );
+    }
+    load_worker_count--;
+    RtlLeaveCriticalSection( &load_work_section );
+    return 0;
+}
+
+
+/***********************************************************************
+ *	queue_import_work
+ *
+ * Queue the imports of a module that still need to be loaded, so that
+ * the worker threads map them while the loader resolves the other ones.
+ * Only the file search, mapping and relocation are done by the workers;
+ * the modules are still created and attached in order by the loader.
+ * The loader_section must be locked while calling this function.
+ */
+static void queue_import_work( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *imports, int count,
+                               LPCWSTR load_path )
+{
+    struct load_work *work;
+    unsigned int queued = 0;
+    WCHAR *name, *fullname;
+    const char *str;
+    NTSTATUS status;
+    HANDLE thread;
+    DWORD len;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        const IMAGE_THUNK_DATA *import_list = get_rva( wm->ldr.DllBase, imports[i].u.OriginalFirstThunk ?
+                                                       imports[i].u.OriginalFirstThunk : imports[i].FirstThunk );
+
+        if (!import_list->u1.Ordinal) continue;  /* unused import */
+
+        str = get_rva( wm->ldr.DllBase, imports[i].Name );
+        for (len = strlen( str ); len && str[len - 1] == ' '; len--) ;
+        if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, (len + ARRAY_SIZE(dllW)) * sizeof(WCHAR) ))) break;
+        ascii_to_unicode( name, str, len );
+        name[len] = 0;
+        if (!wcschr( name, '.' )) wcscat( name, dllW );
+
+        /* only the imports that find_dll_file would search for */
+        status = STATUS_SUCCESS;
+        if (!contains_path( name ) && !find_basename_module( name ) &&
+            !(status = find_actctx_dll( name, &fullname )))
+            RtlFreeHeap( GetProcessHeap(), 0, fullname );
+        if (status != STATUS_SXS_KEY_NOT_FOUND)
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, name );
+            continue;
+        }
+        LIST_FOR_EACH_ENTRY( work, &load_work_list, struct load_work, entry )
+            if (work->state != WORK_TAKEN && work->load_path == load_path && !wcsicmp( work->name, name )) break;
+        if (&work->entry != &load_work_list ||
+            !(work = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*work) )))
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, name );
+            continue;
+        }
+        work->owner = wm;
+        work->load_path = load_path;
+        work->name = name;
+        work->state = WORK_QUEUED;
+
+        RtlEnterCriticalSection( &load_work_section );
+        list_add_tail( &load_work_list, &work->entry );
+        RtlLeaveCriticalSection( &load_work_section );
+        queued++;
+    }
+    if (!queued) return;
+
+    RtlEnterCriticalSection( &load_work_section );
+    while (load_worker_count < min( queued, MAX_LOADER_WORKERS ))
+    {
+        if (RtlCreateUserThread( NtCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                                 (PRTL_THREAD_START_ROUTINE)loader_worker_thread, NULL, &thread, NULL ))
+            break;
+        NtClose( thread );
+        load_worker_count++;
+    }
+    RtlWakeAllConditionVariable( &load_work_queued );
+    RtlLeaveCriticalSection( &load_work_section );
+}
+
+
+/***********************************************************************
+ *	cancel_import_work
+ *
+ * Free the work queued for the imports of a module once they are loaded.
+ * The loader_section must be locked while calling this function.
+ */
+static void cancel_import_work( WINE_MODREF *wm )
+{
+    struct load_work *work, *next;
+    struct list done = LIST_INIT( done );
+
+    RtlEnterCriticalSection( &load_work_section );
+    LIST_FOR_EACH_ENTRY_SAFE( work, next, &load_work_list, struct load_work, entry )
+    {
+        if (work->owner != wm) continue;
+        while (work->state == WORK_RUNNING)
+            RtlSleepConditionVariableCS( &load_work_done, &load_work_section, NULL );
+        list_remove( &work->entry );
+        list_add_tail( &done, &work->entry );
+    }
+    RtlLeaveCriticalSection( &load_work_section );
+
+    LIST_FOR_EACH_ENTRY_SAFE( work, next, &done, struct load_work, entry )
+    {
+        if (work->module) NtUnmapViewOfSection( NtCurrentProcess(), work->module );
+        RtlFreeUnicodeString( &work->nt_name );
+        RtlFreeHeap( GetProcessHeap(), 0, work->name );
+        RtlFreeHeap( GetProcessHeap(), 0, work );
+    }
+}
+
+
+/***********************************************************************
+ *	take_import_work
+ *
+ * Get the results of search_dll_file from a worker thread, if the dll
+ * was queued. Return FALSE if the caller has to search for it itself.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL take_import_work( LPCWSTR load_path, LPCWSTR name, UNICODE_STRING *nt_name,
+                              WINE_MODREF **pwm, void **module, pe_image_info_t *image_info,
+                              struct stat *st, NTSTATUS *status )
+{
+    struct load_work *work;
+
+    RtlEnterCriticalSection( &load_work_section );
+    LIST_FOR_EACH_ENTRY( work, &load_work_list, struct load_work, entry )
+        if (work->state != WORK_TAKEN && work->load_path == load_path && !wcsicmp( work->name, name )) break;
+
+    if (&work->entry == &load_work_list || work->state == WORK_QUEUED)
+    {
+        /* not started yet, it's faster to load it directly */
+        if (&work->entry != &load_work_list) work->state = WORK_TAKEN;
+        RtlLeaveCriticalSection( &load_work_section );
+        return FALSE;
+    }
+    while (work->state == WORK_RUNNING)
+        RtlSleepConditionVariableCS( &load_work_done, &load_work_section, NULL );
+    work->state = WORK_TAKEN;
+    RtlLeaveCriticalSection( &load_work_section );
+
+    if (work->status == STATUS_RETRY) return FALSE;
+
+    TRACE( "using %s mapped at %p by a worker thread\n", debugstr_w(name), work->module );
+    *status = work->status;
+    *nt_name = work->nt_name;
+    *module = work->module;
+    *image_info = work->image_info;
+    *st = work->st;
+    work->nt_name.Buffer = NULL;
+    work->module = NULL;
+
+    /* the worker doesn't look at the loaded modules */
+    if (!*status && ((*pwm = find_fullname_module( nt_name )) || (*pwm = find_fileid_module( st ))))
+    {
+        NtUnmapViewOfSection( NtCurrentProcess(), *module );
+        *module = NULL;
+    }
+    return TRUE;
+}
+
+
 /***********************************************************************
  *	find_dll_file
  *
@@ -3212,7 +3560,10 @@ static NTSTATUS find_dll_file( const WCHAR *load_path, const WCHAR *libname, con
     }
 
     if (RtlDetermineDosPathNameType_U( libname ) == RELATIVE_PATH)
-        status = search_dll_file( load_path, libname, nt_name, pwm, module, image_info, st );
+    {
+        if (!take_import_work( load_path, libname, nt_name, pwm, module, image_info, st, &status ))
+            status = search_dll_file( load_path, libname, nt_name, pwm, module, image_info, st );
+    }
     else if (!(status = RtlDosPathNameToNtPathName_U_WithStatus( libname, nt_name, NULL, NULL )))
         status = open_dll_file( nt_name, pwm, module, image_info, st );
 
@@ -3241,9 +3592,16 @@ static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, const WC
     void *module;
     pe_image_info_t image_info;
     NTSTATUS nts;
+    ULONGLONG start_time = 0, parent_child_time = load_child_time;
 
     TRACE( "looking for %s in %s\n", debugstr_w(libname), debugstr_w(load_path) );
 
+    if (TRACE_ON(loadtime))
+    {
+        start_time = get_load_time();
+        load_child_time = 0;
+    }
+
     nts = find_dll_file( load_path, libname, default_ext, &nt_name, pwm, &module, &image_info, &st );
 
     if (*pwm)  /* found already loaded module */
@@ -3254,6 +3612,7 @@ static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, const WC
               debugstr_w((*pwm)->ldr.FullDllName.Buffer), debugstr_w(libname),
               (*pwm)->ldr.DllBase, (*pwm)->ldr.LoadCount);
         RtlFreeUnicodeString( &nt_name );
+        load_child_time = parent_child_time;
         return STATUS_SUCCESS;
     }
 
@@ -3360,6 +3719,16 @@ done:
     else
         WARN("Failed to load module %s; status=%x\n", debugstr_w(libname), nts);
 
+    if (start_time)
+    {
+        ULONGLONG total = get_load_time() - start_time;
+
+        TRACE_(loadtime)( "%s: load %s us, %s us excluding dependencies\n", debugstr_us(&nt_name),
+                          wine_dbgstr_longlong( total ), wine_dbgstr_longlong( total - load_child_time ));
+        load_child_time = parent_child_time + total;
+    }
+    else load_child_time = parent_child_time;
+
     RtlFreeUnicodeString( &nt_name );
     return nts;
 }
@@ -3797,6 +4166,7 @@ void WINAPI RtlExitUserProcess( DWORD status )
     RtlEnterCriticalSection( &loader_section );
     RtlAcquirePebLock();
     NtTerminateProcess( 0, status );
+    profile_dump();
     LdrShutdownProcess();
     NtTerminateProcess( GetCurrentProcess(), status );
     exit( get_unix_exit_code( status ));
@@ -3818,6 +4188,9 @@ void WINAPI LdrShutdownThread(void)
     /* don't do any detach calls if process is exiting */
     if (process_detaching) return;
 
+    /* loader workers are not attached */
+    if (ntdll_get_thread_data()->loader_worker) return;
+
     if (NtCurrentTeb()->FlsSlots)
     {
         lock_fls_section( NULL );
@@ -3884,11 +4257,13 @@ static void free_modref( WINE_MODREF *wm )
 
     free_tls_slot( &wm->ldr );
     RtlReleaseActivationContext( wm->ldr.ActivationContext );
+    profile_remove_module( wm->ldr.DllBase );
     if (wm->so_handle) dlclose( wm->so_handle );
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.DllBase );
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -4049,6 +4424,13 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, void **entry, ULONG_PTR unknow
 
     if (process_detaching) return;
 
+    /* the loader workers run while the loader_section is held */
+    if (*entry == (void *)loader_worker_thread)
+    {
+        ntdll_get_thread_data()->loader_worker = TRUE;
+        return;
+    }
+
     RtlEnterCriticalSection( &loader_section );
 
     wm = get_modref( NtCurrentTeb()->Peb->ImageBaseAddress );
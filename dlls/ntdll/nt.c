@@ -2667,6 +2667,98 @@ static void get_ntdll_system_module(SYSTEM_MODULE *sm)
     sm->NameOffset = (ptr != NULL) ? (ptr - str.Buffer + 1) : 0;
 }
 
+/* read the instrumentation counters of a thread from its TEB */
+static BOOL read_thread_counters( HANDLE process, client_ptr_t teb, struct thread_counters *counters )
+{
+    return !NtReadVirtualMemory( process, (char *)wine_server_get_ptr( teb ) + FIELD_OFFSET( TEB, GdiTebBatch ) +
+                                 FIELD_OFFSET( struct ntdll_thread_data, counters ),
+                                 counters, sizeof(*counters), NULL );
+}
+
+static void add_thread_counters( SYSTEM_WINE_COUNTERS_INFORMATION *info, const struct thread_counters *counters )
+{
+    info->ServerCalls     += counters->server_calls;
+    info->SyncWaits       += counters->sync_waits;
+    info->HeapAllocations += counters->heap_allocs;
+    info->PageFaults      += counters->page_faults;
+    info->Exceptions      += counters->exceptions;
+}
+
+/***********************************************************************
+ *           get_wine_counters
+ *
+ * Sum the instrumentation counters of all the threads of a process,
+ * including the ones that have already exited. The counters are read
+ * while the threads keep updating them, so the result is approximate.
+ */
+static NTSTATUS get_wine_counters( SYSTEM_WINE_COUNTERS_INFORMATION *info )
+{
+    ULONG pid = info->ProcessId ? info->ProcessId : HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess );
+    struct thread_counters counters, *exited = NULL;
+    client_ptr_t *tebs = NULL;
+    ULONG_PTR wow64;
+    ULONG count = 16, size = 0, i;
+    OBJECT_ATTRIBUTES attr;
+    CLIENT_ID cid;
+    HANDLE process;
+    NTSTATUS ret;
+
+    InitializeObjectAttributes( &attr, NULL, 0, NULL, NULL );
+    cid.UniqueProcess = ULongToHandle( pid );
+    cid.UniqueThread = 0;
+    if ((ret = NtOpenProcess( &process, PROCESS_VM_READ | PROCESS_QUERY_LIMITED_INFORMATION, &attr, &cid )))
+        return ret;
+
+    /* the thread data layout depends on the bitness of the process */
+    if ((ret = NtQueryInformationProcess( process, ProcessWow64Information, &wow64, sizeof(wow64), NULL )))
+    {
+        NtClose( process );
+        return ret;
+    }
+    if (!wow64 != !is_wow64)
+    {
+        NtClose( process );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    /* the thread list can grow between the calls, retry until it fits */
+    while (count > size)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, tebs );
+        size = count;
+        if (!(tebs = RtlAllocateHeap( GetProcessHeap(), 0, size * sizeof(*tebs) )))
+        {
+            ret = STATUS_NO_MEMORY;
+            break;
+        }
+        SERVER_START_REQ( get_process_tebs )
+        {
+            req->handle = wine_server_obj_handle( process );
+            wine_server_set_reply( req, tebs, size * sizeof(*tebs) );
+            if (!(ret = wine_server_call( req ))) count = reply->count;
+        }
+        SERVER_END_REQ;
+        if (ret) break;
+    }
+
+    if (!ret)
+    {
+        memset( (char *)info + sizeof(info->ProcessId), 0, sizeof(*info) - sizeof(info->ProcessId) );
+        info->ThreadCount = count;
+        for (i = 0; i < count; i++)
+        {
+            if (!read_thread_counters( process, tebs[i], &counters )) continue;
+            add_thread_counters( info, &counters );
+            if (counters.exited) exited = counters.exited;
+        }
+        if (exited && !NtReadVirtualMemory( process, exited, &counters, sizeof(counters), NULL ))
+            add_thread_counters( info, &counters );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, tebs );
+    NtClose( process );
+    return ret;
+}
+
 /******************************************************************************
  * NtQuerySystemInformation [NTDLL.@]
  * ZwQuerySystemInformation [NTDLL.@]
@@ -3338,6 +3430,12 @@ NTSTATUS WINAPI NtQuerySystemInformation(
         info->CodeIntegrityOptions = CODEINTEGRITY_OPTION_ENABLED;
         break;
     }
+    case SystemWineCountersInformation:
+        len = sizeof(SYSTEM_WINE_COUNTERS_INFORMATION);
+        if (Length < len) ret = STATUS_INFO_LENGTH_MISMATCH;
+        else if (!SystemInformation) ret = STATUS_ACCESS_VIOLATION;
+        else ret = get_wine_counters( SystemInformation );
+        break;
     default:
 	FIXME("(0x%08x,%p,0x%08x,%p) stub\n",
 	      SystemInformationClass,SystemInformation,Length,ResultLength);
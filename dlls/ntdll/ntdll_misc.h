@@ -71,6 +71,7 @@ extern LONG WINAPI call_unhandled_exception_filter( PEXCEPTION_POINTERS eptr ) D
 
 #if defined(__x86_64__) || defined(__arm__) || defined(__aarch64__)
 extern RUNTIME_FUNCTION *lookup_function_info( ULONG_PTR pc, ULONG_PTR *base, LDR_DATA_TABLE_ENTRY **module ) DECLSPEC_HIDDEN;
+extern RUNTIME_FUNCTION *find_function_info( ULONG_PTR pc, ULONG_PTR base, RUNTIME_FUNCTION *func, ULONG size ) DECLSPEC_HIDDEN;
 #endif
 
 /* debug helpers */
@@ -85,6 +86,20 @@ extern void signal_init_early(void) DECLSPEC_HIDDEN;
 extern void signal_start_thread( LPTHREAD_START_ROUTINE entry, void *arg, BOOL suspend ) DECLSPEC_HIDDEN;
 extern void signal_start_process( LPTHREAD_START_ROUTINE entry, BOOL suspend ) DECLSPEC_HIDDEN;
 extern void version_init(void) DECLSPEC_HIDDEN;
+
+/* sampling profiler */
+#define PROFILE_MAX_FRAMES 128
+extern BOOL profile_init(void) DECLSPEC_HIDDEN;
+extern void profile_start(void) DECLSPEC_HIDDEN;
+extern void profile_add_sample( const ULONG_PTR *frames, unsigned int count ) DECLSPEC_HIDDEN;
+extern void profile_add_module( HMODULE module ) DECLSPEC_HIDDEN;
+extern void profile_remove_module( HMODULE module ) DECLSPEC_HIDDEN;
+#ifdef __x86_64__
+extern void profile_enter_unwind(void) DECLSPEC_HIDDEN;
+extern void profile_leave_unwind(void) DECLSPEC_HIDDEN;
+extern RUNTIME_FUNCTION *profile_lookup_function( ULONG_PTR pc, ULONG_PTR *base ) DECLSPEC_HIDDEN;
+#endif
+extern void profile_dump(void) DECLSPEC_HIDDEN;
 extern void debug_init(void) DECLSPEC_HIDDEN;
 extern TEB *thread_init(void) DECLSPEC_HIDDEN;
 extern void actctx_init(void) DECLSPEC_HIDDEN;
@@ -282,6 +297,8 @@ struct debug_info
     unsigned int out_pos;       /* current position in output buffer */
     char         strings[1024]; /* buffer for temporary strings */
     char         output[1024];  /* current output line */
+    void        *ring;          /* binary trace ring buffer, if any */
+    BOOL         ring_closed;   /* the ring buffer was released by the exiting thread */
 };
 
 /* thread private data, stored in NtCurrentTeb()->GdiTebBatch */
@@ -294,7 +311,9 @@ struct ntdll_thread_data
     int                wait_fd[2];    /* fd for sleeping server requests */
     BOOL               wow64_redir;   /* Wow64 filesystem redirection flag */
     pthread_t          pthread_id;    /* pthread thread id */
+    struct thread_counters counters;  /* instrumentation counters, must match the Unix side */
     void              *pthread_stack; /* pthread stack */
+    BOOL               loader_worker; /* thread started by the loader, see LdrInitializeThunk */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -304,6 +323,11 @@ static inline struct ntdll_thread_data *ntdll_get_thread_data(void)
     return (struct ntdll_thread_data *)&NtCurrentTeb()->GdiTebBatch;
 }
 
+static inline struct thread_counters *get_thread_counters(void)
+{
+    return &ntdll_get_thread_data()->counters;
+}
+
 static inline int get_unix_exit_code( NTSTATUS status )
 {
     /* prevent a nonzero exit code to end up truncated to zero in unix */
@@ -0,0 +1,590 @@
+/*
+ * Sampling profiler
+ *
+ * Copyright 2020 the Wine project authors (see the file AUTHORS for the complete list)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <fcntl.h>
+#ifdef HAVE_SYS_TIME_H
+# include <sys/time.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/debug.h"
+#include "ntdll_misc.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(profile);
+
+/* The profiler is enabled by setting WINEPROFILE=<file>. The signal handler
+ * stores raw stacks in a preallocated buffer, laid out as a frame count
+ * followed by the frames from the leaf up. Symbols are only resolved when the
+ * process exits, where the stacks are written to <file>.<pid> in the folded
+ * format used by flamegraph tools, and the PE functions are listed in
+ * /tmp/perf-<pid>.map.
+ *
+ * The other threads may have been killed while holding the heap or stdio
+ * locks by then, so the dump only uses memory allocated at startup, and
+ * writes the files directly. */
+
+#define PROFILE_BUFFER_SIZE  (4 * 1024 * 1024)  /* in frames */
+#define PROFILE_INTERVAL     1000               /* sampling interval in microseconds */
+#define SYMBOL_CACHE_SIZE    65536              /* in entries */
+#define SYMBOL_POOL_SIZE     (4 * 1024 * 1024)  /* in bytes, for symbol names and the maps file */
+#define MAX_UNIX_MAPS        4096
+
+/* set in the frame count while the frames are being written */
+#define PROFILE_PENDING      ((ULONG_PTR)1 << (sizeof(ULONG_PTR) * 8 - 1))
+
+static char profile_file[MAX_PATH];
+static ULONG_PTR *profile_buffer;
+static LONG profile_pos;
+static LONG profile_dropped;
+
+struct symbol_cache
+{
+    ULONG_PTR addr;
+    ULONG     name;  /* offset in the symbol pool, 0 if the entry is free */
+};
+
+static struct symbol_cache *symbol_cache;
+static unsigned int symbol_count;
+static char *symbol_pool;
+static ULONG symbol_pool_pos;
+
+/* buffered output to a file, or to a fixed size string if fd is -1 */
+struct output
+{
+    int          fd;
+    unsigned int len;
+    unsigned int size;
+    char        *buffer;
+};
+
+/***********************************************************************
+ *           profile_init
+ *
+ * Check whether profiling is requested and allocate the sample buffer.
+ */
+BOOL profile_init(void)
+{
+    SIZE_T size = PROFILE_BUFFER_SIZE * sizeof(ULONG_PTR) + SYMBOL_CACHE_SIZE * sizeof(*symbol_cache) +
+                  SYMBOL_POOL_SIZE;
+    const char *name = getenv( "WINEPROFILE" );
+    LIST_ENTRY *mark, *entry;
+    void *ptr = NULL;
+
+    if (!name || !name[0]) return FALSE;
+    if (strlen( name ) >= sizeof(profile_file) - 12)
+    {
+        ERR( "file name too long, profiling disabled\n" );
+        return FALSE;
+    }
+    /* only committed when touched, so most of it stays unused */
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, 0, &size, MEM_COMMIT, PAGE_READWRITE ))
+    {
+        ERR( "failed to allocate the sample buffer, profiling disabled\n" );
+        return FALSE;
+    }
+    strcpy( profile_file, name );
+    profile_buffer = ptr;
+    symbol_cache = (struct symbol_cache *)(profile_buffer + PROFILE_BUFFER_SIZE);
+    symbol_pool = (char *)(symbol_cache + SYMBOL_CACHE_SIZE);
+    symbol_pool_pos = 1;  /* offset 0 marks free cache entries */
+
+    /* the modules loaded later are added by the loader */
+    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+        profile_add_module( CONTAINING_RECORD( entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks )->DllBase );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           profile_start
+ *
+ * Start the sampling timer, once the signal handler is installed.
+ */
+void profile_start(void)
+{
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = timer.it_value.tv_sec = 0;
+    timer.it_interval.tv_usec = timer.it_value.tv_usec = PROFILE_INTERVAL;
+    setitimer( ITIMER_PROF, &timer, NULL );
+}
+
+/***********************************************************************
+ *           profile_add_sample
+ *
+ * Store a stack in the sample buffer. Called from the signal handler.
+ */
+void profile_add_sample( const ULONG_PTR *frames, unsigned int count )
+{
+    ULONG_PTR len;
+    LONG pos;
+
+    if (!count || !profile_buffer) return;
+    for (;;)
+    {
+        pos = profile_pos;
+        if (pos + count + 1 > PROFILE_BUFFER_SIZE)
+        {
+            InterlockedIncrement( &profile_dropped );
+            return;
+        }
+        /* the slot is claimed by storing its length, so that the dump can skip it
+         * even if it never gets filled; a thread that loses the race helps moving
+         * the end of the buffer past the claimed slot */
+        len = (ULONG_PTR)InterlockedCompareExchangePointer( (void **)&profile_buffer[pos],
+                                                            (void *)(count | PROFILE_PENDING), NULL );
+        if (!len) break;
+        InterlockedCompareExchange( &profile_pos, pos + (len & ~PROFILE_PENDING) + 1, pos );
+    }
+    InterlockedCompareExchange( &profile_pos, pos + count + 1, pos );
+    memcpy( profile_buffer + pos + 1, frames, count * sizeof(*frames) );
+    profile_buffer[pos] = count;
+}
+
+#ifdef __x86_64__
+
+/* PE modules with unwind tables, looked up from the signal handler without taking locks;
+ * entries are only modified with the loader lock held */
+struct profile_module
+{
+    ULONG_PTR         base;   /* 0 if the entry is free */
+    ULONG_PTR         end;
+    RUNTIME_FUNCTION *funcs;
+    ULONG             count;
+};
+
+#define MAX_PROFILE_MODULES 1024
+
+static struct profile_module profile_modules[MAX_PROFILE_MODULES];
+static LONG profile_module_count;  /* number of entries ever used */
+static LONG profile_unwinding;     /* number of signal handlers using the module table */
+
+/***********************************************************************
+ *           profile_add_module
+ *
+ * Make the unwind table of a newly loaded module visible to the signal handler.
+ */
+void profile_add_module( HMODULE module )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( module );
+    RUNTIME_FUNCTION *funcs;
+    ULONG i, size;
+
+    if (!profile_buffer || !nt) return;
+    if (!(funcs = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXCEPTION, &size ))) return;
+
+    for (i = 0; i < MAX_PROFILE_MODULES; i++)
+    {
+        if (profile_modules[i].base) continue;
+        profile_modules[i].end   = (ULONG_PTR)module + nt->OptionalHeader.SizeOfImage;
+        profile_modules[i].funcs = funcs;
+        profile_modules[i].count = size / sizeof(*funcs);
+        InterlockedExchangePointer( (void **)&profile_modules[i].base, module );
+        if (i >= profile_module_count) profile_module_count = i + 1;
+        return;
+    }
+}
+
+/***********************************************************************
+ *           profile_remove_module
+ *
+ * Remove a module from the table before it gets unmapped.
+ */
+void profile_remove_module( HMODULE module )
+{
+    LONG i;
+
+    if (!profile_buffer) return;
+    for (i = 0; i < profile_module_count; i++)
+    {
+        if (profile_modules[i].base != (ULONG_PTR)module) continue;
+        InterlockedExchangePointer( (void **)&profile_modules[i].base, NULL );
+        /* wait for the handlers that could still be reading the module */
+        while (profile_unwinding) NtYieldExecution();
+        return;
+    }
+}
+
+void profile_enter_unwind(void)
+{
+    InterlockedIncrement( &profile_unwinding );
+}
+
+void profile_leave_unwind(void)
+{
+    InterlockedDecrement( &profile_unwinding );
+}
+
+/***********************************************************************
+ *           profile_lookup_function
+ *
+ * Find the function entry for an address in a PE module. Safe to call from the
+ * signal handler between profile_enter_unwind() and profile_leave_unwind().
+ * The base is set to 0 if the address isn't in a PE module.
+ */
+RUNTIME_FUNCTION *profile_lookup_function( ULONG_PTR pc, ULONG_PTR *base )
+{
+    LONG i, count = profile_module_count;
+
+    for (i = 0; i < count; i++)
+    {
+        struct profile_module *module = &profile_modules[i];
+        ULONG_PTR start = module->base;
+
+        if (!start || pc < start || pc >= module->end) continue;
+        *base = start;
+        return find_function_info( pc, start, module->funcs, module->count );
+    }
+    *base = 0;
+    return NULL;
+}
+
+#else  /* __x86_64__ */
+
+void profile_add_module( HMODULE module )
+{
+}
+
+void profile_remove_module( HMODULE module )
+{
+}
+
+#endif  /* __x86_64__ */
+
+static void output_flush( struct output *out )
+{
+    unsigned int pos = 0;
+    int ret;
+
+    if (out->fd == -1) return;
+    while (pos < out->len && (ret = write( out->fd, out->buffer + pos, out->len - pos )) > 0) pos += ret;
+    out->len = 0;
+}
+
+static void output_char( struct output *out, char ch )
+{
+    if (out->len == out->size - 1) output_flush( out );
+    if (out->len < out->size - 1) out->buffer[out->len++] = ch;
+    out->buffer[out->len] = 0;
+}
+
+static void output_str( struct output *out, const char *str )
+{
+    while (*str) output_char( out, *str++ );
+}
+
+static void output_hex( struct output *out, ULONG_PTR val )
+{
+    char buffer[2 * sizeof(val) + 1], *p = buffer + sizeof(buffer) - 1;
+
+    *p = 0;
+    do *--p = "0123456789abcdef"[val & 0xf]; while (val >>= 4);
+    output_str( out, p );
+}
+
+static void output_dec( struct output *out, ULONG val )
+{
+    char buffer[11], *p = buffer + sizeof(buffer) - 1;
+
+    *p = 0;
+    do *--p = '0' + val % 10; while (val /= 10);
+    output_str( out, p );
+}
+
+/* the mappings of the Unix libraries, read from /proc/self/maps */
+struct unix_map
+{
+    ULONG_PTR start;
+    ULONG_PTR end;
+    ULONG_PTR offset;  /* file offset of the start */
+    ULONG     name;    /* offset in the symbol pool */
+};
+
+static struct unix_map unix_maps[MAX_UNIX_MAPS];
+static unsigned int unix_map_count;
+
+static ULONG_PTR parse_hex( const char **str )
+{
+    ULONG_PTR val = 0;
+
+    for (;; (*str)++)
+    {
+        if (**str >= '0' && **str <= '9') val = val * 16 + **str - '0';
+        else if (**str >= 'a' && **str <= 'f') val = val * 16 + **str - 'a' + 10;
+        else return val;
+    }
+}
+
+/* read the file mappings, and keep those of the shared libraries in the symbol pool */
+static void read_unix_maps(void)
+{
+    char *buffer = symbol_pool + symbol_pool_pos, *line, *end;
+    ULONG size = SYMBOL_POOL_SIZE / 2, len = 0;
+    int fd, ret;
+
+    if (symbol_pool_pos + size > SYMBOL_POOL_SIZE) return;
+    if ((fd = open( "/proc/self/maps", O_RDONLY )) == -1) return;
+    while (len < size - 1 && (ret = read( fd, buffer + len, size - 1 - len )) > 0) len += ret;
+    close( fd );
+    buffer[len] = 0;
+
+    /* the names are moved to the start of the buffer, which always stays behind the parsing */
+    for (line = buffer; *line && unix_map_count < MAX_UNIX_MAPS; line = end + 1)
+    {
+        struct unix_map *map = &unix_maps[unix_map_count];
+        const char *p = line, *name;
+
+        if (!(end = strchr( line, '\n' ))) break;
+        *end = 0;
+        map->start = parse_hex( &p );
+        if (*p++ != '-') continue;
+        map->end = parse_hex( &p );
+        if (strncmp( p, " r-x", 4 )) continue;  /* only the code */
+        p += 6;
+        map->offset = parse_hex( &p );
+        if (!(name = strchr( p, '/' ))) continue;
+        if (strrchr( name, '/' )) name = strrchr( name, '/' ) + 1;
+        map->name = symbol_pool_pos;
+        len = strlen( name ) + 1;
+        memmove( symbol_pool + symbol_pool_pos, name, len );
+        symbol_pool_pos += len;
+        unix_map_count++;
+    }
+}
+
+/* convert a module name to a plain ASCII string */
+static void output_module_name( struct output *out, const LDR_DATA_TABLE_ENTRY *mod )
+{
+    unsigned int i;
+
+    for (i = 0; i < mod->BaseDllName.Length / sizeof(WCHAR); i++)
+    {
+        WCHAR ch = mod->BaseDllName.Buffer[i];
+        output_char( out, (ch < 0x80 && ch != ';' && ch != ' ') ? ch : '_' );
+    }
+}
+
+/* find the name of the export at a given rva, if any */
+static const char *find_export_name( HMODULE module, DWORD rva )
+{
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const DWORD *functions, *names;
+    const WORD *ordinals;
+    ULONG size;
+    DWORD i;
+
+    if (!(exports = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &size )))
+        return NULL;
+    functions = (const DWORD *)((const char *)module + exports->AddressOfFunctions);
+    names = (const DWORD *)((const char *)module + exports->AddressOfNames);
+    ordinals = (const WORD *)((const char *)module + exports->AddressOfNameOrdinals);
+    for (i = 0; i < exports->NumberOfNames; i++)
+        if (functions[ordinals[i]] == rva) return (const char *)module + names[i];
+    return NULL;
+}
+
+/* output the symbol of a PE function starting at a given rva */
+static void output_pe_symbol( struct output *out, const LDR_DATA_TABLE_ENTRY *mod, DWORD rva )
+{
+    const char *name = find_export_name( mod->DllBase, rva );
+
+    output_module_name( out, mod );
+    output_char( out, '!' );
+    if (name) output_str( out, name );
+    else
+    {
+        output_str( out, "0x" );
+        output_hex( out, rva );
+    }
+}
+
+/* output the symbol for a code address */
+static void output_symbol( struct output *out, ULONG_PTR addr )
+{
+    LDR_DATA_TABLE_ENTRY *mod;
+    unsigned int i;
+
+    if (!LdrFindEntryForAddress( (void *)addr, &mod ) && !(mod->Flags & LDR_WINE_INTERNAL))
+    {
+#ifdef __x86_64__
+        RUNTIME_FUNCTION *func;
+        ULONG_PTR base;
+
+        if ((func = profile_lookup_function( addr, &base )))
+        {
+            output_pe_symbol( out, mod, func->BeginAddress );
+            return;
+        }
+#endif
+        output_pe_symbol( out, mod, addr - (ULONG_PTR)mod->DllBase );
+        return;
+    }
+    for (i = 0; i < unix_map_count; i++)
+    {
+        if (addr < unix_maps[i].start || addr >= unix_maps[i].end) continue;
+        output_str( out, symbol_pool + unix_maps[i].name );
+        output_str( out, "+0x" );
+        output_hex( out, addr - unix_maps[i].start + unix_maps[i].offset );
+        return;
+    }
+    output_str( out, "0x" );
+    output_hex( out, addr );
+}
+
+/* output the cached symbol for a code address */
+static void output_cached_symbol( struct output *out, ULONG_PTR addr )
+{
+    unsigned int i = (addr * 2654435761u) % SYMBOL_CACHE_SIZE;
+    char buffer[256];
+    struct output str = { -1, 0, sizeof(buffer), buffer };
+
+    while (symbol_cache[i].name)
+    {
+        if (symbol_cache[i].addr == addr)
+        {
+            output_str( out, symbol_pool + symbol_cache[i].name );
+            return;
+        }
+        i = (i + 1) % SYMBOL_CACHE_SIZE;
+    }
+    output_symbol( &str, addr );
+    output_str( out, buffer );
+
+    /* keep the table at most half full so that lookups stay short */
+    if (symbol_count >= SYMBOL_CACHE_SIZE / 2 || symbol_pool_pos + str.len + 1 > SYMBOL_POOL_SIZE) return;
+    symbol_count++;
+    symbol_cache[i].addr = addr;
+    symbol_cache[i].name = symbol_pool_pos;
+    memcpy( symbol_pool + symbol_pool_pos, buffer, str.len + 1 );
+    symbol_pool_pos += str.len + 1;
+}
+
+/* write the folded stacks, one line per sample, from the root to the leaf */
+static void write_folded_stacks( struct output *out )
+{
+    LONG pos = 0, end = min( profile_pos, PROFILE_BUFFER_SIZE );
+
+    while (pos < end && profile_buffer[pos])
+    {
+        ULONG_PTR count = profile_buffer[pos] & ~PROFILE_PENDING;
+        ULONG_PTR *frames = profile_buffer + pos + 1;
+
+        pos += count + 1;
+        if (frames[-1] & PROFILE_PENDING) continue;  /* interrupted while being written */
+        while (count--)
+        {
+            /* return addresses point after the call instruction */
+            output_cached_symbol( out, count ? frames[count] - 1 : frames[0] );
+            output_char( out, count ? ';' : ' ' );
+        }
+        output_str( out, "1\n" );
+    }
+    output_flush( out );
+}
+
+/* open a file for writing, with a name followed by the pid */
+static int open_output( const char *prefix, const char *suffix )
+{
+    char name[MAX_PATH + 32];
+    struct output str = { -1, 0, sizeof(name), name };
+    int fd;
+
+    output_str( &str, prefix );
+    output_dec( &str, getpid() );
+    output_str( &str, suffix );
+    if ((fd = open( name, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) == -1) ERR( "cannot create %s\n", name );
+    return fd;
+}
+
+#ifdef __x86_64__
+
+/* write a perf map file listing all the functions of the loaded PE modules */
+static void write_perf_map( struct output *out )
+{
+    LDR_DATA_TABLE_ENTRY *mod;
+    LONG i;
+    ULONG j;
+
+    for (i = 0; i < profile_module_count; i++)
+    {
+        struct profile_module *module = &profile_modules[i];
+
+        if (!module->base || LdrFindEntryForAddress( (void *)module->base, &mod )) continue;
+        for (j = 0; j < module->count; j++)
+        {
+            if (module->funcs[j].UnwindData & 1) continue;  /* chained entry */
+            output_hex( out, module->base + module->funcs[j].BeginAddress );
+            output_char( out, ' ' );
+            output_hex( out, module->funcs[j].EndAddress - module->funcs[j].BeginAddress );
+            output_char( out, ' ' );
+            output_pe_symbol( out, mod, module->funcs[j].BeginAddress );
+            output_char( out, '\n' );
+        }
+    }
+    output_flush( out );
+}
+
+#endif
+
+/***********************************************************************
+ *           profile_dump
+ *
+ * Stop sampling and write the results. Called on process exit.
+ */
+void profile_dump(void)
+{
+    static char buffer[4096];
+    struct output out = { -1, 0, sizeof(buffer), buffer };
+    struct itimerval timer;
+
+    if (!profile_buffer) return;
+
+    memset( &timer, 0, sizeof(timer) );
+    setitimer( ITIMER_PROF, &timer, NULL );
+
+    read_unix_maps();
+
+    /* child processes inherit the variable, give each one its own file */
+    if ((out.fd = open_output( profile_file, "" )) != -1)
+    {
+        write_folded_stacks( &out );
+        close( out.fd );
+    }
+#ifdef __x86_64__
+    if ((out.fd = open_output( "/tmp/perf-", ".map" )) != -1)
+    {
+        write_perf_map( &out );
+        close( out.fd );
+    }
+#endif
+    if (profile_dropped) WARN( "%d samples dropped, buffer full\n", profile_dropped );
+    profile_buffer = NULL;
+}
@@ -58,6 +58,9 @@
 #ifdef __APPLE__
 # include <mach/mach.h>
 #endif
+#ifdef linux
+# include <asm/prctl.h>
+#endif
 
 #define NONAMELESSUNION
 #define NONAMELESSSTRUCT
@@ -3100,6 +3103,86 @@ static void quit_handler( int signal, siginfo_t *siginfo, void *ucontext )
 }
 
 
+/**********************************************************************
+ *		get_signal_teb
+ *
+ * Return the TEB of the current thread from a signal handler, or NULL
+ * if the signal was received by a thread that doesn't belong to Wine.
+ */
+static TEB *get_signal_teb(void)
+{
+    TEB *teb = NULL;
+
+#if defined(linux) && defined(__NR_arch_prctl)
+    syscall( __NR_arch_prctl, ARCH_GET_GS, &teb );
+#elif defined (__FreeBSD__) || defined (__FreeBSD_kernel__)
+    amd64_get_gsbase( (void **)&teb );
+#elif defined(__NetBSD__)
+    sysarch( X86_64_GET_GSBASE, &teb );
+#else
+    /* the %gs base is always valid, but Tib.Self is only set for Wine threads */
+    __asm__ volatile (".byte 0x65\n\tmovq %c1,%0" : "=r" (teb) : "n" (FIELD_OFFSET(TEB, Tib.Self)));
+#endif
+    if (teb && teb->Tib.Self != &teb->Tib) teb = NULL;
+    return teb;
+}
+
+
+/**********************************************************************
+ *		prof_handler
+ *
+ * Handler for SIGPROF, used by the sampling profiler. The stack is
+ * unwound with the unwind tables of the PE modules, which are registered
+ * with the profiler as they are loaded so that they can be used without
+ * taking the loader lock. Other code falls back to the frame pointer
+ * chain; symbols are only resolved in profile_dump().
+ */
+static void prof_handler( int signal, siginfo_t *siginfo, void *sigcontext )
+{
+    ULONG_PTR frames[PROFILE_MAX_FRAMES];
+    ULONG_PTR low, high, base, *fp;
+    unsigned int count = 0;
+    RUNTIME_FUNCTION *func;
+    CONTEXT context;
+    ULONG64 frame;
+    void *data;
+    TEB *teb;
+
+    /* the timer may fire in threads created by native libraries */
+    if (!(teb = get_signal_teb())) return;
+    low = (ULONG_PTR)teb->DeallocationStack;
+    high = (ULONG_PTR)teb->Tib.StackBase;
+
+    save_context( &context, sigcontext );
+    profile_enter_unwind();
+    while (count < PROFILE_MAX_FRAMES && context.Rip)
+    {
+        ULONG64 rsp = context.Rsp;
+
+        if (rsp < low || rsp >= high) break;
+        frames[count++] = context.Rip;
+        if ((func = profile_lookup_function( context.Rip, &base )))
+            RtlVirtualUnwind( UNW_FLAG_NHANDLER, base, context.Rip, func, &context, &data, &frame, NULL );
+        else if (base)  /* leaf function */
+        {
+            context.Rip = *(ULONG64 *)rsp;
+            context.Rsp = rsp + sizeof(ULONG64);
+        }
+        else
+        {
+            fp = (ULONG_PTR *)context.Rbp;
+            if ((ULONG_PTR)fp < rsp || (ULONG_PTR)(fp + 2) > high || ((ULONG_PTR)fp & 7)) break;
+            context.Rip = fp[1];
+            context.Rsp = (ULONG_PTR)(fp + 2);
+            context.Rbp = fp[0];
+        }
+        if (context.Rsp <= rsp) break;
+    }
+    profile_leave_unwind();
+    profile_add_sample( frames, count );
+}
+
+
 /**********************************************************************
  *		usr1_handler
  *
@@ -3159,6 +3242,13 @@ void signal_init_process(void)
     sig_act.sa_sigaction = trap_handler;
     if (sigaction( SIGTRAP, &sig_act, NULL ) == -1) goto error;
 #endif
+
+    if (profile_init())
+    {
+        sig_act.sa_sigaction = prof_handler;
+        if (sigaction( SIGPROF, &sig_act, NULL ) == -1) goto error;
+        profile_start();
+    }
     return;
 
  error:
@@ -1261,6 +1261,7 @@ NTSTATUS WINAPI NtWaitForKeyedEvent( HANDLE handle, const void *key,
     if (!handle) handle = keyed_event;
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
     if (alertable) flags |= SELECT_ALERTABLE;
+    get_thread_counters()->sync_waits++;
     select_op.keyed_event.op     = SELECT_KEYED_EVENT_WAIT;
     select_op.keyed_event.handle = wine_server_obj_handle( handle );
     select_op.keyed_event.key    = wine_server_client_ptr( key );
@@ -1777,6 +1778,7 @@ static NTSTATUS fast_acquire_srw_exclusive( RTL_SRWLOCK *lock )
         if (!wait)
             return STATUS_SUCCESS;
 
+        get_thread_counters()->sync_waits++;
         futex_wait_bitset( futex, new, NULL, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
     }
 
@@ -1851,6 +1853,7 @@ static NTSTATUS fast_acquire_srw_shared( RTL_SRWLOCK *lock )
         if (!wait)
             return STATUS_SUCCESS;
 
+        get_thread_counters()->sync_waits++;
         futex_wait_bitset( futex, new, NULL, SRWLOCK_FUTEX_BITSET_SHARED );
     }
 
@@ -2219,6 +2222,7 @@ static NTSTATUS fast_wait_cv( int *futex, int val, const LARGE_INTEGER *timeout
     struct timespec timespec;
     int ret;
 
+    get_thread_counters()->sync_waits++;
     if (timeout && timeout->QuadPart != TIMEOUT_INFINITE)
     {
         timespec_from_timeout( &timespec, timeout );
@@ -2504,6 +2508,7 @@ static inline NTSTATUS fast_wait_addr( const void *addr, const void *cmp, SIZE_T
     if (!compare_addr( addr, cmp, size ))
         return STATUS_SUCCESS;
 
+    get_thread_counters()->sync_waits++;
     if (timeout)
     {
         timespec_from_timeout( &timespec, timeout );
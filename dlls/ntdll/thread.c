@@ -75,6 +75,7 @@ static RTL_BITMAP tls_expansion_bitmap;
 static RTL_BITMAP fls_bitmap;
 static API_SET_NAMESPACE_ARRAY apiset_map;
 static int nb_threads = 1;
+static struct thread_counters exited_counters;
 
 struct ldt_copy *__wine_ldt_copy = NULL;
 
@@ -382,6 +383,7 @@ TEB *thread_init(void)
     thread_data->reply_fd   = -1;
     thread_data->wait_fd[0] = -1;
     thread_data->wait_fd[1] = -1;
+    thread_data->counters.exited = &exited_counters;
 
     unix_funcs->dbg_init();
     unix_funcs->get_paths( &build_dir, &data_dir, &config_dir );
@@ -390,6 +392,31 @@ TEB *thread_init(void)
 }
 
 
+/* atomically add to a 64-bit counter */
+static void add_counter( ULONGLONG *dest, ULONGLONG val )
+{
+    ULONGLONG old;
+
+    do old = *dest; while (InterlockedCompareExchange64( (LONGLONG *)dest, old + val, old ) != old);
+}
+
+/***********************************************************************
+ *           add_exited_thread_counters
+ *
+ * Add the counters of the current thread to the process totals when it exits.
+ */
+static void add_exited_thread_counters(void)
+{
+    const struct thread_counters *counters = get_thread_counters();
+
+    add_counter( &exited_counters.server_calls, counters->server_calls );
+    add_counter( &exited_counters.sync_waits, counters->sync_waits );
+    add_counter( &exited_counters.heap_allocs, counters->heap_allocs );
+    add_counter( &exited_counters.page_faults, counters->page_faults );
+    add_counter( &exited_counters.exceptions, counters->exceptions );
+}
+
+
 /***********************************************************************
  *           RtlExitUserThread  (NTDLL.@)
  */
@@ -418,6 +445,7 @@ void WINAPI RtlExitUserThread( ULONG status )
 
     LdrShutdownThread();
     RtlFreeThreadActivationContextStack();
+    add_exited_thread_counters();
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
@@ -490,6 +518,8 @@ static void start_thread( struct startup_info *info )
     struct debug_info debug_info;
 
     debug_info.str_pos = debug_info.out_pos = 0;
+    debug_info.ring = NULL;
+    debug_info.ring_closed = FALSE;
     thread_data->debug_info = &debug_info;
     thread_data->pthread_id = pthread_self();
 
@@ -648,6 +678,8 @@ NTSTATUS WINAPI NtCreateThreadEx( HANDLE *handle_ptr, ACCESS_MASK access, OBJECT
     thread_data->wait_fd[0]  = -1;
     thread_data->wait_fd[1]  = -1;
     thread_data->start_stack = (char *)teb->Tib.StackBase;
+    memset( &thread_data->counters, 0, sizeof(thread_data->counters) );
+    thread_data->counters.exited = &exited_counters;
 
     pthread_attr_init( &pthread_attr );
     pthread_attr_setstack( &pthread_attr, teb->DeallocationStack,
@@ -26,12 +26,20 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+# include <sys/time.h>
+#endif
 
 #include "windef.h"
 #include "winnt.h"
@@ -51,6 +59,35 @@ static struct __wine_debug_channel *debug_options;
 
 static const char * const debug_classes[] = { "fixme", "err", "warn", "trace" };
 
+/* binary trace ring buffer, one file per thread, enabled with WINEDEBUGRING=<dir>
+ * the layout must be kept in sync with tools/dump-debug-ring */
+
+#define DEBUG_RING_MAGIC   0x676e6952  /* 'Ring' */
+#define DEBUG_RING_VERSION 1
+#define DEBUG_RING_SIZE    (1024 * 1024)
+
+struct debug_ring_header
+{
+    unsigned int magic;         /* DEBUG_RING_MAGIC */
+    unsigned int version;       /* DEBUG_RING_VERSION */
+    unsigned int size;          /* size of the data area */
+    unsigned int pid;           /* process id */
+    unsigned int tid;           /* thread id */
+    unsigned int reserved[3];
+    ULONGLONG    head;          /* offset of the next record to write */
+    ULONGLONG    tail;          /* offset of the oldest valid record */
+};
+
+struct debug_ring_record
+{
+    unsigned int size;          /* total record size, aligned to sizeof(struct debug_ring_record) */
+    unsigned int len;           /* length of the text, 0 for padding at the end of the buffer */
+    ULONGLONG    time;          /* monotonic time in nanoseconds */
+    /* char text[len]; */
+};
+
+static const char *debug_ring_dir;
+
 /* get the debug info pointer for the current thread */
 static inline struct debug_info *get_info(void)
 {
@@ -72,6 +109,103 @@ static int append_output( struct debug_info *info, const char *str, size_t len )
     return len;
 }
 
+/* monotonic time stamp for ring records */
+static ULONGLONG get_ring_time(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec ts;
+    if (!clock_gettime( CLOCK_MONOTONIC, &ts )) return ts.tv_sec * (ULONGLONG)1000000000 + ts.tv_nsec;
+#endif
+    {
+        struct timeval tv;
+        gettimeofday( &tv, NULL );
+        return tv.tv_sec * (ULONGLONG)1000000000 + tv.tv_usec * 1000;
+    }
+}
+
+/* create the ring buffer file for the current thread
+ * the start time is part of the name since thread and process ids are reused */
+static struct debug_ring_header *open_ring(void)
+{
+    struct debug_ring_header *ring;
+    char *name;
+    int fd;
+
+    if (!(name = malloc( strlen(debug_ring_dir) + sizeof("/00000000-00000000-0000000000000000.ring") )))
+        return NULL;
+    sprintf( name, "%s/%04x-%04x-%016llx.ring", debug_ring_dir, GetCurrentProcessId(),
+             GetCurrentThreadId(), (unsigned long long)get_ring_time() );
+    fd = open( name, O_RDWR | O_CREAT | O_EXCL, 0666 );
+    if (fd == -1 || ftruncate( fd, sizeof(*ring) + DEBUG_RING_SIZE ) == -1 ||
+        (ring = mmap( NULL, sizeof(*ring) + DEBUG_RING_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0 )) == MAP_FAILED)
+    {
+        fprintf( stderr, "wine: cannot create debug ring %s, falling back to stderr\n", name );
+        debug_ring_dir = NULL;
+        ring = NULL;
+    }
+    else
+    {
+        ring->magic   = DEBUG_RING_MAGIC;
+        ring->version = DEBUG_RING_VERSION;
+        ring->size    = DEBUG_RING_SIZE;
+        ring->pid     = GetCurrentProcessId();
+        ring->tid     = GetCurrentThreadId();
+        ring->head    = ring->tail = 0;
+    }
+    if (fd != -1) close( fd );
+    free( name );
+    return ring;
+}
+
+/* discard the oldest records until there is room for 'size' more bytes */
+static void make_ring_room( struct debug_ring_header *ring, ULONGLONG head, unsigned int size )
+{
+    char *data = (char *)(ring + 1);
+    ULONGLONG tail = ring->tail;
+
+    while (head + size - tail > ring->size)
+        tail += ((struct debug_ring_record *)(data + tail % ring->size))->size;
+    ring->tail = tail;
+}
+
+/* append a complete output line to the ring; there is a single writer so no locking is needed */
+static void write_ring( struct debug_ring_header *ring, const char *str, unsigned int len )
+{
+    char *data = (char *)(ring + 1);
+    struct debug_ring_record *rec;
+    ULONGLONG head = ring->head;
+    unsigned int pos = head % ring->size;
+    unsigned int size = (sizeof(*rec) + len + sizeof(*rec) - 1) & ~(sizeof(*rec) - 1);
+
+    if (size > ring->size - pos)  /* doesn't fit before the end, pad and wrap around */
+    {
+        make_ring_room( ring, head, ring->size - pos );
+        rec = (struct debug_ring_record *)(data + pos);
+        rec->size = ring->size - pos;
+        rec->len  = 0;
+        rec->time = 0;
+        head += rec->size;
+        pos = 0;
+    }
+    make_ring_room( ring, head, size );
+    rec = (struct debug_ring_record *)(data + pos);
+    rec->size = size;
+    rec->len  = len;
+    rec->time = get_ring_time();
+    memcpy( rec + 1, str, len );
+    ring->head = head + size;
+}
+
+/* flush the current output line */
+static void flush_output( struct debug_info *info )
+{
+    if (init_done && debug_ring_dir && !info->ring && !info->ring_closed) info->ring = open_ring();
+    if (info->ring) write_ring( info->ring, info->output, info->out_pos );
+    else write( 2, info->output, info->out_pos );
+    info->out_pos = 0;
+}
+
 /* add a new debug option at the end of the option list */
 static void add_option( const char *name, unsigned char set, unsigned char clear )
 {
@@ -167,7 +301,9 @@ static void debug_usage(void)
         "  WINEDEBUG=[class]+xxx,[class]-yyy,...\n\n"
         "Example: WINEDEBUG=+relay,warn-heap\n"
         "    turns on relay traces, disable heap warnings\n"
-        "Available message classes: err, warn, fixme, trace\n";
+        "Available message classes: err, warn, fixme, trace\n\n"
+        "Set WINEDEBUGRING=<dir> to store the output in per-thread binary ring buffers\n"
+        "in <dir>, to be decoded with tools/dump-debug-ring\n";
     write( 2, usage, sizeof(usage) - 1 );
     exit(1);
 }
@@ -179,6 +315,8 @@ static void init_options(void)
     struct stat st1, st2;
 
     nb_debug_options = 0;
+    debug_ring_dir = getenv( "WINEDEBUGRING" );
+    if (debug_ring_dir && !debug_ring_dir[0]) debug_ring_dir = NULL;
 
     /* check for stderr pointing to /dev/null */
     if (!fstat( 2, &st1 ) && S_ISCHR(st1.st_mode) &&
@@ -246,8 +384,7 @@ int __cdecl __wine_dbg_output( const char *str )
     if (end)
     {
         ret += append_output( info, str, end + 1 - str );
-        write( 2, info->output, info->out_pos );
-        info->out_pos = 0;
+        flush_output( info );
         str = end + 1;
     }
     if (*str) ret += append_output( info, str, strlen( str ));
@@ -269,7 +406,8 @@ int __cdecl __wine_dbg_header( enum __wine_debug_class cls, struct __wine_debug_
     /* only print header if we are at the beginning of the line */
     if (info->out_pos) return 0;
 
-    if (init_done)
+    /* time stamp and thread ids are stored in the ring itself */
+    if (init_done && !debug_ring_dir)
     {
         if (TRACE_ON(timestamp))
         {
@@ -296,3 +434,18 @@ void CDECL dbg_init(void)
     ntdll_get_thread_data()->debug_info = &initial_info;
     init_done = TRUE;
 }
+
+/***********************************************************************
+ *		dbg_exit_thread
+ *
+ * Release the ring buffer of the exiting thread. Any later output goes to stderr.
+ */
+void dbg_exit_thread(void)
+{
+    struct debug_info *info = get_info();
+
+    info->ring_closed = TRUE;
+    if (!info->ring) return;
+    munmap( info->ring, sizeof(struct debug_ring_header) + DEBUG_RING_SIZE );
+    info->ring = NULL;
+}
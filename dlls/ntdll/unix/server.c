@@ -314,6 +314,7 @@ unsigned int CDECL server_call_unlocked( void *req_ptr )
     struct __server_request_info * const req = req_ptr;
     unsigned int ret;
 
+    ntdll_get_thread_data()->counters.server_calls++;
     if ((ret = send_request( req ))) return ret;
     return wait_reply( req );
 }
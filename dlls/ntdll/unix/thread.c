@@ -125,6 +125,7 @@ void CDECL init_thread( TEB *teb )
 void CDECL abort_thread( int status )
 {
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
+    dbg_exit_thread();
     if (InterlockedDecrement( nb_threads ) <= 0) _exit( get_unix_exit_code( status ));
     signal_exit_thread( status, pthread_exit_wrapper );
 }
@@ -136,6 +137,7 @@ void CDECL abort_thread( int status )
 void CDECL exit_thread( int status )
 {
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
+    dbg_exit_thread();
     signal_exit_thread( status, pthread_exit_wrapper );
 }
 
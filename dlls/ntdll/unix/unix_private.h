@@ -29,6 +29,8 @@ struct debug_info
     unsigned int out_pos;       /* current position in output buffer */
     char         strings[1024]; /* buffer for temporary strings */
     char         output[1024];  /* current output line */
+    void        *ring;          /* binary trace ring buffer, if any */
+    BOOL         ring_closed;   /* the ring buffer was released by the exiting thread */
 };
 
 /* thread private data, stored in NtCurrentTeb()->GdiTebBatch */
@@ -41,6 +43,7 @@ struct ntdll_thread_data
     int                wait_fd[2];    /* fd for sleeping server requests */
     BOOL               wow64_redir;   /* Wow64 filesystem redirection flag */
     pthread_t          pthread_id;    /* pthread thread id */
+    struct thread_counters counters;  /* instrumentation counters */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -59,6 +62,7 @@ int  CDECL mmap_enum_reserved_areas( int (CDECL *enum_func)(void *base, SIZE_T s
 extern void virtual_init(void) DECLSPEC_HIDDEN;
 
 extern void CDECL dbg_init(void) DECLSPEC_HIDDEN;
+extern void dbg_exit_thread(void) DECLSPEC_HIDDEN;
 
 extern unsigned int CDECL server_call_unlocked( void *req_ptr ) DECLSPEC_HIDDEN;
 extern unsigned int CDECL server_select( const select_op_t *select_op, data_size_t size, UINT flags,
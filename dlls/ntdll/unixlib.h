@@ -26,8 +26,21 @@
 
 struct ldt_copy;
 
+/* per-thread instrumentation counters, kept in the thread data of the TEB
+ * each counter is only updated by its own thread with a plain increment, readers
+ * in other threads or processes only get an approximate snapshot */
+struct thread_counters
+{
+    ULONGLONG server_calls;     /* server requests */
+    ULONGLONG sync_waits;       /* contended waits on synchronization primitives */
+    ULONGLONG heap_allocs;      /* heap allocations */
+    ULONGLONG page_faults;      /* faults handled by the virtual memory code */
+    ULONGLONG exceptions;       /* exceptions dispatched */
+    struct thread_counters *exited;  /* totals of the threads that have exited */
+};
+
 /* increment this when you change the function table */
-#define NTDLL_UNIXLIB_VERSION 14
+#define NTDLL_UNIXLIB_VERSION 15
 
 struct unix_funcs
 {
@@ -59,6 +59,7 @@
 #include "wine/exception.h"
 #include "wine/rbtree.h"
 #include "wine/debug.h"
+#include "ddk/wdm.h"
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(virtual);
@@ -401,6 +402,58 @@ static BYTE get_page_vprot( const void *addr )
 }
 
 
+/***********************************************************************
+ *           get_vprot_range_size
+ *
+ * Return the size of the range starting at base whose pages all have the
+ * same vprot bits (after masking) as the first one, scanning at most size bytes.
+ * Also return the protection byte of the first page.
+ * The range must be page-aligned and lie inside a single view, so that
+ * the protection bytes are allocated for all of it.
+ */
+static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vprot )
+{
+    static const UINT_PTR word_from_byte = ~(UINT_PTR)0 / 0xff;
+    static const size_t index_align_mask = sizeof(UINT_PTR) - 1;
+    size_t curr_idx, start_idx, end_idx, aligned_start_idx;
+    UINT_PTR vprot_word, mask_word;
+    const BYTE *vprot_ptr;
+
+    curr_idx = start_idx = (size_t)base >> page_shift;
+    end_idx = start_idx + (size >> page_shift);
+    aligned_start_idx = min( (start_idx + index_align_mask) & ~index_align_mask, end_idx );
+
+#ifdef _WIN64
+    vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift] + (curr_idx & pages_vprot_mask);
+#else
+    vprot_ptr = pages_vprot + curr_idx;
+#endif
+    *vprot = *vprot_ptr;
+
+    /* compare byte by byte until the index is word-aligned */
+    for ( ; curr_idx < aligned_start_idx; curr_idx++, vprot_ptr++)
+        if ((*vprot ^ *vprot_ptr) & mask) return (curr_idx - start_idx) << page_shift;
+
+    /* then a word at a time; the protection tables are a multiple of the word size,
+     * so reading a full word at the end of the range never crosses a table boundary */
+    vprot_word = word_from_byte * *vprot;
+    mask_word = word_from_byte * mask;
+    for ( ; curr_idx < end_idx; curr_idx += sizeof(UINT_PTR), vprot_ptr += sizeof(UINT_PTR))
+    {
+#ifdef _WIN64
+        if (!(curr_idx & pages_vprot_mask)) vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift];
+#endif
+        if ((vprot_word ^ *(const UINT_PTR *)vprot_ptr) & mask_word)
+        {
+            for ( ; curr_idx < end_idx; curr_idx++, vprot_ptr++)
+                if ((*vprot ^ *vprot_ptr) & mask) break;
+            return (curr_idx - start_idx) << page_shift;
+        }
+    }
+    return size;
+}
+
+
 /***********************************************************************
  *           set_page_vprot
  *
@@ -569,6 +622,8 @@ static void VIRTUAL_DumpView( struct file_view *view )
         TRACE( " (file)\n" );
     else if (view->protect & (SEC_RESERVE | SEC_COMMIT))
         TRACE( " (anonymous)\n" );
+    else if (view->protect & SEC_LARGE_PAGES)
+        TRACE( " (valloc, large pages)\n" );
     else
         TRACE( " (valloc)\n");
 
@@ -1339,13 +1394,13 @@ static void reset_write_watches( void *base, SIZE_T size )
 /***********************************************************************
  *           unmap_extra_space
  *
- * Release the extra memory while keeping the range starting on the granularity boundary.
+ * Release the extra memory while keeping the range starting on the alignment boundary.
  */
-static inline void *unmap_extra_space( void *ptr, size_t total_size, size_t wanted_size )
+static inline void *unmap_extra_space( void *ptr, size_t total_size, size_t wanted_size, size_t align_mask )
 {
-    if ((ULONG_PTR)ptr & granularity_mask)
+    if ((ULONG_PTR)ptr & align_mask)
     {
-        size_t extra = granularity_mask + 1 - ((ULONG_PTR)ptr & granularity_mask);
+        size_t extra = align_mask + 1 - ((ULONG_PTR)ptr & align_mask);
         munmap( ptr, extra );
         ptr = (char *)ptr + extra;
         total_size -= extra;
@@ -1461,66 +1516,61 @@ static NTSTATUS map_fixed_area( void *base, size_t size, unsigned int vprot )
 }
 
 /***********************************************************************
- *           map_view
+ *           map_aligned_view
  *
- * Create a view and mmap the corresponding memory area.
+ * Create a view at a free address aligned to the given mask, which is at least the granularity.
+ * The extra space needed for the alignment is mapped along with the view and trimmed
+ * afterwards, so that the range never becomes available to other mappings in between.
  * The csVirtual section must be held by caller.
  */
-static NTSTATUS map_view( struct file_view **view_ret, void *base, size_t size,
-                          int top_down, unsigned int vprot, unsigned short zero_bits_64 )
+static NTSTATUS map_aligned_view( struct file_view **view_ret, size_t size, size_t align_mask,
+                                  int top_down, unsigned int vprot, unsigned short zero_bits_64 )
 {
-    void *ptr;
+    size_t view_size = size + align_mask + 1;
+    struct alloc_area alloc;
     NTSTATUS status;
+    void *ptr;
 
-    if (base)
-    {
-        if (is_beyond_limit( base, size, address_space_limit ))
-            return STATUS_WORKING_SET_LIMIT_RANGE;
-        status = map_fixed_area( base, size, vprot );
-        if (status != STATUS_SUCCESS) return status;
-        ptr = base;
-    }
-    else
-    {
-        size_t view_size = size + granularity_mask + 1;
-        struct alloc_area alloc;
+    if (view_size < size) return STATUS_NO_MEMORY;
 
-        alloc.size = size;
-        alloc.top_down = top_down;
-        alloc.limit = (void*)(get_zero_bits_64_mask( zero_bits_64 ) & (UINT_PTR)user_space_limit);
+    /* free areas are granularity aligned, so that much less is needed to align them */
+    alloc.size = size + align_mask - granularity_mask;
+    alloc.top_down = top_down;
+    alloc.limit = (void*)(get_zero_bits_64_mask( zero_bits_64 ) & (UINT_PTR)user_space_limit);
 
-        if (unix_funcs->mmap_enum_reserved_areas( alloc_reserved_area_callback, &alloc, top_down ))
-        {
-            ptr = alloc.result;
-            TRACE( "got mem in reserved area %p-%p\n", ptr, (char *)ptr + size );
-            if (wine_anon_mmap( ptr, size, VIRTUAL_GetUnixProt(vprot), MAP_FIXED ) != ptr)
-                return STATUS_INVALID_PARAMETER;
-            goto done;
-        }
+    if (unix_funcs->mmap_enum_reserved_areas( alloc_reserved_area_callback, &alloc, top_down ))
+    {
+        if (top_down) ptr = ROUND_ADDR( (char *)alloc.result + alloc.size - size, align_mask );
+        else ptr = ROUND_ADDR( (char *)alloc.result + align_mask, align_mask );
+        TRACE( "got mem in reserved area %p-%p\n", ptr, (char *)ptr + size );
+        if (wine_anon_mmap( ptr, size, VIRTUAL_GetUnixProt(vprot), MAP_FIXED ) != ptr)
+            return STATUS_INVALID_PARAMETER;
+        goto done;
+    }
 
-        if (zero_bits_64)
-        {
-            if (!(ptr = map_free_area( address_space_start, alloc.limit, size,
-                                       top_down, VIRTUAL_GetUnixProt(vprot) )))
-                return STATUS_NO_MEMORY;
-            TRACE( "got mem with map_free_area %p-%p\n", ptr, (char *)ptr + size );
-            goto done;
-        }
+    if (zero_bits_64)
+    {
+        if (!(ptr = map_free_area( address_space_start, alloc.limit, alloc.size,
+                                   top_down, VIRTUAL_GetUnixProt(vprot) )))
+            return STATUS_NO_MEMORY;
+        TRACE( "got mem with map_free_area %p-%p\n", ptr, (char *)ptr + alloc.size );
+        ptr = unmap_extra_space( ptr, alloc.size, size, align_mask );
+        goto done;
+    }
 
-        for (;;)
+    for (;;)
+    {
+        if ((ptr = wine_anon_mmap( NULL, view_size, VIRTUAL_GetUnixProt(vprot), 0 )) == (void *)-1)
         {
-            if ((ptr = wine_anon_mmap( NULL, view_size, VIRTUAL_GetUnixProt(vprot), 0 )) == (void *)-1)
-            {
-                if (errno == ENOMEM) return STATUS_NO_MEMORY;
-                return STATUS_INVALID_PARAMETER;
-            }
-            TRACE( "got mem with anon mmap %p-%p\n", ptr, (char *)ptr + size );
-            /* if we got something beyond the user limit, unmap it and retry */
-            if (is_beyond_limit( ptr, view_size, user_space_limit )) add_reserved_area( ptr, view_size );
-            else break;
+            if (errno == ENOMEM) return STATUS_NO_MEMORY;
+            return STATUS_INVALID_PARAMETER;
         }
-        ptr = unmap_extra_space( ptr, view_size, size );
+        TRACE( "got mem with anon mmap %p-%p\n", ptr, (char *)ptr + size );
+        /* if we got something beyond the user limit, unmap it and retry */
+        if (is_beyond_limit( ptr, view_size, user_space_limit )) add_reserved_area( ptr, view_size );
+        else break;
     }
+    ptr = unmap_extra_space( ptr, view_size, size, align_mask );
 done:
     status = create_view( view_ret, ptr, size, vprot );
     if (status != STATUS_SUCCESS) unmap_area( ptr, size );
@@ -1528,6 +1578,29 @@ done:
 }
 
 
+/***********************************************************************
+ *           map_view
+ *
+ * Create a view and mmap the corresponding memory area.
+ * The csVirtual section must be held by caller.
+ */
+static NTSTATUS map_view( struct file_view **view_ret, void *base, size_t size,
+                          int top_down, unsigned int vprot, unsigned short zero_bits_64 )
+{
+    NTSTATUS status;
+
+    if (!base) return map_aligned_view( view_ret, size, granularity_mask, top_down, vprot, zero_bits_64 );
+
+    if (is_beyond_limit( base, size, address_space_limit ))
+        return STATUS_WORKING_SET_LIMIT_RANGE;
+    status = map_fixed_area( base, size, vprot );
+    if (status != STATUS_SUCCESS) return status;
+    status = create_view( view_ret, base, size, vprot );
+    if (status != STATUS_SUCCESS) unmap_area( base, size );
+    return status;
+}
+
+
 /***********************************************************************
  *           map_file_into_view
  *
@@ -1604,14 +1677,13 @@ done:
  */
 static SIZE_T get_committed_size( struct file_view *view, void *base, BYTE *vprot )
 {
-    SIZE_T i, start;
-
-    start = ((char *)base - (char *)view->base) >> page_shift;
-    *vprot = get_page_vprot( base );
+    SIZE_T start = ((char *)base - (char *)view->base) >> page_shift;
 
     if (view->protect & SEC_RESERVE)
     {
         SIZE_T ret = 0;
+
+        *vprot = get_page_vprot( base );
         SERVER_START_REQ( get_mapping_committed_range )
         {
             req->base   = wine_server_client_ptr( view->base );
@@ -1629,9 +1701,7 @@ static SIZE_T get_committed_size( struct file_view *view, void *base, BYTE *vpro
         SERVER_END_REQ;
         return ret;
     }
-    for (i = start + 1; i < view->size >> page_shift; i++)
-        if ((*vprot ^ get_page_vprot( (char *)view->base + (i << page_shift) )) & VPROT_COMMITTED) break;
-    return (i - start) << page_shift;
+    return get_vprot_range_size( base, view->size - (start << page_shift), VPROT_COMMITTED, vprot );
 }
 
 
@@ -1745,6 +1815,47 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
 }
 
 
+/***********************************************************************
+ *           get_image_cache_base
+ *
+ * Return the address of the most recently used relocated copy of an image, if any.
+ */
+static void *get_image_cache_base( HANDLE mapping )
+{
+    void *ret = NULL;
+
+    SERVER_START_REQ( get_image_cache )
+    {
+        req->mapping = wine_server_obj_handle( mapping );
+        req->base    = 0;
+        if (!wine_server_call( req )) ret = wine_server_get_ptr( reply->base );
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
+
+/***********************************************************************
+ *           get_image_cache_file
+ *
+ * Return a handle to a copy of an image relocated to the given address.
+ * The server builds it from the file in the background on first use.
+ */
+static HANDLE get_image_cache_file( HANDLE mapping, void *base )
+{
+    HANDLE ret = 0;
+
+    SERVER_START_REQ( get_image_cache )
+    {
+        req->mapping = wine_server_obj_handle( mapping );
+        req->base    = wine_server_client_ptr( base );
+        if (!wine_server_call( req )) ret = wine_server_ptr_handle( reply->file );
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
+
 /***********************************************************************
  *           map_image
  *
@@ -1760,13 +1871,15 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, int top_
     IMAGE_DATA_DIRECTORY *imports;
     NTSTATUS status = STATUS_CONFLICTING_ADDRESSES;
     SIZE_T header_size, total_size = image_info->map_size;
-    int i;
+    int i, cache_fd = -1, cache_needs_close = 0;
     off_t pos;
     sigset_t sigset;
     struct stat st;
     struct file_view *view = NULL;
+    HANDLE cache_file = 0;
     char *ptr, *header_end, *header_start;
     char *base = wine_server_get_ptr( image_info->base );
+    void *cache_base;
 
     if (total_size != image_info->map_size)  /* truncated */
     {
@@ -1783,6 +1896,11 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, int top_
         status = map_view( &view, base, total_size, top_down, SEC_IMAGE | SEC_FILE |
                            VPROT_COMMITTED | VPROT_READ | VPROT_EXEC | VPROT_WRITECOPY, zero_bits_64 );
 
+    /* try the address of an already relocated copy, so that its pages can be shared */
+    if (status != STATUS_SUCCESS && !zero_bits_64 && (cache_base = get_image_cache_base( hmapping )))
+        status = map_view( &view, cache_base, total_size, top_down, SEC_IMAGE | SEC_FILE |
+                           VPROT_COMMITTED | VPROT_READ | VPROT_EXEC | VPROT_WRITECOPY, zero_bits_64 );
+
     if (status != STATUS_SUCCESS)
         status = map_view( &view, NULL, total_size, top_down, SEC_IMAGE | SEC_FILE |
                            VPROT_COMMITTED | VPROT_READ | VPROT_EXEC | VPROT_WRITECOPY, zero_bits_64 );
@@ -1847,6 +1965,17 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, int top_
     }
 
 
+    /* map the relocated copy of the image if the server has one for this address */
+
+    if (ptr != base && (cache_file = get_image_cache_file( hmapping, ptr )) &&
+        !unix_funcs->server_get_unix_fd( cache_file, FILE_READ_DATA, &cache_fd, &cache_needs_close, NULL, NULL ))
+    {
+        TRACE_(module)( "mapping relocated image copy at %p-%p\n", ptr, ptr + total_size );
+        if (map_file_into_view( view, cache_fd, 0, total_size, 0, VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY,
+                                FALSE ) != STATUS_SUCCESS) goto error;
+    }
+    else cache_fd = -1;
+
     /* map all the sections */
 
     for (i = pos = 0; i < nt->FileHeader.NumberOfSections; i++, sec++)
@@ -1908,7 +2037,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, int top_
                         sec->PointerToRawData, sec->SizeOfRawData,
                         sec->Misc.VirtualSize, sec->Characteristics );
 
-        if (!sec->PointerToRawData || !file_size) continue;
+        if (cache_fd != -1 || !sec->PointerToRawData || !file_size) continue;
 
         /* Note: if the section is not aligned properly map_file_into_view will magically
          *       fall back to read(), so we don't need to check anything here.
@@ -1984,6 +2113,8 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, int top_
     VIRTUAL_DEBUG_DUMP_VIEW( view );
     server_leave_uninterrupted_section( &csVirtual, &sigset );
 
+    if (cache_needs_close) close( cache_fd );
+    if (cache_file) close_handle( cache_file );
     *addr_ptr = ptr;
 #ifdef VALGRIND_LOAD_PDB_DEBUGINFO
     VALGRIND_LOAD_PDB_DEBUGINFO(fd, ptr, total_size, ptr - base);
@@ -1994,6 +2125,8 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, int top_
  error:
     if (view) delete_view( view );
     server_leave_uninterrupted_section( &csVirtual, &sigset );
+    if (cache_needs_close) close( cache_fd );
+    if (cache_file) close_handle( cache_file );
     return status;
 }
 
@@ -2619,6 +2752,7 @@ NTSTATUS virtual_handle_fault( LPCVOID addr, DWORD err, BOOL on_signal_stack )
             set_page_vprot_bits( page, page_size, 0, VPROT_READ | VPROT_EXEC );
     }
     server_leave_uninterrupted_section( &csVirtual, &sigset );
+    if (!ret) get_thread_counters()->page_faults++;
     return ret;
 }
 
@@ -3051,6 +3185,32 @@ void virtual_set_large_address_space(void)
 }
 
 
+/***********************************************************************
+ *           has_lock_memory_privilege
+ *
+ * Check whether the current thread holds the privilege needed for large pages.
+ */
+static BOOL has_lock_memory_privilege(void)
+{
+    PRIVILEGE_SET privs;
+    BOOLEAN ret = FALSE;
+    HANDLE token;
+
+    if (NtOpenThreadToken( GetCurrentThread(), TOKEN_QUERY, TRUE, &token ) &&
+        NtOpenProcessToken( GetCurrentProcess(), TOKEN_QUERY, &token ))
+        return FALSE;
+
+    privs.PrivilegeCount = 1;
+    privs.Control = PRIVILEGE_SET_ALL_NECESSARY;
+    privs.Privilege[0].Luid.LowPart = SE_LOCK_MEMORY_PRIVILEGE;
+    privs.Privilege[0].Luid.HighPart = 0;
+    privs.Privilege[0].Attributes = 0;
+    if (NtPrivilegeCheck( token, &privs, &ret )) ret = FALSE;
+    NtClose( token );
+    return ret;
+}
+
+
 /***********************************************************************
  *             NtAllocateVirtualMemory   (NTDLL.@)
  *             ZwAllocateVirtualMemory   (NTDLL.@)
@@ -3064,6 +3224,7 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
     struct file_view *view;
     sigset_t sigset;
     SIZE_T size = *size_ptr;
+    SIZE_T large_page_mask = user_shared_data->LargePageMinimum - 1;
     NTSTATUS status = STATUS_SUCCESS;
     unsigned short zero_bits_64 = zero_bits_win_to_64( zero_bits );
 
@@ -3128,12 +3289,22 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
     /* Compute the alloc type flags */
 
     if (!(type & (MEM_COMMIT | MEM_RESERVE | MEM_RESET)) ||
-        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET)))
+        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET | MEM_LARGE_PAGES)))
     {
         WARN("called with wrong alloc type flags (%08x) !\n", type);
         return STATUS_INVALID_PARAMETER;
     }
 
+    if (type & MEM_LARGE_PAGES)
+    {
+        /* large pages must be reserved and committed at once, aligned to the large page size */
+        if ((type & (MEM_COMMIT | MEM_RESERVE)) != (MEM_COMMIT | MEM_RESERVE) || (type & MEM_WRITE_WATCH))
+            return STATUS_INVALID_PARAMETER;
+        if ((*size_ptr & large_page_mask) || ((UINT_PTR)*ret & large_page_mask))
+            return STATUS_INVALID_PARAMETER;
+        if (!has_lock_memory_privilege()) return STATUS_PRIVILEGE_NOT_HELD;
+    }
+
     /* Reserve the memory */
 
     if (use_locks) server_enter_uninterrupted_section( &csVirtual, &sigset );
@@ -3145,12 +3316,22 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
             if (type & MEM_COMMIT) vprot |= VPROT_COMMITTED;
             if (type & MEM_WRITE_WATCH) vprot |= VPROT_WRITEWATCH;
             if (protect & PAGE_NOCACHE) vprot |= SEC_NOCACHE;
+            if (type & MEM_LARGE_PAGES) vprot |= SEC_LARGE_PAGES;
 
             if (vprot & VPROT_WRITECOPY) status = STATUS_INVALID_PAGE_PROTECTION;
             else if (is_dos_memory) status = allocate_dos_memory( &view, vprot );
+            else if (!base && (type & MEM_LARGE_PAGES) && large_page_mask > granularity_mask)
+                status = map_aligned_view( &view, size, large_page_mask, type & MEM_TOP_DOWN, vprot, zero_bits_64 );
             else status = map_view( &view, base, size, type & MEM_TOP_DOWN, vprot, zero_bits_64 );
 
-            if (status == STATUS_SUCCESS) base = view->base;
+            if (status == STATUS_SUCCESS)
+            {
+                base = view->base;
+#ifdef MADV_HUGEPAGE
+                /* let the kernel back the view with transparent huge pages */
+                if (vprot & SEC_LARGE_PAGES) madvise( base, size, MADV_HUGEPAGE );
+#endif
+            }
         }
     }
     else if (type & MEM_RESET)
@@ -3498,7 +3679,6 @@ static NTSTATUS get_basic_memory_info( HANDLE process, LPCVOID addr,
     else
     {
         BYTE vprot;
-        char *ptr;
         SIZE_T range_size = get_committed_size( view, base, &vprot );
 
         info->State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
@@ -3507,9 +3687,7 @@ static NTSTATUS get_basic_memory_info( HANDLE process, LPCVOID addr,
         if (view->protect & SEC_IMAGE) info->Type = MEM_IMAGE;
         else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
         else info->Type = MEM_PRIVATE;
-        for (ptr = base; ptr < base + range_size; ptr += page_size)
-            if ((get_page_vprot( ptr ) ^ vprot) & ~(VPROT_WRITEWATCH|VPROT_WRITTEN)) break;
-        info->RegionSize = ptr - base;
+        info->RegionSize = get_vprot_range_size( base, range_size, (BYTE)~(VPROT_WRITEWATCH | VPROT_WRITTEN), &vprot );
     }
     server_leave_uninterrupted_section( &csVirtual, &sigset );
 
@@ -3563,7 +3741,10 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
             if (p->VirtualAttributes.Shared && p->VirtualAttributes.Valid)
                 p->VirtualAttributes.ShareCount = 1; /* FIXME */
             if (p->VirtualAttributes.Valid)
+            {
                 p->VirtualAttributes.Win32Protection = VIRTUAL_GetWin32Prot( vprot, view->protect );
+                p->VirtualAttributes.LargePage = !!(view->protect & SEC_LARGE_PAGES);
+            }
         }
     }
     server_leave_uninterrupted_section( &csVirtual, &sigset );
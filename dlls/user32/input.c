@@ -1282,10 +1282,10 @@ TrackMouseEvent (TRACKMOUSEEVENT *ptme)
  */
 int WINAPI GetMouseMovePointsEx(UINT size, LPMOUSEMOVEPOINT ptin, LPMOUSEMOVEPOINT ptout, int count, DWORD res)
 {
-    POINT pos;
-    static BOOL once;
-    static INT last_x = 0;
-    static INT last_y = 0;
+    struct cursor_pos history[64];
+    int i, copied, total = 0;
+
+    TRACE("(%d %p %p %d %d)\n", size, ptin, ptout, count, res);
 
     if((size != sizeof(MOUSEMOVEPOINT)) || (count < 0) || (count > 64)) {
         SetLastError(ERROR_INVALID_PARAMETER);
@@ -1297,40 +1297,42 @@ int WINAPI GetMouseMovePointsEx(UINT size, LPMOUSEMOVEPOINT ptin, LPMOUSEMOVEPOI
         return -1;
     }
 
-    if (!once++)
-        FIXME("(%d %p %p %d %d) semi-stub\n", size, ptin, ptout, count, res);
-    else
-        TRACE("(%d %p %p %d %d) semi-stub\n", size, ptin, ptout, count, res);
+    if (res == GMMP_USE_HIGH_RESOLUTION_POINTS)
+    {
+        WARN("GMMP_USE_HIGH_RESOLUTION_POINTS not supported\n");
+        SetLastError(ERROR_POINT_NOT_FOUND);
+        return -1;
+    }
 
-    TRACE("    ptin: %d %d\n", ptin->x, ptin->y);
+    SERVER_START_REQ( get_cursor_history )
+    {
+        wine_server_set_reply( req, history, sizeof(history) );
+        if (!wine_server_call_err( req )) total = wine_server_reply_size( reply ) / sizeof(history[0]);
+    }
+    SERVER_END_REQ;
 
-    if (res == GMMP_USE_HIGH_RESOLUTION_POINTS)
+    /* the history is sorted from the most recent point, look for the requested one */
+    for (i = 0; i < total; i++)
+    {
+        if (history[i].x != ptin->x || history[i].y != ptin->y) continue;
+        if (ptin->time && history[i].time != ptin->time) continue;
+        break;
+    }
+    if (i == total)
     {
-        WARN("GMMP_USE_HIGH_RESOLUTION_POINTS not supported");
         SetLastError(ERROR_POINT_NOT_FOUND);
         return -1;
     }
 
-    GetCursorPos(&pos);
-    
-    ptout[0].x = pos.x;
-    ptout[0].y = pos.y;
-    ptout[0].time = GetTickCount();
-    ptout[0].dwExtraInfo = 0;
-    TRACE("    ptout[0]: %d %d\n", pos.x, pos.y);
-    
-    if (count > 1) {
-        ptout[1].x = last_x;
-        ptout[1].y = last_y;
-        ptout[1].time = GetTickCount();
-        ptout[1].dwExtraInfo = 0;
-        TRACE("    ptout[1]: %d %d\n", last_x, last_y);
+    for (copied = 0; copied < count && i < total; copied++, i++)
+    {
+        ptout[copied].x = history[i].x;
+        ptout[copied].y = history[i].y;
+        ptout[copied].time = history[i].time;
+        ptout[copied].dwExtraInfo = history[i].info;
+        TRACE("    ptout[%d]: %d %d\n", copied, history[i].x, history[i].y);
     }
-    
-    last_x = pos.x;
-    last_y = pos.y;
-        
-    return count > 1 ? 2 : 1;
+    return copied;
 }
 
 /***********************************************************************
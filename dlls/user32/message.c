@@ -40,6 +40,7 @@
 #include "imm.h"
 #include "ddk/imm.h"
 #include "wine/unicode.h"
+#include "wine/list.h"
 #include "wine/server.h"
 #include "user_private.h"
 #include "win.h"
@@ -262,6 +263,7 @@ struct received_message_info
     enum message_type type;
     MSG               msg;
     UINT              flags;  /* InSendMessageEx return flags */
+    struct inproc_message *inproc;  /* in-process message being replied to */
 };
 
 /* structure to group all parameters for sent messages of the various kinds */
@@ -280,6 +282,61 @@ struct send_message_info
     enum wm_char_mapping wm_char;
 };
 
+/* Messages sent between threads of the same process are queued to the receiving thread
+ * directly, and only a WM_WINE_INPROC_SEND notification goes through the server so that
+ * the ordering with the other sent messages and the queue status are preserved. The
+ * sender waits for the reply on its wake up counter, it only needs to be woken through
+ * the server when it's blocked waiting on its server queue.
+ * A queue may be left behind by a killed thread, and its thread id reused by a new
+ * thread, so the receiver checks that it owns the window before calling it, and the
+ * sender gives up once the window no longer belongs to the receiving thread. */
+
+#define INPROC_WAIT_TIMEOUT  10000  /* time to wait for a reply before waiting on the server queue, in 100ns units */
+
+enum inproc_status
+{
+    INPROC_PENDING,
+    INPROC_REPLIED,
+    INPROC_FAILED
+};
+
+/* a message sent to another thread of the process, referenced by the sender and the receiver */
+struct inproc_message
+{
+    struct list           entry;     /* entry in the receiver queue */
+    LONG                  refcount;
+    UINT                  id;        /* id passed in the server notification */
+    enum message_type     type;      /* MSG_ASCII or MSG_UNICODE */
+    HWND                  hwnd;
+    UINT                  msg;
+    WPARAM                wparam;
+    LPARAM                lparam;
+    LRESULT               result;
+    LONG                  status;    /* enum inproc_status */
+    struct inproc_queue  *sender;    /* queue of the sending thread */
+};
+
+struct inproc_queue
+{
+    struct list           entry;     /* entry in the process list */
+    DWORD                 tid;       /* owner thread */
+    struct list           messages;  /* messages waiting to be received */
+    LONG                  wake_seq;  /* wake up counter */
+    LONG                  server_wait;  /* owner is waiting on its server queue */
+};
+
+static struct list inproc_queues = LIST_INIT( inproc_queues );
+static LONG inproc_message_id;
+
+static CRITICAL_SECTION inproc_section;
+static CRITICAL_SECTION_DEBUG inproc_section_debug =
+{
+    0, 0, &inproc_section,
+    { &inproc_section_debug.ProcessLocksList, &inproc_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": inproc_section") }
+};
+static CRITICAL_SECTION inproc_section = { &inproc_section_debug, -1, 0, 0, 0, 0 };
+
 static const INPUT_MESSAGE_SOURCE msg_source_unavailable = { IMDT_UNAVAILABLE, IMO_UNAVAILABLE };
 
 
@@ -1814,6 +1871,138 @@ static void unpack_reply( HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam,
 }
 
 
+/* find the in-process queue of a thread; inproc_section must be held */
+static struct inproc_queue *find_inproc_queue( DWORD tid )
+{
+    struct inproc_queue *queue;
+
+    LIST_FOR_EACH_ENTRY( queue, &inproc_queues, struct inproc_queue, entry )
+        if (queue->tid == tid) return queue;
+    return NULL;
+}
+
+/***********************************************************************
+ *           get_inproc_queue
+ *
+ * Get the in-process message queue of the current thread, creating it if needed.
+ */
+static struct inproc_queue *get_inproc_queue(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct inproc_queue *queue;
+
+    if ((queue = thread_info->inproc_queue)) return queue;
+
+    EnterCriticalSection( &inproc_section );
+    /* a queue with the same thread id was left behind by a killed thread; its messages
+     * may already have been notified to this thread, and it may still be referenced as
+     * the sender of messages, so it is taken over instead of being freed */
+    if ((queue = find_inproc_queue( GetCurrentThreadId() ))) queue->server_wait = 0;
+    else if ((queue = HeapAlloc( GetProcessHeap(), 0, sizeof(*queue) )))
+    {
+        queue->tid = GetCurrentThreadId();
+        queue->wake_seq = 0;
+        queue->server_wait = 0;
+        list_init( &queue->messages );
+        list_add_tail( &inproc_queues, &queue->entry );
+    }
+    LeaveCriticalSection( &inproc_section );
+    return thread_info->inproc_queue = queue;
+}
+
+/* wake up the owner of a queue; inproc_section must be held
+ * returns TRUE if the owner also needs to be woken through the server */
+static BOOL wake_inproc_queue( struct inproc_queue *queue )
+{
+    InterlockedIncrement( &queue->wake_seq );
+    RtlWakeAddressAll( &queue->wake_seq );
+    return queue->server_wait;
+}
+
+/* wake up a thread waiting on its server queue */
+static void notify_inproc_thread( DWORD tid )
+{
+    SERVER_START_REQ( send_message )
+    {
+        req->id      = tid;
+        req->type    = MSG_NOTIFY;
+        req->flags   = 0;
+        req->win     = 0;
+        req->msg     = WM_WINE_WAKEUP;
+        req->wparam  = 0;
+        req->lparam  = 0;
+        req->timeout = TIMEOUT_INFINITE;
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+}
+
+static void release_inproc_message( struct inproc_message *msg )
+{
+    if (!InterlockedDecrement( &msg->refcount )) HeapFree( GetProcessHeap(), 0, msg );
+}
+
+/***********************************************************************
+ *           reply_inproc_message
+ *
+ * Store the result of an in-process message and wake up the sender.
+ */
+static void reply_inproc_message( struct inproc_message *msg, LRESULT result, enum inproc_status status )
+{
+    struct inproc_queue *sender = msg->sender;
+    DWORD tid = 0;
+
+    msg->result = result;
+    EnterCriticalSection( &inproc_section );
+    /* the sender may return as soon as the status is set, its queue is
+     * only freed once it has been removed from the list */
+    InterlockedExchange( &msg->status, status );
+    if (wake_inproc_queue( sender )) tid = sender->tid;
+    LeaveCriticalSection( &inproc_section );
+    if (tid) notify_inproc_thread( tid );
+}
+
+/* free a queue that has been removed from the process list, failing the pending messages */
+static void destroy_inproc_queue( struct inproc_queue *queue )
+{
+    struct inproc_message *msg;
+    struct list *ptr;
+
+    EnterCriticalSection( &inproc_section );
+    while ((ptr = list_head( &queue->messages )))
+    {
+        list_remove( ptr );
+        list_init( ptr );
+        msg = LIST_ENTRY( ptr, struct inproc_message, entry );
+        reply_inproc_message( msg, 0, INPROC_FAILED );
+        release_inproc_message( msg );
+    }
+    LeaveCriticalSection( &inproc_section );
+    HeapFree( GetProcessHeap(), 0, queue );
+}
+
+/***********************************************************************
+ *           MSG_DestroyInprocQueue
+ *
+ * Destroy the in-process message queue of an exiting thread, failing the pending messages.
+ */
+void MSG_DestroyInprocQueue(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct inproc_queue *queue = thread_info->inproc_queue;
+
+    if (!queue) return;
+
+    EnterCriticalSection( &inproc_section );
+    list_remove( &queue->entry );
+    LeaveCriticalSection( &inproc_section );
+
+    /* no new messages can be queued now */
+    thread_info->inproc_queue = NULL;
+    destroy_inproc_queue( queue );
+}
+
+
 /***********************************************************************
  *           reply_message
  *
@@ -1827,9 +2016,16 @@ static void reply_message( struct received_message_info *info, LRESULT result, B
     if (info->flags & ISMEX_NOTIFY) return;  /* notify messages don't get replies */
     if (!remove && replied) return;  /* replied already */
 
-    memset( &data, 0, sizeof(data) );
     info->flags |= ISMEX_REPLIED;
 
+    if (info->inproc)
+    {
+        if (!replied) reply_inproc_message( info->inproc, result, INPROC_REPLIED );
+        return;
+    }
+
+    memset( &data, 0, sizeof(data) );
+
     if (info->type == MSG_OTHER_PROCESS && !replied)
     {
         pack_reply( info->msg.hwnd, info->msg.message, info->msg.wParam,
@@ -1882,6 +2078,8 @@ static LRESULT handle_internal_message( HWND hwnd, UINT msg, WPARAM wparam, LPAR
 
         return call_current_hook( h_extra->handle, HC_ACTION, wparam, h_extra->lparam );
     }
+    case WM_WINE_WAKEUP:
+        return 0;  /* only used to wake up the thread */
     case WM_WINE_CLIPCURSOR:
         if (wparam)
         {
@@ -2762,6 +2960,67 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/***********************************************************************
+ *           process_inproc_message
+ *
+ * Call the window procedure for the in-process message of a WM_WINE_INPROC_SEND notification.
+ */
+static void process_inproc_message( struct inproc_queue *queue, UINT id )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    INPUT_MESSAGE_SOURCE prev_source = thread_info->msg_source;
+    struct received_message_info info, *old_info;
+    struct inproc_message *msg = NULL, *cur;
+    LRESULT result;
+
+    if (!queue) return;
+
+    EnterCriticalSection( &inproc_section );
+    LIST_FOR_EACH_ENTRY( cur, &queue->messages, struct inproc_message, entry )
+    {
+        if (cur->id != id) continue;
+        msg = cur;
+        list_remove( &msg->entry );
+        list_init( &msg->entry );
+        break;
+    }
+    LeaveCriticalSection( &inproc_section );
+    if (!msg) return;  /* the sender gave up */
+
+    if (!WIN_IsCurrentThread( msg->hwnd ))
+    {
+        /* queued for a killed thread that had the same id */
+        WARN( "in-process msg %x for window %p of another thread\n", msg->msg, msg->hwnd );
+        reply_inproc_message( msg, 0, INPROC_FAILED );
+        release_inproc_message( msg );
+        return;
+    }
+
+    TRACE( "got in-process msg %x (%s) hwnd %p wp %lx lp %lx\n", msg->msg,
+           SPY_GetMsgName(msg->msg, msg->hwnd), msg->hwnd, msg->wparam, msg->lparam );
+
+    memset( &info, 0, sizeof(info) );
+    info.type        = msg->type;
+    info.msg.hwnd    = msg->hwnd;
+    info.msg.message = msg->msg;
+    info.msg.wParam  = msg->wparam;
+    info.msg.lParam  = msg->lparam;
+    info.flags       = ISMEX_SEND;
+    info.inproc      = msg;
+
+    old_info = thread_info->receive_info;
+    thread_info->receive_info = &info;
+    thread_info->msg_source = msg_source_unavailable;
+    result = call_window_proc( info.msg.hwnd, info.msg.message, info.msg.wParam,
+                               info.msg.lParam, (info.type != MSG_ASCII), FALSE,
+                               WMCHAR_MAP_RECVMESSAGE );
+    reply_message( &info, result, TRUE );
+    thread_info->receive_info = old_info;
+    thread_info->msg_source = prev_source;
+    release_inproc_message( msg );
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2779,6 +3038,8 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
     void *buffer;
     size_t buffer_size = 256;
 
+    struct inproc_queue *inproc_queue = get_inproc_queue();
+
     if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return -1;
 
     if (!first && !last) last = ~0;
@@ -2813,6 +3074,7 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
                 info.msg.time    = reply->time;
                 info.msg.pt.x    = reply->x;
                 info.msg.pt.y    = reply->y;
+                info.inproc      = NULL;
                 hw_id            = 0;
                 thread_info->active_hooks = reply->active_hooks;
             }
@@ -2850,6 +3112,12 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
             info.flags = ISMEX_SEND;
             break;
         case MSG_NOTIFY:
+            if (!info.msg.hwnd && info.msg.message == WM_WINE_INPROC_SEND)
+            {
+                process_inproc_message( inproc_queue, info.msg.wParam );
+                if (HIWORD(flags) && !changed_mask) flags = PM_QS_SENDMESSAGE | LOWORD(flags);
+                continue;
+            }
             info.flags = ISMEX_NOTIFY;
             if (!unpack_message( info.msg.hwnd, info.msg.message, &info.msg.wParam,
                                  &info.msg.lParam, &buffer, size ))
@@ -3245,18 +3513,186 @@ static LRESULT retrieve_reply( const struct send_message_info *info,
 }
 
 
+/* check whether a thread is still running */
+static BOOL is_thread_alive( DWORD tid )
+{
+    HANDLE handle;
+    BOOL ret;
+
+    if (!(handle = OpenThread( SYNCHRONIZE, FALSE, tid ))) return FALSE;
+    ret = WaitForSingleObject( handle, 0 ) == WAIT_TIMEOUT;
+    CloseHandle( handle );
+    return ret;
+}
+
+/***********************************************************************
+ *		send_inproc_message
+ *
+ * Send a message to another thread of the process. The message is queued to the
+ * receiving thread directly, only the notification and the wake ups go through the server.
+ * Return FALSE if the message has to be sent through the server queue.
+ */
+static BOOL send_inproc_message( const struct send_message_info *info, LRESULT *ret, LRESULT *res_ptr )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    HANDLE server_queue = get_server_queue_handle();
+    struct inproc_queue *self, *queue;
+    struct inproc_message *msg;
+    LARGE_INTEGER timeout;
+    BOOL first_wait = TRUE;
+    NTSTATUS status;
+    LONG seq;
+
+    if (info->type != MSG_ASCII && info->type != MSG_UNICODE) return FALSE;
+    if (info->flags != SMTO_NORMAL || (info->timeout && info->timeout != INFINITE)) return FALSE;
+    if (!(self = get_inproc_queue())) return FALSE;
+    if (!(msg = HeapAlloc( GetProcessHeap(), 0, sizeof(*msg) ))) return FALSE;
+
+    msg->refcount = 2;  /* one for the sender, one for the receiver queue */
+    msg->id     = InterlockedIncrement( &inproc_message_id );
+    msg->type   = info->type;
+    msg->hwnd   = info->hwnd;
+    msg->msg    = info->msg;
+    msg->wparam = info->wparam;
+    msg->lparam = info->lparam;
+    msg->result = 0;
+    msg->status = INPROC_PENDING;
+    msg->sender = self;
+
+    EnterCriticalSection( &inproc_section );
+    if (!(queue = find_inproc_queue( info->dest_tid )))
+    {
+        LeaveCriticalSection( &inproc_section );
+        HeapFree( GetProcessHeap(), 0, msg );
+        return FALSE;
+    }
+    list_add_tail( &queue->messages, &msg->entry );
+    wake_inproc_queue( queue );
+    LeaveCriticalSection( &inproc_section );
+
+    SERVER_START_REQ( send_message )
+    {
+        req->id      = info->dest_tid;
+        req->type    = MSG_NOTIFY;
+        req->flags   = 0;
+        req->win     = 0;
+        req->msg     = WM_WINE_INPROC_SEND;
+        req->wparam  = msg->id;
+        req->lparam  = 0;
+        req->timeout = TIMEOUT_INFINITE;
+        status = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+
+    if (status)
+    {
+        BOOL queued;
+
+        EnterCriticalSection( &inproc_section );
+        if ((queued = !list_empty( &msg->entry ))) list_remove( &msg->entry );
+        LeaveCriticalSection( &inproc_section );
+        if (queued) release_inproc_message( msg );
+        release_inproc_message( msg );
+        return FALSE;
+    }
+
+    timeout.QuadPart = -INPROC_WAIT_TIMEOUT;
+    for (;;)
+    {
+        unsigned int wake_bits = 0;
+        DWORD res = WAIT_OBJECT_0;
+
+        seq = self->wake_seq;
+        if (msg->status != INPROC_PENDING) break;
+
+        /* the reply usually comes quickly, try to get it without a server call */
+        if (first_wait)
+        {
+            first_wait = FALSE;
+            RtlWaitOnAddress( &self->wake_seq, &seq, sizeof(seq), &timeout );
+            continue;
+        }
+
+        /* then keep processing the messages sent to this thread while waiting */
+        SERVER_START_REQ( set_queue_mask )
+        {
+            req->wake_mask    = QS_SENDMESSAGE;
+            req->changed_mask = QS_SENDMESSAGE;
+            req->skip_wait    = 1;
+            if (!wine_server_call( req )) wake_bits = reply->wake_bits & QS_SENDMESSAGE;
+        }
+        SERVER_END_REQ;
+        thread_info->wake_mask = thread_info->changed_mask = 0;
+
+        if (wake_bits)
+        {
+            process_sent_messages();
+            continue;
+        }
+        InterlockedExchange( &self->server_wait, 1 );
+        if (msg->status == INPROC_PENDING && self->wake_seq == seq)
+            res = wow_handlers.wait_message( 1, &server_queue, 1000, QS_SENDMESSAGE, 0 );
+        InterlockedExchange( &self->server_wait, 0 );
+
+        if (res == WAIT_TIMEOUT && !is_thread_alive( info->dest_tid ))
+        {
+            /* the thread was killed without cleaning up its queue */
+            EnterCriticalSection( &inproc_section );
+            if (find_inproc_queue( info->dest_tid ) == queue) list_remove( &queue->entry );
+            else queue = NULL;
+            LeaveCriticalSection( &inproc_section );
+            if (queue) destroy_inproc_queue( queue );
+            /* it may also have been killed while processing the message */
+            InterlockedCompareExchange( &msg->status, INPROC_FAILED, INPROC_PENDING );
+        }
+        else if (res == WAIT_TIMEOUT && GetWindowThreadProcessId( info->hwnd, NULL ) != info->dest_tid)
+        {
+            /* the receiver was killed and its id reused by another thread, which
+             * may never get the notification; the window was destroyed with it */
+            BOOL queued;
+
+            EnterCriticalSection( &inproc_section );
+            if ((queued = !list_empty( &msg->entry )))
+            {
+                list_remove( &msg->entry );
+                list_init( &msg->entry );
+            }
+            LeaveCriticalSection( &inproc_section );
+            if (queued) release_inproc_message( msg );
+            InterlockedCompareExchange( &msg->status, INPROC_FAILED, INPROC_PENDING );
+        }
+    }
+
+    if (msg->status == INPROC_FAILED)
+    {
+        release_inproc_message( msg );
+        SetLastError( RtlNtStatusToDosError( STATUS_ACCESS_DENIED ));
+        *ret = 0;
+        return TRUE;
+    }
+    TRACE( "in-process reply %lx for msg %x\n", msg->result, info->msg );
+    if (res_ptr) *res_ptr = msg->result;
+    release_inproc_message( msg );
+    *ret = 1;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *		send_inter_thread_message
  */
 static LRESULT send_inter_thread_message( const struct send_message_info *info, LRESULT *res_ptr )
 {
     size_t reply_size = 0;
+    LRESULT ret;
 
     TRACE( "hwnd %p msg %x (%s) wp %lx lp %lx\n",
            info->hwnd, info->msg, SPY_GetMsgName(info->msg, info->hwnd), info->wparam, info->lparam );
 
     USER_CheckNotLock();
 
+    if (send_inproc_message( info, &ret, res_ptr )) return ret;
+
     if (!put_message_in_queue( info, &reply_size )) return 0;
 
     /* there's no reply to wait for on notify/callback messages */
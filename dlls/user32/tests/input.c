@@ -1473,7 +1473,8 @@ static void test_GetMouseMovePointsEx(void)
     int count, retval;
     MOUSEMOVEPOINT in;
     MOUSEMOVEPOINT out[200];
-    POINT point;
+    POINT point, moves[BUFLIM * 2];
+    int i, width, height;
 
     /* Get a valid content for the input struct */
     if(!GetCursorPos(&point)) {
@@ -1598,6 +1599,81 @@ static void test_GetMouseMovePointsEx(void)
     ok(GetLastError() == ERROR_INVALID_PARAMETER || GetLastError() == MYERROR,
        "expected error ERROR_INVALID_PARAMETER, got %u\n", GetLastError());
 
+    /* move the cursor more times than the history can hold, the last positions are kept */
+    width = GetSystemMetrics(SM_CXSCREEN);
+    height = GetSystemMetrics(SM_CYSCREEN);
+    for (i = 0; i < ARRAY_SIZE(moves); i++)
+    {
+        mouse_event(MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE, ((10 + 3 * i) * 65536 + width - 1) / width,
+                    ((10 + 2 * i) * 65536 + height - 1) / height, 0, i + 1);
+        GetCursorPos(&moves[i]);
+        if (i && moves[i].x == moves[i - 1].x && moves[i].y == moves[i - 1].y) break;
+    }
+    if (i < ARRAY_SIZE(moves))
+    {
+        skip("cursor didn't move to %d,%d\n", 10 + 3 * i, 10 + 2 * i);
+        goto done;
+    }
+
+    /* the points are returned from the most recent one, which can't be older than the ones after it */
+    memset(&in, 0, sizeof(in));
+    in.x = moves[ARRAY_SIZE(moves) - 1].x;
+    in.y = moves[ARRAY_SIZE(moves) - 1].y;
+    memset(out, 0, sizeof(out));
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out, BUFLIM, GMMP_USE_DISPLAY_POINTS);
+    ok(retval == BUFLIM, "expected %d points, got %d\n", BUFLIM, retval);
+    for (i = 0; i < retval; i++)
+    {
+        const POINT *pt = &moves[ARRAY_SIZE(moves) - 1 - i];
+        ok(out[i].x == pt->x && out[i].y == pt->y, "%d: expected %d,%d, got %d,%d\n",
+           i, pt->x, pt->y, out[i].x, out[i].y);
+        ok(out[i].dwExtraInfo == ARRAY_SIZE(moves) - i, "%d: got extra info %lx\n", i, out[i].dwExtraInfo);
+        if (i) ok(out[i].time <= out[i - 1].time, "%d: time %u is after %u\n", i, out[i].time, out[i - 1].time);
+    }
+
+    /* start from an older point, and get fewer points than available */
+    in.x = moves[ARRAY_SIZE(moves) - 10].x;
+    in.y = moves[ARRAY_SIZE(moves) - 10].y;
+    memset(out, 0, sizeof(out));
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out, BUFLIM, GMMP_USE_DISPLAY_POINTS);
+    ok(retval == BUFLIM - 9, "expected %d points, got %d\n", BUFLIM - 9, retval);
+    ok(out[0].x == in.x && out[0].y == in.y, "expected %d,%d, got %d,%d\n", in.x, in.y, out[0].x, out[0].y);
+    ok(out[0].dwExtraInfo == ARRAY_SIZE(moves) - 9, "got extra info %lx\n", out[0].dwExtraInfo);
+    count = 5;
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out + BUFLIM, count, GMMP_USE_DISPLAY_POINTS);
+    ok(retval == count, "expected %d points, got %d\n", count, retval);
+    ok(!memcmp(out + BUFLIM, out, count * sizeof(*out)), "got different points\n");
+
+    /* the time stamp has to match too when it's given */
+    in.time = out[0].time;
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out + BUFLIM, count, GMMP_USE_DISPLAY_POINTS);
+    ok(retval == count, "expected %d points, got %d\n", count, retval);
+    in.time = out[0].time + 1;
+    SetLastError(MYERROR);
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out + BUFLIM, count, GMMP_USE_DISPLAY_POINTS);
+    ok(retval == -1, "expected GetMouseMovePointsEx to fail, got %d\n", retval);
+    ok(GetLastError() == ERROR_POINT_NOT_FOUND, "expected error ERROR_POINT_NOT_FOUND, got %u\n", GetLastError());
+
+    /* the oldest positions are no longer in the history */
+    memset(&in, 0, sizeof(in));
+    in.x = moves[0].x;
+    in.y = moves[0].y;
+    SetLastError(MYERROR);
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out, BUFLIM, GMMP_USE_DISPLAY_POINTS);
+    ok(retval == -1, "expected GetMouseMovePointsEx to fail, got %d\n", retval);
+    ok(GetLastError() == ERROR_POINT_NOT_FOUND, "expected error ERROR_POINT_NOT_FOUND, got %u\n", GetLastError());
+
+    /* high resolution points use another coordinate space, the display point isn't found there */
+    in.x = moves[ARRAY_SIZE(moves) - 1].x;
+    in.y = moves[ARRAY_SIZE(moves) - 1].y;
+    SetLastError(MYERROR);
+    retval = pGetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &in, out, BUFLIM, GMMP_USE_HIGH_RESOLUTION_POINTS);
+    ok(retval == -1, "expected GetMouseMovePointsEx to fail, got %d\n", retval);
+    ok(GetLastError() == ERROR_POINT_NOT_FOUND, "expected error ERROR_POINT_NOT_FOUND, got %u\n", GetLastError());
+
+done:
+    SetCursorPos(point.x, point.y);
+
 #undef BUFLIM
 #undef MYERROR
 }
@@ -18083,6 +18083,91 @@ static void test_InSendMessage(void)
     UnregisterClassA( "InSendMessage_test", GetModuleHandleA(NULL) );
 }
 
+static HWND send_roundtrip_reply_win;
+static BOOL send_roundtrip_notified;
+
+static LRESULT WINAPI send_roundtrip_wnd_proc( HWND hwnd, UINT msg, WPARAM wp, LPARAM lp )
+{
+    switch (msg)
+    {
+    case WM_USER:
+        ok( InSendMessage(), "InSendMessage returned FALSE\n" );
+        return wp + 1;
+    case WM_USER + 1:
+        /* nested send back to the sending thread */
+        return SendMessageA( send_roundtrip_reply_win, WM_USER, wp, 0 ) + 1;
+    case WM_USER + 2:
+        ok( ReplyMessage( 42 ), "ReplyMessage failed\n" );
+        ok( InSendMessageEx( NULL ) == (ISMEX_SEND | ISMEX_REPLIED), "wrong InSendMessageEx result\n" );
+        return 0;
+    case WM_USER + 3:
+        send_roundtrip_notified = TRUE;
+        return 0;
+    case WM_USER + 4:
+        return send_roundtrip_notified;
+    }
+    return DefWindowProcA( hwnd, msg, wp, lp );
+}
+
+static DWORD WINAPI send_roundtrip_thread( void *arg )
+{
+    HWND win = arg;
+    DWORD i, count = 1000;
+    LRESULT res;
+
+    send_roundtrip_reply_win = CreateWindowA( "SendRoundtrip_test", NULL, 0, 0, 0, 0, 0, NULL, 0, NULL, 0 );
+    ok( send_roundtrip_reply_win != NULL, "CreateWindow failed: %d\n", GetLastError() );
+
+    res = SendMessageA( win, WM_USER, 1, 0 );
+    ok( res == 2, "got %ld\n", res );
+    res = SendMessageA( win, WM_USER + 1, 5, 0 );
+    ok( res == 7, "got %ld\n", res );
+    res = SendMessageA( win, WM_USER + 2, 0, 0 );
+    ok( res == 42, "got %ld\n", res );
+
+    /* sent messages are received in order */
+    ok( SendNotifyMessageA( win, WM_USER + 3, 0, 0 ), "SendNotifyMessage failed: %d\n", GetLastError() );
+    res = SendMessageA( win, WM_USER + 4, 0, 0 );
+    ok( res == TRUE, "notification not received before the sent message\n" );
+
+    for (i = 0; i < count; i++)
+        if (SendMessageA( win, WM_USER, i, 0 ) != i + 1) break;
+    ok( i == count, "wrong result for message %u\n", i );
+
+    DestroyWindow( send_roundtrip_reply_win );
+    PostMessageA( win, WM_QUIT, 0, 0 );
+    return 0;
+}
+
+static void test_SendMessage_roundtrip(void)
+{
+    WNDCLASSA cls;
+    HWND win;
+    MSG msg;
+    HANDLE thread;
+    DWORD tid;
+
+    memset(&cls, 0, sizeof(cls));
+    cls.lpfnWndProc = send_roundtrip_wnd_proc;
+    cls.hInstance = GetModuleHandleA(NULL);
+    cls.lpszClassName = "SendRoundtrip_test";
+    RegisterClassA(&cls);
+
+    win = CreateWindowA( "SendRoundtrip_test", NULL, 0, 0, 0, 0, 0, NULL, 0, NULL, 0 );
+    ok( win != NULL, "CreateWindow failed: %d\n", GetLastError() );
+
+    thread = CreateThread( NULL, 0, send_roundtrip_thread, win, 0, &tid );
+    ok( thread != NULL, "CreateThread failed: %d\n", GetLastError() );
+
+    while (GetMessageA(&msg, NULL, 0, 0)) DispatchMessageA( &msg );
+
+    ok( WaitForSingleObject( thread, 30000 ) == WAIT_OBJECT_0, "WaitForSingleObject failed\n" );
+    CloseHandle( thread );
+
+    DestroyWindow( win );
+    UnregisterClassA( "SendRoundtrip_test", GetModuleHandleA(NULL) );
+}
+
 static const struct message DoubleSetCaptureSeq[] =
 {
     { WM_CAPTURECHANGED, sent },
@@ -18317,6 +18402,7 @@ START_TEST(msg)
     test_SendMessage_other_thread(1);
     test_SendMessage_other_thread(2);
     test_InSendMessage();
+    test_SendMessage_roundtrip();
     test_SetFocus();
     test_SetParent();
     test_PostMessage();
@@ -8928,6 +8928,97 @@ static void test_rtl_layout(void)
     DestroyWindow( parent );
 }
 
+static void window_rects_proc(HWND parent)
+{
+    HANDLE start_event, end_event;
+    HWND child, grandchild;
+    DWORD ret;
+
+    start_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_window_rects_start");
+    ok(start_event != 0, "OpenEvent failed\n");
+    end_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_window_rects_end");
+    ok(end_event != 0, "OpenEvent failed\n");
+
+    child = CreateWindowExA(0, "static", NULL, WS_CHILD, 10, 10, 100, 100, parent, 0, NULL, NULL);
+    ok(child != 0, "CreateWindowEx failed\n");
+    grandchild = CreateWindowExA(0, "static", NULL, WS_CHILD, 5, 5, 20, 20, child, 0, NULL, NULL);
+    ok(grandchild != 0, "CreateWindowEx failed\n");
+    SetEvent(start_event);
+
+    ret = WaitForSingleObject(end_event, 5000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %x\n", ret);
+
+    DestroyWindow(child);
+    CloseHandle(start_event);
+    CloseHandle(end_event);
+}
+
+/* windows of another process, with a mirrored ancestor */
+static void test_other_process_window_rects(const char *argv0)
+{
+    HANDLE start_event, end_event;
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    HWND parent, child, grandchild;
+    char cmd[MAX_PATH];
+    RECT r;
+    POINT pt;
+
+    parent = CreateWindowExA(WS_EX_LAYOUTRTL | WS_EX_NOINHERITLAYOUT, "static", NULL, WS_POPUP,
+            100, 100, 300, 300, NULL, 0, 0, NULL);
+    ok(parent != 0, "CreateWindowEx failed\n");
+
+    start_event = CreateEventA(NULL, FALSE, FALSE, "test_window_rects_start");
+    ok(start_event != 0, "CreateEvent failed\n");
+    end_event = CreateEventA(NULL, FALSE, FALSE, "test_window_rects_end");
+    ok(end_event != 0, "CreateEvent failed\n");
+
+    sprintf(cmd, "%s win window_rects %p\n", argv0, parent);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+    ok(CreateProcessA(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL,
+                &startup, &info), "CreateProcess failed.\n");
+    ok(wait_for_event(start_event, 5000), "didn't get start_event\n");
+
+    child = GetWindow(parent, GW_CHILD);
+    ok(child != 0, "child window not found\n");
+    grandchild = GetWindow(child, GW_CHILD);
+    ok(grandchild != 0, "grandchild window not found\n");
+    ok(!(GetWindowLongA(child, GWL_EXSTYLE) & WS_EX_LAYOUTRTL), "child layout is mirrored\n");
+
+    /* the child is placed from the right edge of its parent */
+    GetWindowRect(child, &r);
+    ok(r.left == 290 && r.top == 110 && r.right == 390 && r.bottom == 210,
+       "wrong rect %s\n", wine_dbgstr_rect(&r));
+    GetWindowRect(grandchild, &r);
+    ok(r.left == 295 && r.top == 115 && r.right == 315 && r.bottom == 135,
+       "wrong rect %s\n", wine_dbgstr_rect(&r));
+    GetClientRect(grandchild, &r);
+    ok(r.left == 0 && r.top == 0 && r.right == 20 && r.bottom == 20,
+       "wrong rect %s\n", wine_dbgstr_rect(&r));
+    MapWindowPoints(grandchild, NULL, (POINT *)&r, 2);
+    ok(r.left == 295 && r.top == 115 && r.right == 315 && r.bottom == 135,
+       "wrong rect %s\n", wine_dbgstr_rect(&r));
+    MapWindowPoints(child, grandchild, (POINT *)&r, 2);
+    ok(r.left == 290 && r.top == 110 && r.right == 310 && r.bottom == 130,
+       "wrong rect %s\n", wine_dbgstr_rect(&r));
+    pt.x = 300;
+    pt.y = 120;
+    MapWindowPoints(NULL, grandchild, &pt, 1);
+    ok(pt.x == 5 && pt.y == 5, "wrong point %d,%d\n", pt.x, pt.y);
+    pt.x = pt.y = 5;
+    ClientToScreen(grandchild, &pt);
+    ok(pt.x == 300 && pt.y == 120, "wrong point %d,%d\n", pt.x, pt.y);
+
+    SetEvent(end_event);
+    wait_child_process(info.hProcess);
+    CloseHandle(start_event);
+    CloseHandle(end_event);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+    DestroyWindow(parent);
+}
+
 static void test_FlashWindow(void)
 {
     HWND hwnd;
@@ -11983,6 +12074,11 @@ START_TEST(win)
             other_process_proc(hwnd);
             return;
         }
+        else if (!strcmp(argv[2], "window_rects"))
+        {
+            window_rects_proc(hwnd);
+            return;
+        }
     }
 
     if (argc == 3 && !strcmp(argv[2], "winproc_limit"))
@@ -12040,6 +12136,7 @@ START_TEST(win)
     test_capture_3(hwndMain, hwndMain2);
     test_capture_4();
     test_rtl_layout();
+    test_other_process_window_rects(argv[0]);
     test_FlashWindow();
     test_FlashWindowEx();
 
@@ -379,6 +379,7 @@ static void thread_detach(void)
     USER_Driver->pThreadDetach();
 
     destroy_thread_windows();
+    MSG_DestroyInprocQueue();
     CloseHandle( thread_info->server_queue );
     HeapFree( GetProcessHeap(), 0, thread_info->wmchar_data );
     HeapFree( GetProcessHeap(), 0, thread_info->key_state );
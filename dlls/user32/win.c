@@ -190,6 +190,140 @@ void *free_user_handle( HANDLE handle, enum user_obj_type type )
 }
 
 
+static const struct shared_window *shared_windows;
+
+/***********************************************************************
+ *           get_shared_windows
+ *
+ * Map the server's shared window table on first use.
+ */
+static const struct shared_window *get_shared_windows(void)
+{
+    static BOOL failed;
+    HANDLE handle = 0;
+    void *ptr = NULL;
+    SIZE_T size = 0;
+    LARGE_INTEGER offset;
+
+    if (shared_windows || failed) return shared_windows;
+
+    SERVER_START_REQ( get_shared_window_table )
+    {
+        if (!wine_server_call( req )) handle = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+
+    offset.QuadPart = 0;
+    if (!handle || NtMapViewOfSection( handle, GetCurrentProcess(), &ptr, 0, 0, &offset,
+                                       &size, ViewShare, 0, PAGE_READONLY ))
+    {
+        WARN( "cannot map the shared window table\n" );
+        if (handle) CloseHandle( handle );
+        failed = TRUE;
+        return NULL;
+    }
+    CloseHandle( handle );
+    if (InterlockedCompareExchangePointer( (void **)&shared_windows, ptr, NULL ))
+        NtUnmapViewOfSection( GetCurrentProcess(), ptr );  /* another thread got there first */
+    return shared_windows;
+}
+
+
+/***********************************************************************
+ *           get_shared_window
+ *
+ * Get a consistent copy of the shared information of a window.
+ * Return FALSE if the shared table is not available; otherwise the
+ * window type is 0 if the handle is not a valid window.
+ */
+static BOOL get_shared_window( HWND hwnd, struct shared_window *info )
+{
+    const struct shared_window *table = get_shared_windows();
+    const volatile struct shared_window *entry;
+    WORD index = USER_HANDLE_TO_INDEX( hwnd );
+    unsigned int seq;
+
+    if (!table) return FALSE;
+    info->type = 0;
+    if (index >= NB_USER_HANDLES) return TRUE;
+
+    entry = &table[index];
+    do
+    {
+        while ((seq = entry->seq) & 1) NtYieldExecution();
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        *info = *(const struct shared_window *)entry;
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    } while (entry->seq != seq);
+
+    if (info->type != USER_WINDOW ||
+        (info->generation != HIWORD(hwnd) && HIWORD(hwnd) && HIWORD(hwnd) != 0xffff))
+        info->type = 0;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           get_shared_window_rects
+ *
+ * Compute the rectangles of a window of another process from the shared table.
+ * Return FALSE if the server needs to be asked instead.
+ */
+static BOOL get_shared_window_rects( HWND hwnd, enum coords_relative relative,
+                                     RECT *rectWindow, RECT *rectClient, BOOL *ret )
+{
+    struct shared_window info, parent;
+    RECT window_rect, client_rect;
+
+    if (!get_shared_window( hwnd, &info )) return FALSE;
+    if (!info.type)
+    {
+        SetLastError( ERROR_INVALID_WINDOW_HANDLE );
+        *ret = FALSE;
+        return TRUE;  /* no point in asking the server */
+    }
+    /* leave DPI scaling and mirroring to the server */
+    if (info.dpi != get_thread_dpi() || (info.ex_style & WS_EX_LAYOUTRTL)) return FALSE;
+
+    SetRect( &window_rect, info.window.left, info.window.top, info.window.right, info.window.bottom );
+    SetRect( &client_rect, info.client.left, info.client.top, info.client.right, info.client.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        OffsetRect( &window_rect, -info.client.left, -info.client.top );
+        OffsetRect( &client_rect, -info.client.left, -info.client.top );
+        break;
+    case COORDS_WINDOW:
+        OffsetRect( &window_rect, -info.window.left, -info.window.top );
+        OffsetRect( &client_rect, -info.window.left, -info.window.top );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window( wine_server_ptr_handle( info.parent ), &parent ) || !parent.type) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL) return FALSE;
+        break;
+    case COORDS_SCREEN:
+        while (info.parent)
+        {
+            if (!get_shared_window( wine_server_ptr_handle( info.parent ), &parent ) || !parent.type) return FALSE;
+            if (!parent.parent) break;  /* desktop window */
+            if (parent.ex_style & WS_EX_LAYOUTRTL) return FALSE;  /* mirrored ancestor */
+            OffsetRect( &window_rect, parent.client.left, parent.client.top );
+            OffsetRect( &client_rect, parent.client.left, parent.client.top );
+            info = parent;
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    *ret = TRUE;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           create_window_handle
  *
@@ -935,6 +1069,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_window_rects( hwnd, relative, rectWindow, rectClient, &ret )) return ret;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2316,6 +2452,7 @@ UINT WINAPI GetDpiForWindow( HWND hwnd )
  */
 static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicode )
 {
+    struct shared_window info;
     LONG_PTR retvalue = 0;
     WND *wndPtr;
 
@@ -2361,6 +2498,12 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if ((offset == GWL_STYLE || offset == GWL_EXSTYLE) && get_shared_window( hwnd, &info ))
+        {
+            if (!info.type) SetLastError( ERROR_INVALID_WINDOW_HANDLE );
+            else retvalue = (offset == GWL_STYLE) ? info.style : info.ex_style;
+            return retvalue;
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -3012,6 +3155,7 @@ INT WINAPI GetWindowTextLengthW( HWND hwnd )
  */
 BOOL WINAPI IsWindow( HWND hwnd )
 {
+    struct shared_window info;
     WND *ptr;
     BOOL ret;
 
@@ -3025,6 +3169,12 @@ BOOL WINAPI IsWindow( HWND hwnd )
     }
 
     /* check other processes */
+    if (get_shared_window( hwnd, &info ))
+    {
+        if (!info.type) SetLastError( ERROR_INVALID_WINDOW_HANDLE );
+        return info.type != 0;
+    }
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3040,6 +3190,7 @@ BOOL WINAPI IsWindow( HWND hwnd )
  */
 DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
 {
+    struct shared_window info;
     WND *ptr;
     DWORD tid = 0;
 
@@ -3059,6 +3210,17 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
     }
 
     /* check other processes */
+    if (ptr == WND_OTHER_PROCESS && get_shared_window( hwnd, &info ))
+    {
+        if (!info.type)
+        {
+            SetLastError( ERROR_INVALID_WINDOW_HANDLE );
+            return 0;
+        }
+        if (process) *process = info.pid;
+        return info.tid;
+    }
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3078,6 +3240,7 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
  */
 HWND WINAPI GetParent( HWND hwnd )
 {
+    struct shared_window info;
     WND *wndPtr;
     HWND retvalue = 0;
 
@@ -3087,7 +3250,13 @@ HWND WINAPI GetParent( HWND hwnd )
         return 0;
     }
     if (wndPtr == WND_DESKTOP) return 0;
-    if (wndPtr == WND_OTHER_PROCESS)
+    if (wndPtr == WND_OTHER_PROCESS && get_shared_window( hwnd, &info ))
+    {
+        if (!info.type) SetLastError( ERROR_INVALID_WINDOW_HANDLE );
+        else if (info.style & WS_POPUP) retvalue = wine_server_ptr_handle( info.owner );
+        else if (info.style & WS_CHILD) retvalue = wine_server_ptr_handle( info.parent );
+    }
+    else if (wndPtr == WND_OTHER_PROCESS)
     {
         LONG style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
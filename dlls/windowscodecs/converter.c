@@ -91,6 +91,110 @@ static inline float to_sRGB_component(float f)
     return 1.055f * powf(f, 1.0f/2.4f) - 0.055f;
 }
 
+/* size of the rows bands converted at once, to keep the intermediate buffers in the cache */
+#define CONVERTER_TILE_SIZE 0x10000
+
+#define SRGB_LUT_SIZE 4096
+
+static BYTE premultiply_table[256][256];   /* [alpha][value] = value * alpha / 255 */
+static BYTE unpremultiply_table[256][256]; /* [alpha][value] = value * 255 / alpha */
+static BYTE srgb_lut[SRGB_LUT_SIZE + 1];   /* encoded value of i / SRGB_LUT_SIZE */
+static float srgb_thresholds[256];         /* smallest linear value encoded as i */
+static INIT_ONCE init_tables_once = INIT_ONCE_STATIC_INIT;
+
+static inline BYTE linear_to_sRGB_byte_slow(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+static inline float float_from_bits(DWORD bits)
+{
+    union { DWORD i; float f; } u;
+    u.i = bits;
+    return u.f;
+}
+
+static BOOL WINAPI init_conversion_tables(INIT_ONCE *once, void *param, void **context)
+{
+    DWORD lo, hi, mid;
+    UINT a, v;
+
+    for (a = 0; a < 256; a++)
+        for (v = 0; v < 256; v++)
+        {
+            premultiply_table[a][v] = v * a / 255;
+            unpremultiply_table[a][v] = a ? v * 255 / a : v;
+        }
+
+    for (v = 0; v <= SRGB_LUT_SIZE; v++)
+        srgb_lut[v] = linear_to_sRGB_byte_slow((float)v / SRGB_LUT_SIZE);
+
+    /* the encoding is monotonic, and so are the bit patterns of positive floats */
+    srgb_thresholds[0] = 0.0f;
+    lo = 0;
+    for (v = 1; v < 256; v++)
+    {
+        hi = 0x3f800000; /* 1.0f */
+        while (lo < hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            if (linear_to_sRGB_byte_slow(float_from_bits(mid)) >= v) hi = mid;
+            else lo = mid + 1;
+        }
+        srgb_thresholds[v] = float_from_bits(lo);
+    }
+
+    return TRUE;
+}
+
+/* same result as linear_to_sRGB_byte_slow, without calling powf for each pixel */
+static inline BYTE linear_to_sRGB_byte(float f)
+{
+    BYTE v;
+
+    if (!(f >= 0.0f && f <= 1.0f)) return linear_to_sRGB_byte_slow(f);
+
+    v = srgb_lut[(UINT)(f * SRGB_LUT_SIZE)];
+    while (v < 255 && f >= srgb_thresholds[v + 1]) v++;
+    return v;
+}
+
+static void premultiply_pixels(BYTE *bits, INT width, INT height, UINT stride)
+{
+    INT x, y;
+
+    for (y = 0; y < height; y++)
+    {
+        BYTE *pixel = bits + stride * y;
+
+        for (x = 0; x < width; x++, pixel += 4)
+        {
+            const BYTE *table = premultiply_table[pixel[3]];
+            pixel[0] = table[pixel[0]];
+            pixel[1] = table[pixel[1]];
+            pixel[2] = table[pixel[2]];
+        }
+    }
+}
+
+static void unpremultiply_pixels(BYTE *bits, INT width, INT height, UINT stride)
+{
+    INT x, y;
+
+    for (y = 0; y < height; y++)
+    {
+        BYTE *pixel = bits + stride * y;
+
+        for (x = 0; x < width; x++, pixel += 4)
+        {
+            const BYTE *table = unpremultiply_table[pixel[3]];
+            pixel[0] = table[pixel[0]];
+            pixel[1] = table[pixel[1]];
+            pixel[2] = table[pixel[2]];
+        }
+    }
+}
+
 #if 0 /* FIXME: enable once needed */
 static inline float from_sRGB_component(float f)
 {
@@ -727,6 +831,40 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             return IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
         return S_OK;
     case format_32bppPBGRA:
+        if (prc)
+        {
+            HRESULT res;
+
+            res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (FAILED(res)) return res;
+
+            unpremultiply_pixels(pbBuffer, prc->Width, prc->Height, cbStride);
+        }
+        return S_OK;
+    case format_32bppRGB:
+    case format_32bppRGBA:
+    case format_32bppPRGBA:
+        if (prc)
+        {
+            HRESULT res;
+            INT x, y;
+
+            res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (FAILED(res)) return res;
+
+            reverse_bgr8(4, pbBuffer, prc->Width, prc->Height, cbStride);
+
+            if (source_format == format_32bppPRGBA)
+                unpremultiply_pixels(pbBuffer, prc->Width, prc->Height, cbStride);
+            else if (source_format == format_32bppRGB)
+            {
+                for (y=0; y<prc->Height; y++)
+                    for (x=0; x<prc->Width; x++)
+                        pbBuffer[cbStride*y+4*x+3] = 0xff;
+            }
+        }
+        return S_OK;
+    case format_32bppGrayFloat:
         if (prc)
         {
             HRESULT res;
@@ -736,16 +874,15 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             if (FAILED(res)) return res;
 
             for (y=0; y<prc->Height; y++)
+            {
+                DWORD *pixel = (DWORD *)(pbBuffer + cbStride * y);
+
                 for (x=0; x<prc->Width; x++)
                 {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
+                    BYTE gray = linear_to_sRGB_byte(float_from_bits(pixel[x]));
+                    pixel[x] = 0xff000000 | gray << 16 | gray << 8 | gray;
                 }
+            }
         }
         return S_OK;
     case format_48bppRGB:
@@ -850,10 +987,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 for (x=0; x<prc->Width; x++)
                 {
                     BYTE *pixel = pbBuffer+cbStride*y+4*x;
-                    BYTE c=pixel[0], m=pixel[1], y=pixel[2], k=pixel[3];
-                    pixel[0] = (255-y)*(255-k)/255; /* blue */
-                    pixel[1] = (255-m)*(255-k)/255; /* green */
-                    pixel[2] = (255-c)*(255-k)/255; /* red */
+                    const BYTE *table = premultiply_table[255-pixel[3]];
+                    BYTE c=pixel[0], m=pixel[1], y=pixel[2];
+                    pixel[0] = table[255-y]; /* blue */
+                    pixel[1] = table[255-m]; /* green */
+                    pixel[2] = table[255-c]; /* red */
                     pixel[3] = 255; /* alpha */
                 }
         }
@@ -893,22 +1031,10 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppPRGBA:
         if (prc)
         {
-            INT x, y;
-
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+            unpremultiply_pixels(pbBuffer, prc->Width, prc->Height, cbStride);
         }
         return S_OK;
 
@@ -966,21 +1092,7 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_pixels(pbBuffer, prc->Width, prc->Height, cbStride);
         return hr;
     }
 }
@@ -999,21 +1111,7 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_pixels(pbBuffer, prc->Width, prc->Height, cbStride);
         return hr;
     }
 }
@@ -1129,7 +1227,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
+                        BYTE gray = linear_to_sRGB_byte(gray_float[x]);
                         *bgr++ = gray;
                         *bgr++ = gray;
                         *bgr++ = gray;
@@ -1170,10 +1268,10 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE c = cmyk[0], m = cmyk[1], y = cmyk[2], k = cmyk[3];
-                        bgr[0] = (255 - y) * (255 - k) / 255; /* B */
-                        bgr[1] = (255 - m) * (255 - k) / 255; /* G */
-                        bgr[2] = (255 - c) * (255 - k) / 255; /* R */
+                        const BYTE *table = premultiply_table[255 - cmyk[3]];
+                        bgr[0] = table[255 - cmyk[2]]; /* B */
+                        bgr[1] = table[255 - cmyk[1]]; /* G */
+                        bgr[2] = table[255 - cmyk[0]]; /* R */
                         cmyk += 4;
                         bgr += 3;
                     }
@@ -1188,8 +1286,43 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
         return S_OK;
 
     default:
-        FIXME("Unimplemented conversion path!\n");
-        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+        if (!prc)
+            return copypixels_to_32bppBGRA(This, NULL, cbStride, cbBufferSize, pbBuffer, source_format);
+        else
+        {
+            BYTE *srcdata;
+            UINT srcstride, srcdatasize;
+
+            srcstride = 4 * prc->Width;
+            srcdatasize = srcstride * prc->Height;
+
+            srcdata = heap_alloc(srcdatasize);
+            if (!srcdata) return E_OUTOFMEMORY;
+
+            hr = copypixels_to_32bppBGRA(This, prc, srcstride, srcdatasize, srcdata, source_format);
+            if (SUCCEEDED(hr))
+            {
+                INT x, y;
+                BYTE *src = srcdata, *dst = pbBuffer;
+
+                for (y = 0; y < prc->Height; y++)
+                {
+                    for (x = 0; x < prc->Width; x++)
+                    {
+                        dst[3 * x] = src[4 * x];         /* B */
+                        dst[3 * x + 1] = src[4 * x + 1]; /* G */
+                        dst[3 * x + 2] = src[4 * x + 2]; /* R */
+                    }
+                    src += srcstride;
+                    dst += cbStride;
+                }
+            }
+            else if (hr == WINCODEC_ERR_UNSUPPORTEDOPERATION)
+                FIXME("Unimplemented conversion path!\n");
+
+            heap_free(srcdata);
+            return hr;
+        }
     }
 }
 
@@ -1261,8 +1394,10 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
         }
         return S_OK;
     default:
-        FIXME("Unimplemented conversion path!\n");
-        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+        hr = copypixels_to_24bppBGR(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
+        if (SUCCEEDED(hr) && prc)
+            reverse_bgr8(3, pbBuffer, prc->Width, prc->Height, cbStride);
+        return hr;
     }
 }
 
@@ -1348,7 +1483,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
                     BYTE *dstpixel = dst;
 
                     for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        *dstpixel++ = linear_to_sRGB_byte(*srcpixel++);
 
                     src += srcstride;
                     dst += cbStride;
@@ -1384,8 +1519,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
             {
                 float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
 
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
+                dst[x] = linear_to_sRGB_byte(gray);
                 bgr += 3;
             }
             src += srcstride;
@@ -1640,6 +1774,47 @@ static HRESULT WINAPI FormatConverter_CopyPalette(IWICFormatConverter *iface,
     return IWICPalette_InitializeFromPalette(palette, This->palette);
 }
 
+/***********************************************************************
+ *           convert_tiles
+ *
+ * Convert a rectangle in bands of rows, so that the source pixels and
+ * the intermediate buffers of the conversion stay in the cache.
+ */
+static HRESULT convert_tiles(FormatConverter *This, const WICRect *prc,
+    UINT stride, UINT buffersize, BYTE *buffer)
+{
+    copyfunc copy_function = This->dst_format->copy_function;
+    enum pixelformat source_format = This->src_format->format;
+    UINT bpp, rows, bytesperrow;
+    WICRect rc;
+    HRESULT hr;
+    INT y;
+
+    if (prc->Width <= 0 || prc->Height <= 0 ||
+        FAILED(get_pixelformat_bpp(This->dst_format->guid, &bpp)))
+        return copy_function(This, prc, stride, buffersize, buffer, source_format);
+
+    /* let the conversion function report invalid buffers */
+    bytesperrow = (bpp * prc->Width + 7) / 8;
+    if (stride < bytesperrow || stride * (prc->Height - 1) + bytesperrow > buffersize)
+        return copy_function(This, prc, stride, buffersize, buffer, source_format);
+
+    rows = max(1, CONVERTER_TILE_SIZE / (prc->Width * 4));
+    if (rows >= prc->Height)
+        return copy_function(This, prc, stride, buffersize, buffer, source_format);
+
+    rc = *prc;
+    for (y = 0; y < prc->Height; y += rows)
+    {
+        rc.Y = prc->Y + y;
+        rc.Height = min(rows, prc->Height - y);
+        hr = copy_function(This, &rc, stride, buffersize - stride * y, buffer + stride * y, source_format);
+        if (FAILED(hr)) return hr;
+    }
+
+    return S_OK;
+}
+
 static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -1662,8 +1837,7 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
-        return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
-            pbBuffer, This->src_format->format);
+        return convert_tiles(This, prc, cbStride, cbBufferSize, pbBuffer);
     }
     else
         return WINCODEC_ERR_WRONGSTATE;
@@ -1720,6 +1894,8 @@ static HRESULT WINAPI FormatConverter_Initialize(IWICFormatConverter *iface,
     else
         IWICPalette_AddRef(palette);
 
+    InitOnceExecuteOnce(&init_tables_once, init_conversion_tables, NULL, NULL);
+
     EnterCriticalSection(&This->lock);
 
     if (This->source)
@@ -68,6 +68,7 @@ static const WCHAR wszJpegYCrCbSubsampling[] = {'J','p','e','g','Y','C','r','C',
 static const WCHAR wszSuppressApp0[] = {'S','u','p','p','r','e','s','s','A','p','p','0',0};
 
 #define MAKE_FUNCPTR(f) static typeof(f) * p##f
+MAKE_FUNCPTR(jpeg_abort_decompress);
 MAKE_FUNCPTR(jpeg_CreateCompress);
 MAKE_FUNCPTR(jpeg_CreateDecompress);
 MAKE_FUNCPTR(jpeg_destroy_compress);
@@ -93,6 +94,7 @@ static void *load_libjpeg(void)
         return NULL; \
     }
 
+        LOAD_FUNCPTR(jpeg_abort_decompress);
         LOAD_FUNCPTR(jpeg_CreateCompress);
         LOAD_FUNCPTR(jpeg_CreateDecompress);
         LOAD_FUNCPTR(jpeg_destroy_compress);
@@ -147,16 +149,23 @@ typedef struct {
     IWICBitmapDecoder IWICBitmapDecoder_iface;
     IWICBitmapFrameDecode IWICBitmapFrameDecode_iface;
     IWICMetadataBlockReader IWICMetadataBlockReader_iface;
+    IWICBitmapSourceTransform IWICBitmapSourceTransform_iface;
     LONG ref;
     BOOL initialized;
     BOOL cinfo_initialized;
+    BOOL decompress_started;
+    BOOL need_header;
     IStream *stream;
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
     UINT bpp, stride;
-    BYTE *image_data;
+    UINT scale; /* DCT scaling denominator of the current decompression */
+    BYTE *rows; /* ring buffer holding the last decoded scanlines */
+    UINT rows_alloc; /* number of scanlines in the ring buffer */
+    UINT first_row; /* first scanline still held in the ring buffer */
+    BOOL keep_rows; /* rows were read backwards, keep as many as possible in the band */
     CRITICAL_SECTION lock;
 } JpegDecoder;
 
@@ -180,6 +189,11 @@ static inline JpegDecoder *impl_from_IWICMetadataBlockReader(IWICMetadataBlockRe
     return CONTAINING_RECORD(iface, JpegDecoder, IWICMetadataBlockReader_iface);
 }
 
+static inline JpegDecoder *impl_from_IWICBitmapSourceTransform(IWICBitmapSourceTransform *iface)
+{
+    return CONTAINING_RECORD(iface, JpegDecoder, IWICBitmapSourceTransform_iface);
+}
+
 static HRESULT WINAPI JpegDecoder_QueryInterface(IWICBitmapDecoder *iface, REFIID iid,
     void **ppv)
 {
@@ -226,7 +240,7 @@ static ULONG WINAPI JpegDecoder_Release(IWICBitmapDecoder *iface)
         DeleteCriticalSection(&This->lock);
         if (This->cinfo_initialized) pjpeg_destroy_decompress(&This->cinfo);
         if (This->stream) IStream_Release(This->stream);
-        HeapFree(GetProcessHeap(), 0, This->image_data);
+        heap_free(This->rows);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -297,6 +311,233 @@ static void source_mgr_term_source(j_decompress_ptr cinfo)
 {
 }
 
+/* the decoded scanlines are kept in a band so that tiles and overlapping
+ * requests don't restart the decompression */
+#define JPEG_BAND_ROWS 16
+#define JPEG_MAX_BAND_SIZE (16 * 1024 * 1024)
+
+static BOOL set_out_color_space(JpegDecoder *This)
+{
+    switch (This->cinfo.jpeg_color_space)
+    {
+    case JCS_GRAYSCALE:
+        This->cinfo.out_color_space = JCS_GRAYSCALE;
+        return TRUE;
+    case JCS_RGB:
+    case JCS_YCbCr:
+        This->cinfo.out_color_space = JCS_RGB;
+        return TRUE;
+    case JCS_CMYK:
+    case JCS_YCCK:
+        This->cinfo.out_color_space = JCS_CMYK;
+        return TRUE;
+    default:
+        ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
+        return FALSE;
+    }
+}
+
+static const WICPixelFormatGUID *get_pixel_format(JpegDecoder *This)
+{
+    if (This->cinfo.out_color_space == JCS_RGB)
+        return &GUID_WICPixelFormat24bppBGR;
+    else if (This->cinfo.out_color_space == JCS_CMYK)
+        return &GUID_WICPixelFormat32bppCMYK;
+    else /* This->cinfo.out_color_space == JCS_GRAYSCALE */
+        return &GUID_WICPixelFormat8bppGray;
+}
+
+/* size of the image once scaled down by the DCT, rounded up like libjpeg does */
+static inline UINT scaled_size(UINT size, UINT scale)
+{
+    return (size + scale - 1) / scale;
+}
+
+/* rectangle of the image scaled down by 1/scale covering a rectangle of the full size image */
+static void get_scaled_rect(const WICRect *rc, UINT scale, WICRect *scaled_rc)
+{
+    scaled_rc->X = rc->X / scale;
+    scaled_rc->Y = rc->Y / scale;
+    scaled_rc->Width = scaled_size(rc->X + rc->Width, scale) - scaled_rc->X;
+    scaled_rc->Height = scaled_size(rc->Y + rc->Height, scale) - scaled_rc->Y;
+}
+
+/* validate a CopyPixels request against an image of the given size */
+static HRESULT check_copy_rect(JpegDecoder *This, const WICRect *prc, UINT width, UINT height,
+    WICRect *rc, UINT stride, UINT buffersize)
+{
+    UINT bytesperrow;
+
+    if (!prc)
+    {
+        rc->X = 0;
+        rc->Y = 0;
+        rc->Width = width;
+        rc->Height = height;
+    }
+    else
+    {
+        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > width || prc->Y+prc->Height > height)
+            return E_INVALIDARG;
+        *rc = *prc;
+    }
+
+    bytesperrow = ((This->bpp * rc->Width)+7)/8;
+
+    if (stride < bytesperrow)
+        return E_INVALIDARG;
+
+    if ((stride * (rc->Height-1)) + bytesperrow > buffersize)
+        return E_INVALIDARG;
+
+    return S_OK;
+}
+
+/* make sure the ring buffer can hold the given number of scanlines */
+static HRESULT grow_band(JpegDecoder *This, UINT rows)
+{
+    UINT row, max_rows = max(JPEG_BAND_ROWS, JPEG_MAX_BAND_SIZE / This->stride);
+    BYTE *new_rows;
+
+    rows = min(max(rows, JPEG_BAND_ROWS), min(max_rows, This->cinfo.output_height));
+    if (rows <= This->rows_alloc) return S_OK;
+
+    if (!(new_rows = heap_alloc(rows * This->stride)))
+        return E_OUTOFMEMORY;
+    for (row = This->first_row; row < This->cinfo.output_scanline; row++)
+        memcpy(new_rows + (row % rows) * This->stride,
+               This->rows + (row % This->rows_alloc) * This->stride, This->stride);
+    heap_free(This->rows);
+    This->rows = new_rows;
+    This->rows_alloc = rows;
+    return S_OK;
+}
+
+/* decompress the next scanline into the ring buffer */
+static HRESULT decode_row(JpegDecoder *This)
+{
+    UINT row = This->cinfo.output_scanline, i;
+    JSAMPROW out_row = This->rows + (row % This->rows_alloc) * This->stride;
+
+    if (!pjpeg_read_scanlines(&This->cinfo, &out_row, 1))
+    {
+        ERR("read_scanlines failed\n");
+        return E_FAIL;
+    }
+    if (row - This->first_row >= This->rows_alloc) This->first_row++;
+
+    if (This->bpp == 24)
+    {
+        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
+        reverse_bgr8(3, out_row, This->cinfo.output_width, 1, This->stride);
+    }
+
+    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+    {
+        /* Adobe JPEG's have inverted CMYK data. */
+        for (i=0; i<This->stride; i++)
+            out_row[i] ^= 0xff;
+    }
+    return S_OK;
+}
+
+/***********************************************************************
+ *           decode_rect
+ *
+ * Decompress the scanlines covering a rectangle of the image scaled
+ * down by 1/scale. The last decoded scanlines are kept in a band, and
+ * the decompression is only restarted from the beginning of the stream
+ * when rows that are no longer in the band, or a different scale, are
+ * requested. The band grows to the whole image, up to JPEG_MAX_BAND_SIZE,
+ * after the first restart caused by reading rows backwards.
+ * Must be called with the decoder lock held.
+ */
+static HRESULT decode_rect(JpegDecoder *This, UINT scale, const WICRect *rc,
+    UINT stride, BYTE *buffer)
+{
+    UINT bytesperrow = (This->bpp * rc->Width) / 8;
+    UINT row_offset = (This->bpp * rc->X) / 8;
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    HRESULT hr;
+    UINT row;
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        pjpeg_abort_decompress(&This->cinfo);
+        This->decompress_started = FALSE;
+        This->need_header = TRUE;
+        return E_FAIL;
+    }
+
+    if (This->decompress_started &&
+        (This->scale != scale || This->first_row > rc->Y))
+    {
+        TRACE("restarting decompression for %s at scale 1/%u\n", debug_wic_rect(rc), scale);
+        /* the caller is likely reading the rows bottom-up, e.g. to flip the image,
+         * so avoid restarting again for each band */
+        if (This->scale == scale) This->keep_rows = TRUE;
+        pjpeg_abort_decompress(&This->cinfo);
+        This->decompress_started = FALSE;
+        This->need_header = TRUE;
+    }
+
+    if (This->need_header)
+    {
+        seek.QuadPart = 0;
+        IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+        This->source_mgr.bytes_in_buffer = 0;
+
+        if (pjpeg_read_header(&This->cinfo, TRUE) != JPEG_HEADER_OK || !set_out_color_space(This))
+            return E_FAIL;
+        This->need_header = FALSE;
+    }
+
+    if (!This->decompress_started)
+    {
+        This->cinfo.scale_num = 1;
+        This->cinfo.scale_denom = scale;
+
+        if (!pjpeg_start_decompress(&This->cinfo))
+        {
+            ERR("jpeg_start_decompress failed\n");
+            return E_FAIL;
+        }
+        This->decompress_started = TRUE;
+        This->scale = scale;
+
+        if (This->cinfo.output_width != scaled_size(This->cinfo.image_width, scale) ||
+            This->cinfo.output_height != scaled_size(This->cinfo.image_height, scale))
+        {
+            FIXME("libjpeg does not support scaling by 1/%u\n", scale);
+            return E_FAIL;
+        }
+
+        This->stride = (This->bpp * This->cinfo.output_width + 7) / 8;
+        This->first_row = 0;
+        heap_free(This->rows);
+        This->rows = NULL;
+        This->rows_alloc = 0;
+    }
+
+    if (FAILED(hr = grow_band(This, This->keep_rows ? This->cinfo.output_height : rc->Height)))
+        return hr;
+
+    for (row = rc->Y; row < rc->Y + rc->Height; row++)
+    {
+        /* rows above the rectangle are decoded into the band as well */
+        while (This->cinfo.output_scanline <= row)
+            if (FAILED(hr = decode_row(This))) return hr;
+
+        memcpy(buffer + stride * (row - rc->Y),
+               This->rows + (row % This->rows_alloc) * This->stride + row_offset, bytesperrow);
+    }
+
+    return S_OK;
+}
+
 static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
     WICDecodeOptions cacheOptions)
 {
@@ -304,7 +545,6 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
     int ret;
     LARGE_INTEGER seek;
     jmp_buf jmpbuf;
-    UINT data_size, i;
 
     TRACE("(%p,%p,%u)\n", iface, pIStream, cacheOptions);
 
@@ -358,28 +598,8 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
         return E_FAIL;
     }
 
-    switch (This->cinfo.jpeg_color_space)
-    {
-    case JCS_GRAYSCALE:
-        This->cinfo.out_color_space = JCS_GRAYSCALE;
-        break;
-    case JCS_RGB:
-    case JCS_YCbCr:
-        This->cinfo.out_color_space = JCS_RGB;
-        break;
-    case JCS_CMYK:
-    case JCS_YCCK:
-        This->cinfo.out_color_space = JCS_CMYK;
-        break;
-    default:
-        ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
-    }
-
-    if (!pjpeg_start_decompress(&This->cinfo))
+    if (!set_out_color_space(This))
     {
-        ERR("jpeg_start_decompress failed\n");
         LeaveCriticalSection(&This->lock);
         return E_FAIL;
     }
@@ -388,50 +608,9 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
     else if (This->cinfo.out_color_space == JCS_CMYK) This->bpp = 32;
     else This->bpp = 24;
 
-    This->stride = (This->bpp * This->cinfo.output_width + 7) / 8;
-    data_size = This->stride * This->cinfo.output_height;
-
-    This->image_data = heap_alloc(data_size);
-    if (!This->image_data)
-    {
-        LeaveCriticalSection(&This->lock);
-        return E_OUTOFMEMORY;
-    }
-
-    while (This->cinfo.output_scanline < This->cinfo.output_height)
-    {
-        UINT first_scanline = This->cinfo.output_scanline;
-        UINT max_rows;
-        JSAMPROW out_rows[4];
-        JDIMENSION ret;
-
-        max_rows = min(This->cinfo.output_height-first_scanline, 4);
-        for (i=0; i<max_rows; i++)
-            out_rows[i] = This->image_data + This->stride * (first_scanline+i);
-
-        ret = pjpeg_read_scanlines(&This->cinfo, out_rows, max_rows);
-        if (ret == 0)
-        {
-            ERR("read_scanlines failed\n");
-            LeaveCriticalSection(&This->lock);
-            return E_FAIL;
-        }
-    }
-
-    if (This->bpp == 24)
-    {
-        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
-        reverse_bgr8(3, This->image_data,
-            This->cinfo.output_width, This->cinfo.output_height,
-            This->stride);
-    }
-
-    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
-    {
-        /* Adobe JPEG's have inverted CMYK data. */
-        for (i=0; i<data_size; i++)
-            This->image_data[i] ^= 0xff;
-    }
+    /* the scanlines are only decompressed when the pixels are requested */
+    This->decompress_started = FALSE;
+    This->need_header = FALSE;
 
     This->initialized = TRUE;
 
@@ -552,6 +731,10 @@ static HRESULT WINAPI JpegDecoder_Frame_QueryInterface(IWICBitmapFrameDecode *if
     {
         *ppv = &This->IWICBitmapFrameDecode_iface;
     }
+    else if (IsEqualIID(&IID_IWICBitmapSourceTransform, iid))
+    {
+        *ppv = &This->IWICBitmapSourceTransform_iface;
+    }
     else
     {
         *ppv = NULL;
@@ -578,8 +761,8 @@ static HRESULT WINAPI JpegDecoder_Frame_GetSize(IWICBitmapFrameDecode *iface,
     UINT *puiWidth, UINT *puiHeight)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
-    *puiWidth = This->cinfo.output_width;
-    *puiHeight = This->cinfo.output_height;
+    *puiWidth = This->cinfo.image_width;
+    *puiHeight = This->cinfo.image_height;
     TRACE("(%p)->(%u,%u)\n", iface, *puiWidth, *puiHeight);
     return S_OK;
 }
@@ -589,12 +772,7 @@ static HRESULT WINAPI JpegDecoder_Frame_GetPixelFormat(IWICBitmapFrameDecode *if
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
     TRACE("(%p,%p)\n", iface, pPixelFormat);
-    if (This->cinfo.out_color_space == JCS_RGB)
-        memcpy(pPixelFormat, &GUID_WICPixelFormat24bppBGR, sizeof(GUID));
-    else if (This->cinfo.out_color_space == JCS_CMYK)
-        memcpy(pPixelFormat, &GUID_WICPixelFormat32bppCMYK, sizeof(GUID));
-    else /* This->cinfo.out_color_space == JCS_GRAYSCALE */
-        memcpy(pPixelFormat, &GUID_WICPixelFormat8bppGray, sizeof(GUID));
+    memcpy(pPixelFormat, get_pixel_format(This), sizeof(GUID));
     return S_OK;
 }
 
@@ -643,12 +821,20 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    WICRect rc;
+    HRESULT hr;
 
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_data,
-        This->cinfo.output_width, This->cinfo.output_height, This->stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    hr = check_copy_rect(This, prc, This->cinfo.image_width, This->cinfo.image_height,
+        &rc, cbStride, cbBufferSize);
+    if (FAILED(hr)) return hr;
+
+    EnterCriticalSection(&This->lock);
+    hr = decode_rect(This, 1, &rc, cbStride, pbBuffer);
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI JpegDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -759,6 +945,182 @@ static const IWICMetadataBlockReaderVtbl JpegDecoder_Block_Vtbl = {
     JpegDecoder_Block_GetEnumerator,
 };
 
+static HRESULT WINAPI JpegDecoder_Transform_QueryInterface(IWICBitmapSourceTransform *iface, REFIID iid,
+    void **ppv)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapFrameDecode_QueryInterface(&This->IWICBitmapFrameDecode_iface, iid, ppv);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_AddRef(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_AddRef(&This->IWICBitmapDecoder_iface);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_Release(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_Release(&This->IWICBitmapDecoder_iface);
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_CopyPixels(IWICBitmapSourceTransform *iface,
+    const WICRect *prc, UINT width, UINT height, WICPixelFormatGUID *format,
+    WICBitmapTransformOptions transform, UINT stride, UINT buffersize, BYTE *buffer)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    UINT scale, bitmap_stride, bitmap_size;
+    WICRect rc, scaled_rc;
+    IWICBitmapScaler *scaler;
+    IWICBitmapLock *lock;
+    IWICBitmap *bitmap;
+    BYTE *bitmap_data;
+    HRESULT hr;
+
+    TRACE("(%p,%s,%u,%u,%s,%u,%u,%u,%p)\n", iface, debug_wic_rect(prc), width, height,
+          debugstr_guid(format), transform, stride, buffersize, buffer);
+
+    if (!width || !height)
+        return E_INVALIDARG;
+
+    if (transform != WICBitmapTransformRotate0)
+        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+
+    if (format && !IsEqualGUID(format, get_pixel_format(This)))
+        return WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+
+    if (!prc)
+    {
+        rc.X = 0;
+        rc.Y = 0;
+        rc.Width = This->cinfo.image_width;
+        rc.Height = This->cinfo.image_height;
+    }
+    else
+    {
+        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->cinfo.image_width ||
+            prc->Y+prc->Height > This->cinfo.image_height)
+            return E_INVALIDARG;
+        rc = *prc;
+    }
+
+    /* the DCT can only scale down by 1/2, 1/4 or 1/8, decode at the smallest
+     * scale that is not smaller than the requested size and resample the rest */
+    for (scale = 8; scale > 1; scale /= 2)
+    {
+        get_scaled_rect(&rc, scale, &scaled_rc);
+        if (scaled_rc.Width >= width && scaled_rc.Height >= height) break;
+    }
+    get_scaled_rect(&rc, scale, &scaled_rc);
+
+    if (scaled_rc.Width == width && scaled_rc.Height == height)
+    {
+        hr = check_copy_rect(This, &scaled_rc, scaled_size(This->cinfo.image_width, scale),
+            scaled_size(This->cinfo.image_height, scale), &rc, stride, buffersize);
+        if (FAILED(hr)) return hr;
+
+        EnterCriticalSection(&This->lock);
+        hr = decode_rect(This, scale, &rc, stride, buffer);
+        LeaveCriticalSection(&This->lock);
+
+        return hr;
+    }
+
+    TRACE("decoding %s at scale 1/%u and resampling to %ux%u\n", debug_wic_rect(&rc), scale, width, height);
+
+    hr = check_copy_rect(This, NULL, width, height, &rc, stride, buffersize);
+    if (FAILED(hr)) return hr;
+
+    hr = BitmapImpl_Create(scaled_rc.Width, scaled_rc.Height, 0, 0, NULL, 0, get_pixel_format(This),
+        WICBitmapCacheOnLoad, &bitmap);
+    if (FAILED(hr)) return hr;
+
+    hr = IWICBitmap_Lock(bitmap, NULL, WICBitmapLockWrite, &lock);
+    if (SUCCEEDED(hr))
+    {
+        hr = IWICBitmapLock_GetStride(lock, &bitmap_stride);
+        if (SUCCEEDED(hr))
+            hr = IWICBitmapLock_GetDataPointer(lock, &bitmap_size, &bitmap_data);
+        if (SUCCEEDED(hr))
+        {
+            EnterCriticalSection(&This->lock);
+            hr = decode_rect(This, scale, &scaled_rc, bitmap_stride, bitmap_data);
+            LeaveCriticalSection(&This->lock);
+        }
+        IWICBitmapLock_Release(lock);
+    }
+
+    if (SUCCEEDED(hr))
+        hr = BitmapScaler_Create(&scaler);
+    if (SUCCEEDED(hr))
+    {
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, width, height,
+            WICBitmapInterpolationModeFant);
+        if (SUCCEEDED(hr))
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, stride, buffersize, buffer);
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+    return hr;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestSize(IWICBitmapSourceTransform *iface,
+    UINT *width, UINT *height)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    UINT scale;
+
+    TRACE("(%p,%p,%p)\n", iface, width, height);
+
+    if (!width || !height) return E_INVALIDARG;
+
+    /* pick the smallest DCT scaled size which is not smaller than the requested one */
+    for (scale = 8; scale > 1; scale /= 2)
+        if (scaled_size(This->cinfo.image_width, scale) >= *width &&
+            scaled_size(This->cinfo.image_height, scale) >= *height) break;
+
+    *width = scaled_size(This->cinfo.image_width, scale);
+    *height = scaled_size(This->cinfo.image_height, scale);
+
+    TRACE("-> %ux%u\n", *width, *height);
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestPixelFormat(IWICBitmapSourceTransform *iface,
+    WICPixelFormatGUID *format)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+
+    TRACE("(%p,%p)\n", iface, format);
+
+    if (!format) return E_INVALIDARG;
+
+    memcpy(format, get_pixel_format(This), sizeof(GUID));
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_DoesSupportTransform(IWICBitmapSourceTransform *iface,
+    WICBitmapTransformOptions transform, BOOL *supported)
+{
+    TRACE("(%p,%u,%p)\n", iface, transform, supported);
+
+    if (!supported) return E_INVALIDARG;
+
+    *supported = transform == WICBitmapTransformRotate0;
+    return S_OK;
+}
+
+static const IWICBitmapSourceTransformVtbl JpegDecoder_Transform_Vtbl = {
+    JpegDecoder_Transform_QueryInterface,
+    JpegDecoder_Transform_AddRef,
+    JpegDecoder_Transform_Release,
+    JpegDecoder_Transform_CopyPixels,
+    JpegDecoder_Transform_GetClosestSize,
+    JpegDecoder_Transform_GetClosestPixelFormat,
+    JpegDecoder_Transform_DoesSupportTransform
+};
+
 HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
 {
     JpegDecoder *This;
@@ -780,11 +1142,15 @@ HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
     This->IWICBitmapDecoder_iface.lpVtbl = &JpegDecoder_Vtbl;
     This->IWICBitmapFrameDecode_iface.lpVtbl = &JpegDecoder_Frame_Vtbl;
     This->IWICMetadataBlockReader_iface.lpVtbl = &JpegDecoder_Block_Vtbl;
+    This->IWICBitmapSourceTransform_iface.lpVtbl = &JpegDecoder_Transform_Vtbl;
     This->ref = 1;
     This->initialized = FALSE;
     This->cinfo_initialized = FALSE;
+    This->decompress_started = FALSE;
+    This->need_header = FALSE;
     This->stream = NULL;
-    This->image_data = NULL;
+    This->rows = NULL;
+    This->rows_alloc = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": JpegDecoder.lock");
 
@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -33,6 +34,16 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+#define FILTER_WEIGHT_BITS 14
+
+/* source pixels contributing to a destination pixel, for one dimension */
+struct filter_contrib
+{
+    UINT start;   /* first source pixel */
+    UINT count;   /* number of source pixels */
+    UINT offset;  /* offset of the weights in the weights array */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -44,6 +55,9 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    struct filter_contrib *x_contribs, *y_contribs;
+    INT *x_weights, *y_weights;
+    INT *row_buffer; /* vertically filtered source row */
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -108,6 +122,11 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        HeapFree(GetProcessHeap(), 0, This->x_contribs);
+        HeapFree(GetProcessHeap(), 0, This->y_contribs);
+        HeapFree(GetProcessHeap(), 0, This->x_weights);
+        HeapFree(GetProcessHeap(), 0, This->y_weights);
+        HeapFree(GetProcessHeap(), 0, This->row_buffer);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -205,6 +224,273 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+/* Catmull-Rom spline */
+static double filter_cubic(double x)
+{
+    x = fabs(x);
+    if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+static double filter_linear(double x)
+{
+    x = fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+/* compute the weight of each source pixel for every destination pixel along one dimension */
+static HRESULT compute_filter_contribs(WICBitmapInterpolationMode mode, UINT src_size, UINT dst_size,
+    struct filter_contrib **ret_contribs, INT **ret_weights)
+{
+    double scale = (double)src_size / dst_size, filter_scale, radius;
+    double (*filter)(double) = NULL;
+    struct filter_contrib *contribs;
+    double *values;
+    INT *weights;
+    UINT i, j, max_count, offset = 0;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        filter = filter_linear;
+        radius = 1.0;
+        filter_scale = 1.0;
+        break;
+    case WICBitmapInterpolationModeCubic:
+        filter = filter_cubic;
+        radius = 2.0;
+        filter_scale = 1.0;
+        break;
+    case WICBitmapInterpolationModeHighQualityCubic:
+        /* stretch the filter when downscaling to avoid aliasing */
+        filter = filter_cubic;
+        filter_scale = max(scale, 1.0);
+        radius = 2.0 * filter_scale;
+        break;
+    default: /* Fant, box filter weighted by the covered area */
+        filter_scale = 1.0;
+        radius = max(scale, 1.0);
+        break;
+    }
+
+    max_count = (UINT)ceil(2.0 * radius) + 2;
+    contribs = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(*contribs));
+    weights = HeapAlloc(GetProcessHeap(), 0, dst_size * max_count * sizeof(*weights));
+    values = HeapAlloc(GetProcessHeap(), 0, max_count * sizeof(*values));
+    if (!contribs || !weights || !values)
+    {
+        HeapFree(GetProcessHeap(), 0, contribs);
+        HeapFree(GetProcessHeap(), 0, weights);
+        HeapFree(GetProcessHeap(), 0, values);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < dst_size; i++)
+    {
+        double center = (i + 0.5) * scale - 0.5, total = 0.0;
+        INT first = (INT)floor(center - radius) + 1, last = (INT)ceil(center + radius) - 1;
+        INT start, end, sum = 0, largest = 0, src;
+
+        if (!filter)
+        {
+            first = (INT)floor(i * scale);
+            last = (INT)ceil((i + 1) * scale) - 1;
+        }
+        start = max(first, 0);
+        end = min(last, (INT)src_size - 1);
+        if (end < start) start = end = min(max(first, 0), (INT)src_size - 1);
+
+        for (src = start; src <= end; src++) values[src - start] = 0.0;
+        for (src = first; src <= last; src++)
+        {
+            double value;
+
+            if (filter)
+                value = filter((src - center) / filter_scale);
+            else
+                value = min(src + 1, (i + 1) * scale) - max(src, i * scale);
+            /* pixels outside of the source repeat the edge */
+            values[min(max(src, start), end) - start] += value;
+            total += value;
+        }
+
+        contribs[i].start = start;
+        contribs[i].count = end - start + 1;
+        contribs[i].offset = offset;
+        for (j = 0; j < contribs[i].count; j++)
+        {
+            INT weight = total != 0.0 ? floor(values[j] / total * (1 << FILTER_WEIGHT_BITS) + 0.5) : 0;
+            weights[offset + j] = weight;
+            sum += weight;
+            if (weight > weights[offset + largest]) largest = j;
+        }
+        /* make sure that the weights add up exactly to one */
+        weights[offset + largest] += (1 << FILTER_WEIGHT_BITS) - sum;
+        offset += contribs[i].count;
+    }
+
+    HeapFree(GetProcessHeap(), 0, values);
+    *ret_contribs = contribs;
+    *ret_weights = weights;
+    return S_OK;
+}
+
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = This->x_contribs[x].start;
+    src_rect->Y = This->y_contribs[y].start;
+    src_rect->Width = This->x_contribs[x].count;
+    src_rect->Height = This->y_contribs[y].count;
+}
+
+static inline BYTE clamp_filtered(INT value)
+{
+    value = (value + (1 << (FILTER_WEIGHT_BITS - 1))) >> FILTER_WEIGHT_BITS;
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+/* separable filter on 8-bit channels: a vertical pass over the needed source columns
+ * into the row buffer, followed by a horizontal pass for each destination pixel */
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    const struct filter_contrib *y_contrib = &This->y_contribs[dst_y];
+    const INT *y_weights = This->y_weights + y_contrib->offset;
+    UINT channels = This->bpp / 8;
+    UINT first = This->x_contribs[dst_x].start;
+    UINT last = This->x_contribs[dst_x + dst_width - 1].start + This->x_contribs[dst_x + dst_width - 1].count;
+    UINT row_size = (last - first) * channels;
+    INT *row = This->row_buffer;
+    UINT i, j, c;
+
+    memset(row, 0, row_size * sizeof(*row));
+    for (j = 0; j < y_contrib->count; j++)
+    {
+        const BYTE *src = src_data[y_contrib->start + j - src_data_y] + (first - src_data_x) * channels;
+        INT weight = y_weights[j];
+
+        for (i = 0; i < row_size; i++) row[i] += src[i] * weight;
+    }
+    for (i = 0; i < row_size; i++)
+        row[i] = (row[i] + (1 << (FILTER_WEIGHT_BITS - 1))) >> FILTER_WEIGHT_BITS;
+
+    for (i = 0; i < dst_width; i++)
+    {
+        const struct filter_contrib *x_contrib = &This->x_contribs[dst_x + i];
+        const INT *x_weights = This->x_weights + x_contrib->offset;
+        const INT *src = row + (x_contrib->start - first) * channels;
+
+        for (c = 0; c < channels; c++)
+        {
+            INT sum = 0;
+
+            for (j = 0; j < x_contrib->count; j++) sum += src[j * channels + c] * x_weights[j];
+            pbBuffer[i * channels + c] = clamp_filtered(sum);
+        }
+    }
+}
+
+/* same as Filter_CopyScanline for 32bpp formats with straight alpha in the last channel:
+ * the colors are filtered premultiplied by alpha, so that transparent pixels don't bleed
+ * into their neighbours, and the alpha channel is scaled by 255 to get the same range */
+static void FilterAlpha_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    const struct filter_contrib *y_contrib = &This->y_contribs[dst_y];
+    const INT *y_weights = This->y_weights + y_contrib->offset;
+    UINT first = This->x_contribs[dst_x].start;
+    UINT last = This->x_contribs[dst_x + dst_width - 1].start + This->x_contribs[dst_x + dst_width - 1].count;
+    UINT row_size = (last - first) * 4;
+    INT *row = This->row_buffer;
+    UINT i, j, c;
+
+    memset(row, 0, row_size * sizeof(*row));
+    for (j = 0; j < y_contrib->count; j++)
+    {
+        const BYTE *src = src_data[y_contrib->start + j - src_data_y] + (first - src_data_x) * 4;
+        INT weight = y_weights[j];
+
+        for (i = 0; i < row_size; i += 4)
+        {
+            INT alpha = src[i + 3] * weight;
+
+            row[i] += src[i] * alpha;
+            row[i + 1] += src[i + 1] * alpha;
+            row[i + 2] += src[i + 2] * alpha;
+            row[i + 3] += 255 * alpha;
+        }
+    }
+    for (i = 0; i < row_size; i++)
+        row[i] = (row[i] + (1 << (FILTER_WEIGHT_BITS - 1))) >> FILTER_WEIGHT_BITS;
+
+    for (i = 0; i < dst_width; i++)
+    {
+        const struct filter_contrib *x_contrib = &This->x_contribs[dst_x + i];
+        const INT *x_weights = This->x_weights + x_contrib->offset;
+        const INT *src = row + (x_contrib->start - first) * 4;
+        BYTE *dst = pbBuffer + i * 4;
+        INT sum[4] = { 0 };
+
+        for (j = 0; j < x_contrib->count; j++)
+            for (c = 0; c < 4; c++) sum[c] += src[j * 4 + c] * x_weights[j];
+        for (c = 0; c < 4; c++)
+            sum[c] = (sum[c] + (1 << (FILTER_WEIGHT_BITS - 1))) >> FILTER_WEIGHT_BITS;
+
+        if (sum[3] <= 0)
+        {
+            dst[0] = dst[1] = dst[2] = dst[3] = 0;
+            continue;
+        }
+        /* unpremultiply the colors */
+        for (c = 0; c < 3; c++)
+        {
+            INT value = sum[c] <= 0 ? 0 : (sum[c] * 255 + sum[3] / 2) / sum[3];
+            dst[c] = min(value, 255);
+        }
+        dst[3] = min((sum[3] + 127) / 255, 255);
+    }
+}
+
+/* formats made of 8-bit channels that can be filtered independently */
+static BOOL is_filterable_format(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
+static HRESULT init_filter(BitmapScaler *This)
+{
+    HRESULT hr;
+
+    hr = compute_filter_contribs(This->mode, This->src_width, This->width,
+        &This->x_contribs, &This->x_weights);
+    if (SUCCEEDED(hr))
+        hr = compute_filter_contribs(This->mode, This->src_height, This->height,
+            &This->y_contribs, &This->y_weights);
+    if (SUCCEEDED(hr) &&
+        !(This->row_buffer = HeapAlloc(GetProcessHeap(), 0, This->src_width * (This->bpp / 8) * sizeof(INT))))
+        hr = E_OUTOFMEMORY;
+    return hr;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -353,8 +639,29 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            if (is_filterable_format(&src_pixelformat))
+            {
+                hr = init_filter(This);
+                if (SUCCEEDED(hr))
+                {
+                    IWICBitmapSource_AddRef(pISource);
+                    This->source = pISource;
+                    This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+                    if (IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppBGRA) ||
+                        IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppRGBA))
+                        This->fn_copy_scanline = FilterAlpha_CopyScanline;
+                    else
+                        This->fn_copy_scanline = Filter_CopyScanline;
+                }
+                break;
+            }
+            /* fall-through */
         default:
-            FIXME("unsupported mode %i\n", mode);
+            FIXME("unsupported mode %i for format %s\n", mode, debugstr_guid(&src_pixelformat));
             /* fall-through */
         case WICBitmapInterpolationModeNearestNeighbor:
             if ((This->bpp % 8) == 0)
@@ -529,6 +836,9 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->x_contribs = This->y_contribs = NULL;
+    This->x_weights = This->y_weights = NULL;
+    This->row_buffer = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -1312,6 +1312,90 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_modes(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const BYTE gray2x1[2] = { 0x00, 0xfe };
+    /* transparent red and opaque blue */
+    static const BYTE bgra2x1[8] = { 0x00, 0x00, 0xff, 0x00, 0xff, 0x00, 0x00, 0xff };
+    BYTE data[8 * 8 * 4], buf[3 * 3 * 4];
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    HRESULT hr;
+    UINT i, j;
+
+    for (i = 0; i < sizeof(data); i += 4)
+    {
+        data[i] = 0x20;
+        data[i + 1] = 0x80;
+        data[i + 2] = 0xc0;
+        data[i + 3] = 0xff;
+    }
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 8, 8, &GUID_WICPixelFormat32bppBGRA,
+                                                   8 * 4, sizeof(data), data, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    /* scaling a uniform image gives the same color, whatever the filter */
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 3, 3, modes[i]);
+        ok(hr == S_OK, "%u: failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+        memset(buf, 0, sizeof(buf));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 3 * 4, sizeof(buf), buf);
+        ok(hr == S_OK, "%u: failed to copy pixels, hr %#x.\n", modes[i], hr);
+        for (j = 0; j < sizeof(buf); j++)
+            if (buf[j] != data[j % 4]) break;
+        ok(j == sizeof(buf), "%u: unexpected value %#x at %u.\n", modes[i], buf[j % sizeof(buf)], j);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+    IWICBitmap_Release(bitmap);
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 2, 1, &GUID_WICPixelFormat8bppGray,
+                                                   2, sizeof(gray2x1), (BYTE *)gray2x1, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 1, 1, WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+    buf[0] = 0;
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 4, 4, buf);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+    ok(buf[0] == 0x7f, "Unexpected value %#x.\n", buf[0]);
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+
+    /* the color of transparent pixels doesn't contribute */
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 2, 1, &GUID_WICPixelFormat32bppBGRA,
+                                                   8, sizeof(bgra2x1), (BYTE *)bgra2x1, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 1, 1, WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+    memset(buf, 0, 4);
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 4, 4, buf);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+    ok(buf[0] == 0xff && buf[1] == 0x00 && buf[2] == 0x00 && (buf[3] == 0x80 || buf[3] == 0x7f),
+       "Unexpected pixel %02x%02x%02x%02x.\n", buf[3], buf[2], buf[1], buf[0]);
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1482,6 +1566,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
 
     IWICImagingFactory_Release(factory);
 
@@ -1853,6 +1853,174 @@ static void test_converter_8bppIndexed(void)
     DeleteTestBitmap(src_obj);
 }
 
+static void check_converted_pixels(const WICPixelFormatGUID *src_format, const void *src,
+    const WICPixelFormatGUID *dst_format, UINT dst_bpp, const BYTE *expect, const char *name)
+{
+    const UINT width = 4, dst_size = width * dst_bpp / 8;
+    IWICFormatConverter *converter;
+    IWICBitmap *bitmap;
+    BYTE dst[16];
+    WICRect rc;
+    HRESULT hr;
+    UINT x;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, width, 1, src_format, width * 4, width * 4,
+        (BYTE *)src, &bitmap);
+    ok(hr == S_OK, "%s: CreateBitmapFromMemory error %#x\n", name, hr);
+    hr = IWICImagingFactory_CreateFormatConverter(factory, &converter);
+    ok(hr == S_OK, "%s: CreateFormatConverter error %#x\n", name, hr);
+    hr = IWICFormatConverter_Initialize(converter, (IWICBitmapSource *)bitmap, dst_format,
+        WICBitmapDitherTypeNone, NULL, 0.0, WICBitmapPaletteTypeCustom);
+    ok(hr == S_OK, "%s: Initialize error %#x\n", name, hr);
+
+    memset(dst, 0xcc, sizeof(dst));
+    hr = IWICFormatConverter_CopyPixels(converter, NULL, dst_size, dst_size, dst);
+    ok(hr == S_OK, "%s: CopyPixels error %#x\n", name, hr);
+    ok(!memcmp(dst, expect, dst_size), "%s: got wrong pixels\n", name);
+
+    /* one pixel at a time */
+    memset(dst, 0xcc, sizeof(dst));
+    rc.Y = 0;
+    rc.Width = 1;
+    rc.Height = 1;
+    for (x = 0; x < width; x++)
+    {
+        rc.X = x;
+        hr = IWICFormatConverter_CopyPixels(converter, &rc, dst_bpp / 8, dst_bpp / 8, dst + x * dst_bpp / 8);
+        ok(hr == S_OK, "%s: CopyPixels error %#x for pixel %u\n", name, hr, x);
+    }
+    ok(!memcmp(dst, expect, dst_size), "%s: got wrong pixels one at a time\n", name);
+
+    IWICFormatConverter_Release(converter);
+    IWICBitmap_Release(bitmap);
+}
+
+static void test_converter_pixels(void)
+{
+    static const BYTE src_rgb[] =
+        { 0x10,0x20,0x30,0x00, 0x40,0x50,0x60,0x7f, 0xff,0x00,0x80,0x12, 0x01,0x02,0x03,0xff };
+    /* premultiplied by 0x55, so that unpremultiplying is exact */
+    static const BYTE src_prgba[] =
+        { 0x11,0x22,0x33,0x55, 0x00,0x55,0x44,0x55, 0x10,0x20,0x30,0xff, 0x00,0x00,0x00,0xff };
+    static const float src_gray[] = { 0.0722f, 0.7152f, 0.2126f, 1.0f };
+    static const BYTE rgb_bgra[] =
+        { 0x30,0x20,0x10,0xff, 0x60,0x50,0x40,0xff, 0x80,0x00,0xff,0xff, 0x03,0x02,0x01,0xff };
+    static const BYTE rgba_bgra[] =
+        { 0x30,0x20,0x10,0x00, 0x60,0x50,0x40,0x7f, 0x80,0x00,0xff,0x12, 0x03,0x02,0x01,0xff };
+    static const BYTE prgba_bgra[] =
+        { 0x99,0x66,0x33,0x55, 0xcc,0xff,0x00,0x55, 0x30,0x20,0x10,0xff, 0x00,0x00,0x00,0xff };
+    static const BYTE gray_bgra[] =
+        { 76,76,76,0xff, 220,220,220,0xff, 127,127,127,0xff, 255,255,255,0xff };
+    static const BYTE rgb_bgr[] =
+        { 0x30,0x20,0x10, 0x60,0x50,0x40, 0x80,0x00,0xff, 0x03,0x02,0x01 };
+    static const BYTE prgba_bgr[] =
+        { 0x99,0x66,0x33, 0xcc,0xff,0x00, 0x30,0x20,0x10, 0x00,0x00,0x00 };
+
+    check_converted_pixels(&GUID_WICPixelFormat32bppRGB, src_rgb, &GUID_WICPixelFormat32bppBGRA, 32,
+        rgb_bgra, "32bppRGB -> 32bppBGRA");
+    check_converted_pixels(&GUID_WICPixelFormat32bppRGBA, src_rgb, &GUID_WICPixelFormat32bppBGRA, 32,
+        rgba_bgra, "32bppRGBA -> 32bppBGRA");
+    check_converted_pixels(&GUID_WICPixelFormat32bppPRGBA, src_prgba, &GUID_WICPixelFormat32bppBGRA, 32,
+        prgba_bgra, "32bppPRGBA -> 32bppBGRA");
+    check_converted_pixels(&GUID_WICPixelFormat32bppGrayFloat, src_gray, &GUID_WICPixelFormat32bppBGRA, 32,
+        gray_bgra, "32bppGrayFloat -> 32bppBGRA");
+
+    /* these go through a 32bppBGRA intermediate */
+    check_converted_pixels(&GUID_WICPixelFormat32bppRGB, src_rgb, &GUID_WICPixelFormat24bppBGR, 24,
+        rgb_bgr, "32bppRGB -> 24bppBGR");
+    check_converted_pixels(&GUID_WICPixelFormat32bppPRGBA, src_prgba, &GUID_WICPixelFormat24bppBGR, 24,
+        prgba_bgr, "32bppPRGBA -> 24bppBGR");
+}
+
+static void test_converter_tiles(void)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *format;
+        const char *name;
+        UINT bpp;
+    } formats[] =
+    {
+        { &GUID_WICPixelFormat8bppGray, "8bppGray", 8 },
+        { &GUID_WICPixelFormat24bppBGR, "24bppBGR", 24 },
+        { &GUID_WICPixelFormat24bppRGB, "24bppRGB", 24 },
+        { &GUID_WICPixelFormat32bppBGR, "32bppBGR", 32 },
+        { &GUID_WICPixelFormat32bppRGB, "32bppRGB", 32 },
+        { &GUID_WICPixelFormat32bppBGRA, "32bppBGRA", 32 },
+        { &GUID_WICPixelFormat32bppRGBA, "32bppRGBA", 32 },
+        { &GUID_WICPixelFormat32bppPBGRA, "32bppPBGRA", 32 },
+        { &GUID_WICPixelFormat32bppPRGBA, "32bppPRGBA", 32 },
+    };
+    const UINT width = 301, height = 257, src_stride = width * 4, dst_stride = width * 4 + 4;
+    IWICFormatConverter *converter;
+    IWICBitmap *bitmap;
+    BYTE *src, *dst, *row_dst;
+    UINT i, j, x, y;
+    WICRect rc;
+    HRESULT hr;
+
+    src = HeapAlloc(GetProcessHeap(), 0, src_stride * height);
+    dst = HeapAlloc(GetProcessHeap(), 0, dst_stride * height);
+    row_dst = HeapAlloc(GetProcessHeap(), 0, dst_stride * height);
+
+    /* premultiplied formats get colors above alpha too, the results only need to be consistent */
+    for (y = 0; y < height; y++)
+        for (x = 0; x < src_stride; x++)
+            src[y * src_stride + x] = (x * 7 + y * 13 + (x * y) / 5) & 0xff;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapFromMemory(factory, width, height, formats[i].format,
+            src_stride, src_stride * height, src, &bitmap);
+        if (FAILED(hr))
+        {
+            win_skip("%s bitmaps are not supported\n", formats[i].name);
+            continue;
+        }
+
+        for (j = 0; j < ARRAY_SIZE(formats); j++)
+        {
+            hr = IWICImagingFactory_CreateFormatConverter(factory, &converter);
+            ok(hr == S_OK, "CreateFormatConverter error %#x\n", hr);
+
+            hr = IWICFormatConverter_Initialize(converter, (IWICBitmapSource *)bitmap, formats[j].format,
+                WICBitmapDitherTypeNone, NULL, 0.0,
+                formats[j].bpp <= 8 ? WICBitmapPaletteTypeFixedGray256 : WICBitmapPaletteTypeCustom);
+            ok(hr == S_OK, "%s -> %s: Initialize error %#x\n", formats[i].name, formats[j].name, hr);
+            if (hr == S_OK)
+            {
+                memset(dst, 0xcc, dst_stride * height);
+                hr = IWICFormatConverter_CopyPixels(converter, NULL, dst_stride, dst_stride * height, dst);
+                ok(hr == S_OK, "%s -> %s: CopyPixels error %#x\n", formats[i].name, formats[j].name, hr);
+
+                /* converting the whole image at once must give the same result as one row at a time */
+                memset(row_dst, 0xcc, dst_stride * height);
+                rc.X = 0;
+                rc.Width = width;
+                rc.Height = 1;
+                for (y = 0; y < height; y++)
+                {
+                    rc.Y = y;
+                    hr = IWICFormatConverter_CopyPixels(converter, &rc, dst_stride, dst_stride, row_dst + y * dst_stride);
+                    ok(hr == S_OK, "%s -> %s: CopyPixels error %#x for row %u\n", formats[i].name, formats[j].name, hr, y);
+                }
+
+                for (y = 0; y < height; y++)
+                    if (memcmp(dst + y * dst_stride, row_dst + y * dst_stride, (width * formats[j].bpp + 7) / 8)) break;
+                ok(y == height, "%s -> %s: row %u differs\n", formats[i].name, formats[j].name, y);
+            }
+
+            IWICFormatConverter_Release(converter);
+        }
+
+        IWICBitmap_Release(bitmap);
+    }
+
+    HeapFree(GetProcessHeap(), 0, src);
+    HeapFree(GetProcessHeap(), 0, dst);
+    HeapFree(GetProcessHeap(), 0, row_dst);
+}
+
 START_TEST(converter)
 {
     HRESULT hr;
@@ -1908,6 +2076,8 @@ START_TEST(converter)
     test_invalid_conversion();
     test_default_converter();
     test_converter_8bppIndexed();
+    test_converter_pixels();
+    test_converter_tiles();
 
     test_encoder(&testdata_8bppIndexed, &CLSID_WICGifEncoder,
                  &testdata_8bppIndexed, &CLSID_WICGifDecoder, "GIF encoder 8bppIndexed");
@@ -154,12 +154,258 @@ static void test_decode_adobe_cmyk(void)
     IWICImagingFactory_Release(factory);
 }
 
+static void test_source_transform(void)
+{
+    IWICBitmapSourceTransform *transform;
+    IWICBitmapFrameDecode *framedecode;
+    IWICBitmapDecoder *decoder;
+    IStream *jpegstream;
+    HGLOBAL hjpegdata;
+    WICPixelFormatGUID format;
+    BYTE imagedata[5 * 4], row[4], scaled[3 * 4], upscaled[10 * 8];
+    UINT width, height, i;
+    BOOL supported;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICJpegDecoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapDecoder, (void**)&decoder);
+    ok(SUCCEEDED(hr), "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return;
+
+    hjpegdata = GlobalAlloc(GMEM_MOVEABLE, sizeof(jpeg_adobe_cmyk_1x5));
+    memcpy(GlobalLock(hjpegdata), jpeg_adobe_cmyk_1x5, sizeof(jpeg_adobe_cmyk_1x5));
+    GlobalUnlock(hjpegdata);
+
+    hr = CreateStreamOnHGlobal(hjpegdata, FALSE, &jpegstream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal failed, hr=%x\n", hr);
+
+    hr = IWICBitmapDecoder_Initialize(decoder, jpegstream, WICDecodeMetadataCacheOnLoad);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &framedecode);
+    ok(hr == S_OK, "GetFrame failed, hr=%x\n", hr);
+
+    hr = IWICBitmapFrameDecode_QueryInterface(framedecode, &IID_IWICBitmapSourceTransform, (void **)&transform);
+    ok(hr == S_OK || broken(hr == E_NOINTERFACE) /* xp/2003 */, "QueryInterface failed, hr=%x\n", hr);
+    if (FAILED(hr))
+    {
+        IWICBitmapFrameDecode_Release(framedecode);
+        goto done;
+    }
+
+    hr = IWICBitmapFrameDecode_GetPixelFormat(framedecode, &format);
+    ok(hr == S_OK, "GetPixelFormat failed, hr=%x\n", hr);
+
+    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, NULL, 4, sizeof(imagedata), imagedata);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+
+    supported = FALSE;
+    hr = IWICBitmapSourceTransform_DoesSupportTransform(transform, WICBitmapTransformRotate0, &supported);
+    ok(hr == S_OK, "DoesSupportTransform failed, hr=%x\n", hr);
+    ok(supported, "expected Rotate0 to be supported\n");
+
+    hr = IWICBitmapSourceTransform_GetClosestPixelFormat(transform, &format);
+    ok(hr == S_OK, "GetClosestPixelFormat failed, hr=%x\n", hr);
+
+    width = height = 1;
+    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &width, &height);
+    ok(hr == S_OK, "GetClosestSize failed, hr=%x\n", hr);
+    ok(width == 1 && height == 1, "got %ux%u\n", width, height);
+
+    width = height = 100;
+    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &width, &height);
+    ok(hr == S_OK, "GetClosestSize failed, hr=%x\n", hr);
+    ok(width == 1 && height == 5, "got %ux%u\n", width, height);
+
+    memset(row, 0xcc, sizeof(row));
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 1, &format,
+        WICBitmapTransformRotate0, 4, sizeof(row), row);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    for (i = 0; i < 4; i++)
+        ok(row[i] + 2 >= imagedata[i] && row[i] <= imagedata[i] + 2, "byte %u: got %#x, expected %#x\n", i, row[i], imagedata[i]);
+
+    /* the full size image can be read back after a scaled one */
+    memset(imagedata + 8, 0xcc, 4);
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 5, NULL,
+        WICBitmapTransformRotate0, 4, sizeof(imagedata), imagedata);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    ok(!memcmp(imagedata + 8, imagedata, 4), "unexpected image data\n");
+
+    /* sizes that are not a DCT scaling of the image are resampled */
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 3, NULL,
+        WICBitmapTransformRotate0, 4, sizeof(scaled), scaled);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 2, 10, NULL,
+        WICBitmapTransformRotate0, 8, sizeof(upscaled), upscaled);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 3, NULL,
+        WICBitmapTransformRotate0, 4, sizeof(scaled) - 1, scaled);
+    ok(hr == E_INVALIDARG, "got hr=%x\n", hr);
+
+    IWICBitmapSourceTransform_Release(transform);
+    IWICBitmapFrameDecode_Release(framedecode);
+done:
+    IStream_Release(jpegstream);
+    GlobalFree(hjpegdata);
+    IWICBitmapDecoder_Release(decoder);
+}
+
+#define GRADIENT_WIDTH 8
+#define GRADIENT_HEIGHT 64
+
+static HGLOBAL encode_gradient(void)
+{
+    BYTE pixels[GRADIENT_WIDTH * GRADIENT_HEIGHT];
+    WICPixelFormatGUID format = GUID_WICPixelFormat8bppGray;
+    IWICBitmapFrameEncode *frameencode;
+    IPropertyBag2 *options;
+    IWICBitmapEncoder *encoder;
+    IStream *stream;
+    HGLOBAL hglobal;
+    HRESULT hr;
+    UINT x, y;
+
+    for (y = 0; y < GRADIENT_HEIGHT; y++)
+        for (x = 0; x < GRADIENT_WIDTH; x++)
+            pixels[y * GRADIENT_WIDTH + x] = y * 4;
+
+    hr = CoCreateInstance(&CLSID_WICJpegEncoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapEncoder, (void **)&encoder);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return NULL;
+
+    hglobal = GlobalAlloc(GMEM_MOVEABLE, 0);
+    hr = CreateStreamOnHGlobal(hglobal, FALSE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal failed, hr=%x\n", hr);
+
+    hr = IWICBitmapEncoder_Initialize(encoder, stream, WICBitmapEncoderNoCache);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+    hr = IWICBitmapEncoder_CreateNewFrame(encoder, &frameencode, &options);
+    ok(hr == S_OK, "CreateNewFrame failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_Initialize(frameencode, options);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_SetSize(frameencode, GRADIENT_WIDTH, GRADIENT_HEIGHT);
+    ok(hr == S_OK, "SetSize failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_SetPixelFormat(frameencode, &format);
+    ok(hr == S_OK, "SetPixelFormat failed, hr=%x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat8bppGray), "unexpected pixel format %s\n", wine_dbgstr_guid(&format));
+    hr = IWICBitmapFrameEncode_WritePixels(frameencode, GRADIENT_HEIGHT, GRADIENT_WIDTH, sizeof(pixels), pixels);
+    ok(hr == S_OK, "WritePixels failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_Commit(frameencode);
+    ok(hr == S_OK, "Commit failed, hr=%x\n", hr);
+    hr = IWICBitmapEncoder_Commit(encoder);
+    ok(hr == S_OK, "Commit failed, hr=%x\n", hr);
+
+    IPropertyBag2_Release(options);
+    IWICBitmapFrameEncode_Release(frameencode);
+    IWICBitmapEncoder_Release(encoder);
+    IStream_Release(stream);
+    return hglobal;
+}
+
+static IWICBitmapFrameDecode *decode_gradient(HGLOBAL hglobal)
+{
+    IWICBitmapFrameDecode *framedecode = NULL;
+    IWICBitmapDecoder *decoder;
+    IStream *stream;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICJpegDecoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapDecoder, (void **)&decoder);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return NULL;
+
+    hr = CreateStreamOnHGlobal(hglobal, FALSE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal failed, hr=%x\n", hr);
+    hr = IWICBitmapDecoder_Initialize(decoder, stream, WICDecodeMetadataCacheOnLoad);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &framedecode);
+    ok(hr == S_OK, "GetFrame failed, hr=%x\n", hr);
+
+    IStream_Release(stream);
+    IWICBitmapDecoder_Release(decoder);
+    return framedecode;
+}
+
+static void test_decode_rows_backwards(void)
+{
+    BYTE reference[GRADIENT_WIDTH * GRADIENT_HEIGHT], data[GRADIENT_WIDTH * GRADIENT_HEIGHT];
+    IWICBitmapFrameDecode *framedecode;
+    IWICBitmapFlipRotator *fliprotator;
+    IWICImagingFactory *factory;
+    WICPixelFormatGUID format;
+    HGLOBAL hglobal;
+    WICRect rc;
+    HRESULT hr;
+    UINT y;
+
+    if (!(hglobal = encode_gradient())) return;
+
+    if (!(framedecode = decode_gradient(hglobal))) goto done;
+    hr = IWICBitmapFrameDecode_GetPixelFormat(framedecode, &format);
+    ok(hr == S_OK, "GetPixelFormat failed, hr=%x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat8bppGray), "unexpected pixel format %s\n", wine_dbgstr_guid(&format));
+    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, NULL, GRADIENT_WIDTH, sizeof(reference), reference);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    IWICBitmapFrameDecode_Release(framedecode);
+    ok(reference[0] + 128 < reference[(GRADIENT_HEIGHT - 1) * GRADIENT_WIDTH], "rows do not differ: %#x, %#x\n",
+       reference[0], reference[(GRADIENT_HEIGHT - 1) * GRADIENT_WIDTH]);
+
+    /* every row read bottom-up from a fresh decoder matches the image */
+    if (!(framedecode = decode_gradient(hglobal))) goto done;
+    for (y = GRADIENT_HEIGHT; y > 0; y--)
+    {
+        rc.X = 0;
+        rc.Y = y - 1;
+        rc.Width = GRADIENT_WIDTH;
+        rc.Height = 1;
+        memset(data, 0xcc, GRADIENT_WIDTH);
+        hr = IWICBitmapFrameDecode_CopyPixels(framedecode, &rc, GRADIENT_WIDTH, GRADIENT_WIDTH, data);
+        ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+        ok(!memcmp(data, reference + (y - 1) * GRADIENT_WIDTH, GRADIENT_WIDTH), "unexpected data for row %u\n", y - 1);
+    }
+
+    /* and rows in the middle can still be read after that */
+    rc.Y = GRADIENT_HEIGHT / 2;
+    memset(data, 0xcc, GRADIENT_WIDTH);
+    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, &rc, GRADIENT_WIDTH, GRADIENT_WIDTH, data);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    ok(!memcmp(data, reference + rc.Y * GRADIENT_WIDTH, GRADIENT_WIDTH), "unexpected data for row %u\n", rc.Y);
+    IWICBitmapFrameDecode_Release(framedecode);
+
+    /* the flip rotator reads the source rows backwards as well */
+    hr = CoCreateInstance(&CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICImagingFactory, (void **)&factory);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) goto done;
+
+    if (!(framedecode = decode_gradient(hglobal))) goto done_factory;
+    hr = IWICImagingFactory_CreateBitmapFlipRotator(factory, &fliprotator);
+    ok(hr == S_OK, "CreateBitmapFlipRotator failed, hr=%x\n", hr);
+    hr = IWICBitmapFlipRotator_Initialize(fliprotator, (IWICBitmapSource *)framedecode, WICBitmapTransformFlipVertical);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+    memset(data, 0xcc, sizeof(data));
+    hr = IWICBitmapFlipRotator_CopyPixels(fliprotator, NULL, GRADIENT_WIDTH, sizeof(data), data);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    for (y = 0; y < GRADIENT_HEIGHT; y++)
+        ok(!memcmp(data + y * GRADIENT_WIDTH, reference + (GRADIENT_HEIGHT - 1 - y) * GRADIENT_WIDTH, GRADIENT_WIDTH),
+           "unexpected data for flipped row %u\n", y);
+    IWICBitmapFlipRotator_Release(fliprotator);
+    IWICBitmapFrameDecode_Release(framedecode);
+
+done_factory:
+    IWICImagingFactory_Release(factory);
+done:
+    GlobalFree(hglobal);
+}
 
 START_TEST(jpegformat)
 {
     CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
 
     test_decode_adobe_cmyk();
+    test_source_transform();
+    test_decode_rows_backwards();
 
     CoUninitialize();
 }
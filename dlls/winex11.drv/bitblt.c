@@ -52,6 +52,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(bitblt);
+WINE_DECLARE_DEBUG_CHANNEL(fps);
 
 
 #define DST 0   /* Destination drawable */
@@ -1558,6 +1559,8 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+#define SURFACE_TILE_SHIFT 6  /* dirty areas are tracked in 64x64 tiles */
+
 struct x11drv_window_surface
 {
     struct window_surface header;
@@ -1571,6 +1574,16 @@ struct x11drv_window_surface
     COLORREF              color_key;
     HRGN                  region;
     void                 *bits;
+    BYTE                 *tiles;        /* dirty flag for each tile */
+    int                   tiles_x;      /* number of tiles per row */
+    int                   tiles_y;      /* number of tile rows */
+    BYTE                 *pending;      /* tiles copied to the image but not uploaded yet */
+    RECT                  pending_bounds;
+    struct list           present_entry; /* entry in the presenter queue */
+    CRITICAL_SECTION      present_crit; /* protects the image and the pending tiles */
+    ULONGLONG             upload_bytes; /* bytes uploaded since the last statistics */
+    UINT                  upload_count; /* flushes since the last statistics */
+    DWORD                 stats_ticks;  /* time of the last statistics */
 #ifdef HAVE_LIBXXSHM
     XShmSegmentInfo       shminfo;
 #endif
@@ -1578,6 +1591,20 @@ struct x11drv_window_surface
     BITMAPINFO            info;   /* variable size, must be last */
 };
 
+static struct list presenter_queue = LIST_INIT( presenter_queue );
+static struct list presenter_batch = LIST_INIT( presenter_batch );  /* surfaces of the current frame */
+static struct x11drv_window_surface *presenting;  /* surface being uploaded by the presenter thread */
+static HANDLE presenter_event;
+
+static CRITICAL_SECTION presenter_section;
+static CRITICAL_SECTION_DEBUG presenter_critsect_debug =
+{
+    0, 0, &presenter_section,
+    { &presenter_critsect_debug.ProcessLocksList, &presenter_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": presenter_section") }
+};
+static CRITICAL_SECTION presenter_section = { &presenter_critsect_debug, -1, 0, 0, 0, 0 };
+
 static struct x11drv_window_surface *get_x11_surface( struct window_surface *surface )
 {
     return (struct x11drv_window_surface *)surface;
@@ -1900,6 +1927,29 @@ static RECT *x11drv_surface_get_bounds( struct window_surface *window_surface )
     return &surface->bounds;
 }
 
+/***********************************************************************
+ *           x11drv_surface_add_bounds
+ *
+ * Add a changed area to the bounds, and mark the tiles it covers as dirty.
+ */
+static void x11drv_surface_add_bounds( struct window_surface *window_surface, const RECT *rect )
+{
+    struct x11drv_window_surface *surface = get_x11_surface( window_surface );
+    int x, y, width;
+    RECT rc;
+
+    add_bounds_rect( &surface->bounds, rect );
+
+    SetRect( &rc, 0, 0, surface->header.rect.right - surface->header.rect.left,
+             surface->header.rect.bottom - surface->header.rect.top );
+    if (!IntersectRect( &rc, &rc, rect )) return;
+
+    x = rc.left >> SURFACE_TILE_SHIFT;
+    width = ((rc.right - 1) >> SURFACE_TILE_SHIFT) - x + 1;
+    for (y = rc.top >> SURFACE_TILE_SHIFT; y <= (rc.bottom - 1) >> SURFACE_TILE_SHIFT; y++)
+        memset( surface->tiles + y * surface->tiles_x + x, 1, width );
+}
+
 /***********************************************************************
  *           x11drv_surface_set_region
  */
@@ -1931,71 +1981,325 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
     window_surface->funcs->unlock( window_surface );
 }
 
-/***********************************************************************
- *           x11drv_surface_flush
- */
-static void x11drv_surface_flush( struct window_surface *window_surface )
+/* copy the dirty tiles from the surface bits to the image, converting them if needed */
+static void copy_dirty_tiles( struct x11drv_window_surface *surface, const RECT *visrect )
 {
-    struct x11drv_window_surface *surface = get_x11_surface( window_surface );
-    unsigned char *src = surface->bits;
-    unsigned char *dst = (unsigned char *)surface->image->data;
-    struct bitblt_coords coords;
+    int map[256], *mapping = get_window_surface_mapping( surface->image->bits_per_pixel, map );
+    int width_bytes = surface->image->bytes_per_line, bpp = surface->image->bits_per_pixel;
+    unsigned char *src = surface->bits, *dst = (unsigned char *)surface->image->data;
+    int x, y, i, start, left, right, top, bottom;
 
-    window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (IntersectRect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    for (y = visrect->top >> SURFACE_TILE_SHIFT; y <= (visrect->bottom - 1) >> SURFACE_TILE_SHIFT; y++)
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
-               wine_dbgstr_rect( &surface->bounds ), surface->bits );
+        const BYTE *tiles = surface->tiles + y * surface->tiles_x;
 
-        if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
+        for (x = 0; x < surface->tiles_x; x++) if (tiles[x]) break;
+        if (x == surface->tiles_x) continue;
+        top = max( y << SURFACE_TILE_SHIFT, visrect->top );
+        bottom = min( (y + 1) << SURFACE_TILE_SHIFT, visrect->bottom );
 
-        if (src != dst)
+        if (src != dst && (surface->byteswap || mapping))
         {
-            int map[256], *mapping = get_window_surface_mapping( surface->image->bits_per_pixel, map );
-            int width_bytes = surface->image->bytes_per_line;
-
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
-            copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
+            /* copy_image_byteswap works on full rows */
+            copy_image_byteswap( &surface->info, src + top * width_bytes, dst + top * width_bytes,
+                                 width_bytes, width_bytes, bottom - top,
                                  surface->byteswap, mapping, ~0u, surface->alpha_bits );
+            continue;
         }
-        else if (surface->alpha_bits)
+
+        for ( ; x < surface->tiles_x; x++)
         {
-            int x, y, stride = surface->image->bytes_per_line / sizeof(ULONG);
-            ULONG *ptr = (ULONG *)dst + coords.visrect.top * stride;
+            if (!tiles[x]) continue;
+            for (start = x; x < surface->tiles_x && tiles[x]; x++) ;
+            left = max( start << SURFACE_TILE_SHIFT, visrect->left );
+            right = min( x << SURFACE_TILE_SHIFT, visrect->right );
+            if (left >= right) continue;
+
+            for (i = top; i < bottom; i++)
+            {
+                if (src != dst)
+                    memcpy( dst + i * width_bytes + left * bpp / 8, src + i * width_bytes + left * bpp / 8,
+                            (right - left) * bpp / 8 );
+                if (surface->alpha_bits)
+                {
+                    ULONG *ptr = (ULONG *)(dst + i * width_bytes);
+                    int j;
+
+                    for (j = left; j < right; j++) ptr[j] |= surface->alpha_bits;
+                }
+            }
+        }
+    }
+}
+
+/* build the list of rectangles covering the tiles set in a tile map, merging vertically
+ * adjacent runs; return 0 if there are too many of them to be worth uploading separately */
+static int get_dirty_rects( struct x11drv_window_surface *surface, const BYTE *map, const RECT *visrect,
+                            RECT *rects, int max_rects )
+{
+    int x, y, i, start, count = 0;
+    RECT rc;
+
+    for (y = visrect->top >> SURFACE_TILE_SHIFT; y <= (visrect->bottom - 1) >> SURFACE_TILE_SHIFT; y++)
+    {
+        const BYTE *tiles = map + y * surface->tiles_x;
+        int row = count;
 
-            for (y = coords.visrect.top; y < coords.visrect.bottom; y++, ptr += stride)
-                for (x = coords.visrect.left; x < coords.visrect.right; x++)
-                    ptr[x] |= surface->alpha_bits;
+        for (x = 0; x < surface->tiles_x; x++)
+        {
+            if (!tiles[x]) continue;
+            for (start = x; x < surface->tiles_x && tiles[x]; x++) ;
+            SetRect( &rc, start << SURFACE_TILE_SHIFT, y << SURFACE_TILE_SHIFT,
+                     x << SURFACE_TILE_SHIFT, (y + 1) << SURFACE_TILE_SHIFT );
+            if (!IntersectRect( &rc, &rc, visrect )) continue;
+
+            /* extend a rectangle ending on the previous row if it has the same width */
+            for (i = 0; i < row; i++)
+            {
+                if (rects[i].left != rc.left || rects[i].right != rc.right) continue;
+                if (rects[i].bottom != rc.top) continue;
+                rects[i].bottom = rc.bottom;
+                break;
+            }
+            if (i < row) continue;
+            if (count == max_rects) return 0;
+            rects[count++] = rc;
         }
+    }
+    return count;
+}
+
+/* handler for errors caused by windows destroyed while an upload is queued */
+static int present_error_handler( Display *dpy, XErrorEvent *event, void *arg )
+{
+    return (event->error_code == BadDrawable || event->error_code == BadWindow ||
+            event->error_code == BadMatch);
+}
 
+/* upload the pending areas of the image to the window */
+static void present_surface( struct x11drv_window_surface *surface, BOOL async )
+{
+    RECT rects[64];
+    int i, count;
+    DWORD now;
+
+    EnterCriticalSection( &surface->present_crit );
+    if (IsRectEmpty( &surface->pending_bounds )) goto done;
+
+    /* the window may have been destroyed since the flush */
+    if (async) X11DRV_expect_error( gdi_display, present_error_handler, NULL );
+
+    if (!(count = get_dirty_rects( surface, surface->pending, &surface->pending_bounds,
+                                   rects, ARRAY_SIZE(rects) )))
+    {
+        rects[0] = surface->pending_bounds;
+        count = 1;
+    }
+
+    for (i = 0; i < count; i++)
+    {
 #ifdef HAVE_LIBXXSHM
         if (surface->shminfo.shmid != -1)
             XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                          coords.visrect.left, coords.visrect.top,
-                          surface->header.rect.left + coords.visrect.left,
-                          surface->header.rect.top + coords.visrect.top,
-                          coords.visrect.right - coords.visrect.left,
-                          coords.visrect.bottom - coords.visrect.top, False );
+                          rects[i].left, rects[i].top,
+                          surface->header.rect.left + rects[i].left,
+                          surface->header.rect.top + rects[i].top,
+                          rects[i].right - rects[i].left,
+                          rects[i].bottom - rects[i].top, False );
         else
 #endif
         XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
-        XFlush( gdi_display );
+                   rects[i].left, rects[i].top,
+                   surface->header.rect.left + rects[i].left,
+                   surface->header.rect.top + rects[i].top,
+                   rects[i].right - rects[i].left,
+                   rects[i].bottom - rects[i].top );
+        surface->upload_bytes += (ULONGLONG)(rects[i].right - rects[i].left) *
+                                 (rects[i].bottom - rects[i].top) * surface->image->bits_per_pixel / 8;
     }
+    /* the requests are only sent here; on the presenter thread, also wait until
+     * the server is done with the image so that the next flush can write to it */
+    if (async)
+    {
+        XSync( gdi_display, False );
+        if (X11DRV_check_error()) WARN( "window %lx is gone\n", surface->window );
+    }
+    else XFlush( gdi_display );
+
+    memset( surface->pending, 0, surface->tiles_x * surface->tiles_y );
+    reset_bounds( &surface->pending_bounds );
+
+    surface->upload_count++;
+    now = GetTickCount();
+    if (now - surface->stats_ticks >= 1000)
+    {
+        TRACE_(fps)( "surface %p: %u uploads, %s bytes in %u ms\n", surface, surface->upload_count,
+                     wine_dbgstr_longlong( surface->upload_bytes ), now - surface->stats_ticks );
+        surface->upload_bytes = 0;
+        surface->upload_count = 0;
+        surface->stats_ticks = now;
+    }
+done:
+    LeaveCriticalSection( &surface->present_crit );
+}
+
+/***********************************************************************
+ *           presenter_thread
+ *
+ * Upload the queued surfaces, at most once per display refresh.
+ */
+static DWORD CALLBACK presenter_thread( void *arg )
+{
+    DWORD interval = 1000 / (default_display_frequency > 0 ? default_display_frequency : 60);
+    DWORD last = GetTickCount(), elapsed;
+    struct x11drv_window_surface *surface;
+    struct list *ptr;
+
+    for (;;)
+    {
+        WaitForSingleObject( presenter_event, INFINITE );
+
+        /* let more flushes accumulate until the next frame */
+        if ((elapsed = GetTickCount() - last) < interval) Sleep( interval - elapsed );
+        last = GetTickCount();
+
+        EnterCriticalSection( &presenter_section );
+        list_move_tail( &presenter_batch, &presenter_queue );
+        LeaveCriticalSection( &presenter_section );
+
+        for (;;)
+        {
+            EnterCriticalSection( &presenter_section );
+            if ((ptr = list_head( &presenter_batch )))
+            {
+                list_remove( ptr );
+                list_init( ptr );
+                presenting = LIST_ENTRY( ptr, struct x11drv_window_surface, present_entry );
+            }
+            LeaveCriticalSection( &presenter_section );
+            if (!ptr) break;
+
+            surface = presenting;
+            present_surface( surface, TRUE );
+
+            EnterCriticalSection( &presenter_section );
+            presenting = NULL;
+            LeaveCriticalSection( &presenter_section );
+            window_surface_release( &surface->header );
+        }
+    }
+    return 0;
+}
+
+/* drop the queued uploads to a window from a presenter list; presenter_section must be held */
+static void cancel_present_list( struct list *list, Window window )
+{
+    struct x11drv_window_surface *surface, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( surface, next, list, struct x11drv_window_surface, present_entry )
+    {
+        if (surface->window != window) continue;
+        list_remove( &surface->present_entry );
+        list_init( &surface->present_entry );
+        window_surface_release( &surface->header );
+    }
+}
+
+/***********************************************************************
+ *           cancel_surface_presents
+ *
+ * Drop the queued uploads to a window that is about to be destroyed,
+ * and wait for the one in progress.
+ */
+void cancel_surface_presents( Window window )
+{
+    struct x11drv_window_surface *busy = NULL;
+
+    if (!async_surface_flush) return;
+
+    EnterCriticalSection( &presenter_section );
+    cancel_present_list( &presenter_queue, window );
+    cancel_present_list( &presenter_batch, window );
+    if (presenting && presenting->window == window)
+    {
+        busy = presenting;
+        window_surface_add_ref( &busy->header );
+    }
+    LeaveCriticalSection( &presenter_section );
+
+    if (busy)
+    {
+        EnterCriticalSection( &busy->present_crit );
+        LeaveCriticalSection( &busy->present_crit );
+        window_surface_release( &busy->header );
+    }
+}
+
+/* queue a surface for the presenter thread, return FALSE if it needs to be presented directly */
+static BOOL queue_surface_present( struct x11drv_window_surface *surface )
+{
+    static HANDLE thread;
+    BOOL ret = TRUE;
+
+    EnterCriticalSection( &presenter_section );
+    if (!thread)
+    {
+        if ((presenter_event = CreateEventW( NULL, FALSE, FALSE, NULL )))
+            thread = CreateThread( NULL, 0, presenter_thread, NULL, 0, NULL );
+        if (!thread)
+        {
+            ERR( "failed to start the presenter thread, flushing synchronously\n" );
+            async_surface_flush = FALSE;
+            ret = FALSE;
+        }
+    }
+    if (ret && list_empty( &surface->present_entry ))
+    {
+        window_surface_add_ref( &surface->header );
+        list_add_tail( &presenter_queue, &surface->present_entry );
+    }
+    LeaveCriticalSection( &presenter_section );
+    if (ret) SetEvent( presenter_event );
+    return ret;
+}
+
+/***********************************************************************
+ *           x11drv_surface_flush
+ *
+ * Copy the dirty areas to the image, and let the presenter thread upload them.
+ */
+static void x11drv_surface_flush( struct window_surface *window_surface )
+{
+    struct x11drv_window_surface *surface = get_x11_surface( window_surface );
+    RECT visrect;
+    int i, width, height;
+    BOOL queued = FALSE;
+
+    window_surface->funcs->lock( window_surface );
+    width  = surface->header.rect.right - surface->header.rect.left;
+    height = surface->header.rect.bottom - surface->header.rect.top;
+    SetRect( &visrect, 0, 0, width, height );
+    if (IntersectRect( &visrect, &visrect, &surface->bounds ))
+    {
+        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
+               surface, width, height, wine_dbgstr_rect( &surface->bounds ), surface->bits );
+
+        if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
+
+        EnterCriticalSection( &surface->present_crit );
+        copy_dirty_tiles( surface, &visrect );
+        for (i = 0; i < surface->tiles_x * surface->tiles_y; i++) surface->pending[i] |= surface->tiles[i];
+        add_bounds_rect( &surface->pending_bounds, &visrect );
+        LeaveCriticalSection( &surface->present_crit );
+
+        queued = surface->bits != surface->image->data && async_surface_flush &&
+                 queue_surface_present( surface );
+    }
+    memset( surface->tiles, 0, surface->tiles_x * surface->tiles_y );
     reset_bounds( &surface->bounds );
     window_surface->funcs->unlock( window_surface );
+
+    if (!queued) present_surface( surface, FALSE );
 }
 
 /***********************************************************************
@@ -2024,7 +2328,11 @@ static void x11drv_surface_destroy( struct window_surface *window_surface )
     }
     surface->crit.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection( &surface->crit );
+    surface->present_crit.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &surface->present_crit );
     if (surface->region) DeleteObject( surface->region );
+    HeapFree( GetProcessHeap(), 0, surface->tiles );
+    HeapFree( GetProcessHeap(), 0, surface->pending );
     HeapFree( GetProcessHeap(), 0, surface );
 }
 
@@ -2036,7 +2344,8 @@ static const struct window_surface_funcs x11drv_surface_funcs =
     x11drv_surface_get_bounds,
     x11drv_surface_set_region,
     x11drv_surface_flush,
-    x11drv_surface_destroy
+    x11drv_surface_destroy,
+    x11drv_surface_add_bounds
 };
 
 /***********************************************************************
@@ -2063,6 +2372,9 @@ struct window_surface *create_surface( Window window, const XVisualInfo *vis, co
 
     InitializeCriticalSection( &surface->crit );
     surface->crit.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": surface");
+    InitializeCriticalSection( &surface->present_crit );
+    surface->present_crit.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": surface present");
+    list_init( &surface->present_entry );
 
     surface->header.funcs = &x11drv_surface_funcs;
     surface->header.rect  = *rect;
@@ -2071,6 +2383,17 @@ struct window_surface *create_surface( Window window, const XVisualInfo *vis, co
     surface->is_argb = (use_alpha && vis->depth == 32 && surface->info.bmiHeader.biCompression == BI_RGB);
     set_color_key( surface, color_key );
     reset_bounds( &surface->bounds );
+    reset_bounds( &surface->pending_bounds );
+    surface->stats_ticks = GetTickCount();
+
+    surface->tiles_x = (width + (1 << SURFACE_TILE_SHIFT) - 1) >> SURFACE_TILE_SHIFT;
+    surface->tiles_y = (height + (1 << SURFACE_TILE_SHIFT) - 1) >> SURFACE_TILE_SHIFT;
+    if (!(surface->tiles = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                      max( 1, surface->tiles_x * surface->tiles_y ))))
+        goto failed;
+    if (!(surface->pending = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                        max( 1, surface->tiles_x * surface->tiles_y ))))
+        goto failed;
 
 #ifdef HAVE_LIBXXSHM
     surface->image = create_shm_image( vis, width, height, &surface->shminfo );
@@ -2091,9 +2414,11 @@ struct window_surface *create_surface( Window window, const XVisualInfo *vis, co
     if (vis->depth == 32 && !surface->is_argb)
         surface->alpha_bits = ~(vis->red_mask | vis->green_mask | vis->blue_mask);
 
-    if (surface->byteswap || format->bits_per_pixel == 4 || format->bits_per_pixel == 8)
+    if (surface->byteswap || format->bits_per_pixel == 4 || format->bits_per_pixel == 8 ||
+        async_surface_flush)
     {
-        /* allocate separate surface bits if byte swapping or palette mapping is required */
+        /* allocate separate surface bits if byte swapping or palette mapping is required,
+         * or to keep drawing while the presenter thread uploads the image */
         if (!(surface->bits  = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
                                           surface->info.bmiHeader.biSizeImage )))
             goto failed;
@@ -2141,7 +2466,7 @@ HRGN expose_surface( struct window_surface *window_surface, const RECT *rect )
 
     window_surface->funcs->lock( window_surface );
     OffsetRect( &rc, -window_surface->rect.left, -window_surface->rect.top );
-    add_bounds_rect( &surface->bounds, &rc );
+    x11drv_surface_add_bounds( window_surface, &rc );
     if (surface->region)
     {
         region = CreateRectRgnIndirect( rect );
@@ -1608,6 +1608,7 @@ static void destroy_whole_window( struct x11drv_win_data *data, BOOL already_des
     }
     else
     {
+        cancel_surface_presents( data->whole_window );
         if (data->client_window && !already_destroyed)
         {
             XSelectInput( data->display, data->client_window, 0 );
@@ -2781,7 +2782,7 @@ BOOL CDECL X11DRV_UpdateLayeredWindow( HWND hwnd, const UPDATELAYEREDWINDOWINFO
     if (ret)
     {
         memcpy( dst_bits, src_bits, bmi->bmiHeader.biSizeImage );
-        add_bounds_rect( surface->funcs->get_bounds( surface ), &rect );
+        surface->funcs->add_bounds( surface, &rect );
     }
 
     surface->funcs->unlock( surface );
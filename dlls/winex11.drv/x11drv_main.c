@@ -83,6 +83,7 @@ int primary_monitor = 0;
 BOOL client_side_graphics = TRUE;
 BOOL client_side_with_render = TRUE;
 BOOL shape_layered_windows = TRUE;
+BOOL async_surface_flush = FALSE;
 int copy_default_colors = 128;
 int alloc_system_colors = 256;
 int default_display_frequency = 0;
@@ -91,11 +92,18 @@ int xrender_error_base = 0;
 HMODULE x11drv_module = 0;
 char *process_name = NULL;
 
-static x11drv_error_callback err_callback;   /* current callback for error */
-static Display *err_callback_display;        /* display callback is set for */
-static void *err_callback_arg;               /* error callback argument */
-static int err_callback_result;              /* error callback result */
-static unsigned long err_serial;             /* serial number of first request */
+/* an error expected by a thread, set up by X11DRV_expect_error */
+struct error_trap
+{
+    DWORD                 tid;       /* thread that set the trap, 0 if the entry is free */
+    x11drv_error_callback callback;  /* callback for error */
+    Display              *display;   /* display callback is set for */
+    void                 *arg;       /* error callback argument */
+    int                   result;    /* error callback result */
+    unsigned long         serial;    /* serial number of first request */
+};
+
+static struct error_trap error_traps[64];
 static int (*old_error_handler)( Display *, XErrorEvent * );
 static BOOL use_xim = TRUE;
 static char input_style[20];
@@ -109,6 +117,16 @@ static CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static CRITICAL_SECTION x11drv_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* protects the error traps; never held while waiting for the X server */
+static CRITICAL_SECTION error_section;
+static CRITICAL_SECTION_DEBUG error_critsect_debug =
+{
+    0, 0, &error_section,
+    { &error_critsect_debug.ProcessLocksList, &error_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": error_section") }
+};
+static CRITICAL_SECTION error_section = { &error_critsect_debug, -1, 0, 0, 0, 0 };
+
 struct d3dkmt_vidpn_source
 {
     D3DKMT_VIDPNSOURCEOWNER_TYPE type;      /* VidPN source owner type */
@@ -251,19 +269,45 @@ static inline BOOL ignore_error( Display *display, XErrorEvent *event )
 }
 
 
+/* find the trap of the current thread, or a free entry; error_section must be held */
+static struct error_trap *get_error_trap( DWORD tid )
+{
+    struct error_trap *free_trap = NULL;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(error_traps); i++)
+    {
+        if (error_traps[i].tid == tid) return &error_traps[i];
+        if (!error_traps[i].tid && !free_trap) free_trap = &error_traps[i];
+    }
+    return free_trap;
+}
+
+
 /***********************************************************************
  *		X11DRV_expect_error
  *
  * Setup a callback function that will be called on an X error.  The
  * callback must return non-zero if the error is the one it expected.
+ * Each thread has its own callback.
  */
 void X11DRV_expect_error( Display *display, x11drv_error_callback callback, void *arg )
 {
-    err_callback         = callback;
-    err_callback_display = display;
-    err_callback_arg     = arg;
-    err_callback_result  = 0;
-    err_serial           = NextRequest(display);
+    DWORD tid = GetCurrentThreadId();
+    struct error_trap *trap;
+
+    EnterCriticalSection( &error_section );
+    if ((trap = get_error_trap( tid )))
+    {
+        trap->tid      = tid;
+        trap->callback = callback;
+        trap->display  = display;
+        trap->arg      = arg;
+        trap->result   = 0;
+        trap->serial   = NextRequest(display);
+    }
+    else ERR( "too many threads expecting errors\n" );
+    LeaveCriticalSection( &error_section );
 }
 
 
@@ -275,8 +319,39 @@ void X11DRV_expect_error( Display *display, x11drv_error_callback callback, void
  */
 int X11DRV_check_error(void)
 {
-    err_callback = NULL;
-    return err_callback_result;
+    DWORD tid = GetCurrentThreadId();
+    struct error_trap *trap;
+    int ret = 0;
+
+    EnterCriticalSection( &error_section );
+    if ((trap = get_error_trap( tid )) && trap->tid == tid)
+    {
+        ret = trap->result;
+        trap->tid = 0;
+    }
+    LeaveCriticalSection( &error_section );
+    return ret;
+}
+
+
+/* call the callback of the trap that expects an error; error_section must be held */
+static BOOL handle_expected_error( Display *display, XErrorEvent *error_evt )
+{
+    DWORD tid = GetCurrentThreadId();
+    struct error_trap *trap = NULL;
+    int i;
+
+    /* the error may be read by any thread using the display; prefer the trap of the
+     * current thread, then the most recent one that covers the failed request */
+    for (i = 0; i < ARRAY_SIZE(error_traps); i++)
+    {
+        if (!error_traps[i].tid || error_traps[i].display != display) continue;
+        if ((long)(error_evt->serial - error_traps[i].serial) < 0) continue;
+        if (trap && trap->tid == tid) continue;
+        if (!trap || error_traps[i].tid == tid || (long)(error_traps[i].serial - trap->serial) > 0)
+            trap = &error_traps[i];
+    }
+    return trap && (trap->result = trap->callback( display, error_evt, trap->arg ));
 }
 
 
@@ -285,15 +360,16 @@ int X11DRV_check_error(void)
  */
 static int error_handler( Display *display, XErrorEvent *error_evt )
 {
-    if (err_callback && display == err_callback_display &&
-        (long)(error_evt->serial - err_serial) >= 0)
+    BOOL expected;
+
+    EnterCriticalSection( &error_section );
+    expected = handle_expected_error( display, error_evt );
+    LeaveCriticalSection( &error_section );
+    if (expected)
     {
-        if ((err_callback_result = err_callback( display, error_evt, err_callback_arg )))
-        {
-            TRACE( "got expected error %d req %d\n",
-                   error_evt->error_code, error_evt->request_code );
-            return 0;
-        }
+        TRACE( "got expected error %d req %d\n",
+               error_evt->error_code, error_evt->request_code );
+        return 0;
     }
     if (ignore_error( display, error_evt ))
     {
@@ -427,6 +503,9 @@ static void setup_options(void)
     if (!get_config_key( hkey, appkey, "ShapeLayeredWindows", buffer, sizeof(buffer) ))
         shape_layered_windows = IS_OPTION_TRUE( buffer[0] );
 
+    if (!get_config_key( hkey, appkey, "AsyncSurfaceFlush", buffer, sizeof(buffer) ))
+        async_surface_flush = IS_OPTION_TRUE( buffer[0] );
+
     if (!get_config_key( hkey, appkey, "PrivateColorMap", buffer, sizeof(buffer) ))
         private_color_map = IS_OPTION_TRUE( buffer[0] );
 
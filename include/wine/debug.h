@@ -77,10 +77,22 @@ struct __wine_debug_channel
 #define __WINE_IS_DEBUG_ON(dbcl,dbch) \
   (__WINE_GET_DEBUGGING##dbcl(dbch) && (__wine_dbg_get_channel_flags(dbch) & (1 << __WINE_DBCL##dbcl)))
 
+/* __WINE_NOTRACE(ch) is 1 if the TRACE messages of the channel are compiled out, which is
+ * requested by defining __WINE_NOTRACE_<ch> (see the --with-notrace-channels configure option) */
+#define __WINE_NOTRACE(ch)                  __WINE_NOTRACE_EXPAND(__WINE_NOTRACE_##ch)
+#define __WINE_NOTRACE_EXPAND(def)          __WINE_NOTRACE_VALUE(def)
+#define __WINE_NOTRACE_VALUE(val)           __WINE_NOTRACE_CHECK(__WINE_NOTRACE_PLACEHOLDER_##val)
+#define __WINE_NOTRACE_CHECK(arg)           __WINE_NOTRACE_SECOND(arg 1, 0, 0)
+#define __WINE_NOTRACE_SECOND(a,val,...)    val
+#define __WINE_NOTRACE_PLACEHOLDER_1        0,
+
+#define __WINE_DPRINTF(dbcl,dbch) __WINE_DPRINTF_IF(__WINE_GET_DEBUGGING(dbcl,(dbch)),dbcl,dbch)
+
 #if defined(__GNUC__) || defined(__clang__)
 
-#define __WINE_DPRINTF(dbcl,dbch) \
-  do { if(__WINE_GET_DEBUGGING(dbcl,(dbch))) { \
+/* the message is the unlikely case, keep it out of the way of the caller's code */
+#define __WINE_DPRINTF_IF(cond,dbcl,dbch) \
+  do { if(__builtin_expect(!!(cond),0)) { \
        struct __wine_debug_channel * const __dbch = (dbch); \
        const enum __wine_debug_class __dbcl = __WINE_DBCL##dbcl; \
        __WINE_DBG_LOG
@@ -109,8 +121,8 @@ struct __wine_debug_channel
 
 #elif defined(__SUNPRO_C)
 
-#define __WINE_DPRINTF(dbcl,dbch) \
-  do { if(__WINE_GET_DEBUGGING(dbcl,(dbch))) { \
+#define __WINE_DPRINTF_IF(cond,dbcl,dbch) \
+  do { if(cond) { \
        struct __wine_debug_channel * const __dbch = (dbch); \
        const enum __WINE_DEBUG_CLASS __dbcl = __WINE_DBCL##dbcl; \
        __WINE_DBG_LOG
@@ -134,8 +146,8 @@ struct __wine_debug_channel
 
 #else  /* !__GNUC__ && !__SUNPRO_C */
 
-#define __WINE_DPRINTF(dbcl,dbch) \
-    (!__WINE_GET_DEBUGGING(dbcl,(dbch)) || \
+#define __WINE_DPRINTF_IF(cond,dbcl,dbch) \
+    (!(cond) || \
      (wine_dbg_log(__WINE_DBCL##dbcl,(dbch),__FILE__,"%d: ",__LINE__) == -1)) ? \
      (void)0 : (void)wine_dbg_printf
 
@@ -469,10 +481,14 @@ static inline const char *wine_dbgstr_variant( const VARIANT *v )
 #endif /* defined(__oaidl_h__) && defined(V_VT) */
 
 #ifndef WINE_TRACE
-#define WINE_TRACE                 __WINE_DPRINTF(_TRACE,__wine_dbch___default)
-#define WINE_TRACE_(ch)            __WINE_DPRINTF(_TRACE,&__wine_dbch_##ch)
+#define WINE_TRACE                 __WINE_DPRINTF_TRACE(__wine_notrace___default,__wine_dbch___default)
+#define WINE_TRACE_(ch)            __WINE_DPRINTF_TRACE(__wine_notrace_##ch,&__wine_dbch_##ch)
 #endif
-#define WINE_TRACE_ON(ch)          __WINE_IS_DEBUG_ON(_TRACE,&__wine_dbch_##ch)
+#define WINE_TRACE_ON(ch)          (!__wine_notrace_##ch && __WINE_IS_DEBUG_ON(_TRACE,&__wine_dbch_##ch))
+
+/* the notrace flag is a constant, so compiled out channels don't even check their flags */
+#define __WINE_DPRINTF_TRACE(notrace,dbch) \
+    __WINE_DPRINTF_IF(!(notrace) && __WINE_GET_DEBUGGING(_TRACE,(dbch)),_TRACE,dbch)
 
 #ifndef WINE_WARN
 #define WINE_WARN                  __WINE_DPRINTF(_WARN,__wine_dbch___default)
@@ -491,8 +507,10 @@ static inline const char *wine_dbgstr_variant( const VARIANT *v )
 #define WINE_ERR_ON(ch)            __WINE_IS_DEBUG_ON(_ERR,&__wine_dbch_##ch)
 
 #define WINE_DECLARE_DEBUG_CHANNEL(ch) \
+    enum { __wine_notrace_##ch = __WINE_NOTRACE(ch) }; \
     static struct __wine_debug_channel __wine_dbch_##ch = { 0xff, #ch }
 #define WINE_DEFAULT_DEBUG_CHANNEL(ch) \
+    enum { __wine_notrace_##ch = __WINE_NOTRACE(ch), __wine_notrace___default = __wine_notrace_##ch }; \
     static struct __wine_debug_channel __wine_dbch_##ch = { 0xff, #ch }; \
     static struct __wine_debug_channel * const __wine_dbch___default = &__wine_dbch_##ch
 
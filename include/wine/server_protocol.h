@@ -790,6 +790,48 @@ struct rawinput_device
     user_handle_t  target;
 };
 
+struct cursor_pos
+{
+    int            x;
+    int            y;
+    unsigned int   time;
+    int            __pad;
+    lparam_t       info;
+};
+
+
+struct shared_window
+{
+    unsigned int   seq;
+    unsigned short type;
+    unsigned short generation;
+    thread_id_t    tid;
+    process_id_t   pid;
+    unsigned int   style;
+    unsigned int   ex_style;
+    user_handle_t  parent;
+    user_handle_t  owner;
+    unsigned int   dpi;
+    int            __pad;
+    rectangle_t    window;
+    rectangle_t    client;
+};
+
+#define SHARED_WINDOW_COUNT ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1)
+
+#define REQUEST_HISTOGRAM_SIZE 24
+
+struct request_stat
+{
+    unsigned int   request;
+    unsigned int   count;
+    mem_size_t     bytes_in;
+    mem_size_t     bytes_out;
+    timeout_t      time;
+    unsigned int   histogram[REQUEST_HISTOGRAM_SIZE];
+
+};
+
 
 
 
@@ -1002,6 +1044,21 @@ struct get_process_vm_counters_reply
 
 
 
+struct get_process_tebs_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct get_process_tebs_reply
+{
+    struct reply_header __header;
+    int          count;
+    /* VARARG(tebs,uints64); */
+    char __pad_12[4];
+};
+
+
+
 struct set_process_info_request
 {
     struct request_header __header;
@@ -2403,6 +2460,22 @@ struct get_mapping_info_reply
 
 
 
+struct get_image_cache_request
+{
+    struct request_header __header;
+    obj_handle_t mapping;
+    client_ptr_t base;
+};
+struct get_image_cache_reply
+{
+    struct reply_header __header;
+    client_ptr_t base;
+    obj_handle_t file;
+    char __pad_20[4];
+};
+
+
+
 struct map_view_request
 {
     struct request_header __header;
@@ -3688,6 +3761,20 @@ struct set_window_info_reply
 
 
 
+struct get_shared_window_table_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_shared_window_table_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    char __pad_12[4];
+};
+
+
+
 struct set_parent_request
 {
     struct request_header __header;
@@ -5817,6 +5904,19 @@ struct set_cursor_reply
 #define SET_CURSOR_NOCLIP 0x10
 
 
+struct get_cursor_history_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_cursor_history_reply
+{
+    struct reply_header __header;
+    /* VARARG(history,cursor_positions); */
+};
+
+
+
 struct get_rawinput_devices_request
 {
     struct request_header __header;
@@ -5985,6 +6085,19 @@ struct get_system_info_reply
 };
 
 
+
+struct get_request_stats_request
+{
+    struct request_header __header;
+    process_id_t pid;
+};
+struct get_request_stats_reply
+{
+    struct reply_header __header;
+    /* VARARG(stats,request_stats); */
+};
+
+
 enum request
 {
     REQ_new_process,
@@ -5998,6 +6111,7 @@ enum request
     REQ_terminate_thread,
     REQ_get_process_info,
     REQ_get_process_vm_counters,
+    REQ_get_process_tebs,
     REQ_set_process_info,
     REQ_get_thread_info,
     REQ_get_thread_times,
@@ -6077,6 +6191,7 @@ enum request
     REQ_create_mapping,
     REQ_open_mapping,
     REQ_get_mapping_info,
+    REQ_get_image_cache,
     REQ_map_view,
     REQ_unmap_view,
     REQ_get_mapping_file,
@@ -6154,6 +6269,7 @@ enum request
     REQ_set_window_owner,
     REQ_get_window_info,
     REQ_set_window_info,
+    REQ_get_shared_window_table,
     REQ_set_parent,
     REQ_get_window_parents,
     REQ_get_window_children,
@@ -6283,6 +6399,7 @@ enum request
     REQ_alloc_user_handle,
     REQ_free_user_handle,
     REQ_set_cursor,
+    REQ_get_cursor_history,
     REQ_get_rawinput_devices,
     REQ_update_rawinput_devices,
     REQ_create_job,
@@ -6295,6 +6412,7 @@ enum request
     REQ_suspend_process,
     REQ_resume_process,
     REQ_get_system_info,
+    REQ_get_request_stats,
     REQ_NB_REQUESTS
 };
 
@@ -6313,6 +6431,7 @@ union generic_request
     struct terminate_thread_request terminate_thread_request;
     struct get_process_info_request get_process_info_request;
     struct get_process_vm_counters_request get_process_vm_counters_request;
+    struct get_process_tebs_request get_process_tebs_request;
     struct set_process_info_request set_process_info_request;
     struct get_thread_info_request get_thread_info_request;
     struct get_thread_times_request get_thread_times_request;
@@ -6392,6 +6511,7 @@ union generic_request
     struct create_mapping_request create_mapping_request;
     struct open_mapping_request open_mapping_request;
     struct get_mapping_info_request get_mapping_info_request;
+    struct get_image_cache_request get_image_cache_request;
     struct map_view_request map_view_request;
     struct unmap_view_request unmap_view_request;
     struct get_mapping_file_request get_mapping_file_request;
@@ -6469,6 +6589,7 @@ union generic_request
     struct set_window_owner_request set_window_owner_request;
     struct get_window_info_request get_window_info_request;
     struct set_window_info_request set_window_info_request;
+    struct get_shared_window_table_request get_shared_window_table_request;
     struct set_parent_request set_parent_request;
     struct get_window_parents_request get_window_parents_request;
     struct get_window_children_request get_window_children_request;
@@ -6598,6 +6719,7 @@ union generic_request
     struct alloc_user_handle_request alloc_user_handle_request;
     struct free_user_handle_request free_user_handle_request;
     struct set_cursor_request set_cursor_request;
+    struct get_cursor_history_request get_cursor_history_request;
     struct get_rawinput_devices_request get_rawinput_devices_request;
     struct update_rawinput_devices_request update_rawinput_devices_request;
     struct create_job_request create_job_request;
@@ -6610,6 +6732,7 @@ union generic_request
     struct suspend_process_request suspend_process_request;
     struct resume_process_request resume_process_request;
     struct get_system_info_request get_system_info_request;
+    struct get_request_stats_request get_request_stats_request;
 };
 union generic_reply
 {
@@ -6626,6 +6749,7 @@ union generic_reply
     struct terminate_thread_reply terminate_thread_reply;
     struct get_process_info_reply get_process_info_reply;
     struct get_process_vm_counters_reply get_process_vm_counters_reply;
+    struct get_process_tebs_reply get_process_tebs_reply;
     struct set_process_info_reply set_process_info_reply;
     struct get_thread_info_reply get_thread_info_reply;
     struct get_thread_times_reply get_thread_times_reply;
@@ -6705,6 +6829,7 @@ union generic_reply
     struct create_mapping_reply create_mapping_reply;
     struct open_mapping_reply open_mapping_reply;
     struct get_mapping_info_reply get_mapping_info_reply;
+    struct get_image_cache_reply get_image_cache_reply;
     struct map_view_reply map_view_reply;
     struct unmap_view_reply unmap_view_reply;
     struct get_mapping_file_reply get_mapping_file_reply;
@@ -6782,6 +6907,7 @@ union generic_reply
     struct set_window_owner_reply set_window_owner_reply;
     struct get_window_info_reply get_window_info_reply;
     struct set_window_info_reply set_window_info_reply;
+    struct get_shared_window_table_reply get_shared_window_table_reply;
     struct set_parent_reply set_parent_reply;
     struct get_window_parents_reply get_window_parents_reply;
     struct get_window_children_reply get_window_children_reply;
@@ -6911,6 +7037,7 @@ union generic_reply
     struct alloc_user_handle_reply alloc_user_handle_reply;
     struct free_user_handle_reply free_user_handle_reply;
     struct set_cursor_reply set_cursor_reply;
+    struct get_cursor_history_reply get_cursor_history_reply;
     struct get_rawinput_devices_reply get_rawinput_devices_reply;
     struct update_rawinput_devices_reply update_rawinput_devices_reply;
     struct create_job_reply create_job_reply;
@@ -6923,11 +7050,12 @@ union generic_reply
     struct suspend_process_reply suspend_process_reply;
     struct resume_process_reply resume_process_reply;
     struct get_system_info_reply get_system_info_reply;
+    struct get_request_stats_reply get_request_stats_reply;
 };
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 608
+#define SERVER_PROTOCOL_VERSION 617
 
 /* ### protocol_version end ### */
 
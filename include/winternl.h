@@ -974,7 +974,10 @@ typedef enum _SYSTEM_INFORMATION_CLASS {
     SystemFileCacheInformationEx = 81,
     SystemCodeIntegrityInformation = 103,
     SystemLogicalProcessorInformationEx = 107,
-    SystemInformationClassMax
+    SystemInformationClassMax,
+#ifdef __WINESRC__
+    SystemWineCountersInformation = 1000,
+#endif
 } SYSTEM_INFORMATION_CLASS, *PSYSTEM_INFORMATION_CLASS;
 
 typedef struct _SYSTEM_CODEINTEGRITY_INFORMATION
@@ -1688,6 +1691,19 @@ typedef struct _SYSTEM_PROCESS_INFORMATION {
 #endif
 } SYSTEM_PROCESS_INFORMATION, *PSYSTEM_PROCESS_INFORMATION;
 
+#ifdef __WINESRC__
+/* Wine-specific instrumentation counters of a process */
+typedef struct _SYSTEM_WINE_COUNTERS_INFORMATION {
+    ULONG     ProcessId;            /* in: process to query, 0 for the current process */
+    ULONG     ThreadCount;
+    ULONGLONG ServerCalls;
+    ULONGLONG SyncWaits;
+    ULONGLONG HeapAllocations;
+    ULONGLONG PageFaults;
+    ULONGLONG Exceptions;
+} SYSTEM_WINE_COUNTERS_INFORMATION, *PSYSTEM_WINE_COUNTERS_INFORMATION;
+#endif
+
 typedef struct _SYSTEM_REGISTRY_QUOTA_INFORMATION {
     ULONG RegistryQuotaAllowed;
     ULONG RegistryQuotaUsed;
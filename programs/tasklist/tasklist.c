@@ -28,7 +28,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(tasklist);
 
 static HRESULT (WINAPI *pNtQuerySystemInformation)(SYSTEM_INFORMATION_CLASS,void*,ULONG,ULONG*);
 
-static BOOL has_pid = FALSE, has_eq = FALSE, has_filter=FALSE, has_imagename = FALSE;
+static BOOL has_pid = FALSE, has_eq = FALSE, has_filter=FALSE, has_imagename = FALSE, has_counters = FALSE;
 
 WCHAR req_pid[sizeof(HANDLE)];
 WCHAR req_imagename[MAX_PATH];
@@ -52,6 +52,24 @@ static void write_to_stdout(const WCHAR *str)
     heap_free(str_converted);
 }
 
+/* append the Wine instrumentation counters of a process */
+static void write_out_counters(ULONG pid)
+{
+    SYSTEM_WINE_COUNTERS_INFORMATION info;
+    WCHAR buffer[128];
+
+    memset(&info, 0, sizeof(info));
+    info.ProcessId = pid;
+    if (pNtQuerySystemInformation(SystemWineCountersInformation, &info, sizeof(info), NULL))
+    {
+        write_to_stdout(L",,,,,,");
+        return;
+    }
+    swprintf(buffer, ARRAY_SIZE(buffer), L",%u,%I64u,%I64u,%I64u,%I64u,%I64u", info.ThreadCount,
+             info.ServerCalls, info.SyncWaits, info.HeapAllocations, info.PageFaults, info.Exceptions);
+    write_to_stdout(buffer);
+}
+
 static void write_out_processes(void)
 {
     ULONG                            ret_size, i;
@@ -99,6 +117,8 @@ static void write_out_processes(void)
             write_to_stdout(spi->ProcessName.Buffer);
             write_to_stdout(L",");
             write_to_stdout(pid);
+            if (has_counters)
+                write_out_counters(HandleToULong(spi->UniqueProcessId));
             write_to_stdout(L"\n");
         }
         spi = (SYSTEM_PROCESS_INFORMATION *)((BYTE *)spi + spi->NextEntryOffset);
@@ -125,6 +145,10 @@ static BOOL process_arguments(int argc, WCHAR *argv[])
         if (!wcsicmp(L"nh", argdata) || !wcsicmp(L"v", argdata))
             FIXME("Option %s ignored\n", wine_dbgstr_w(argdata));
 
+        /* Wine extension: append the ntdll instrumentation counters */
+        if (!wcsicmp(L"counters", argdata))
+            has_counters = TRUE;
+
         if (!wcsicmp(L"fo", argdata))
         {
             i++;
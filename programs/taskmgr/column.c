@@ -30,7 +30,7 @@
 #include "taskmgr.h"
 #include "column.h"
 
-UINT    ColumnDataHints[25];
+UINT    ColumnDataHints[26];
 
 /* Column Headers; Begin */
 static WCHAR wszImageName[255];
@@ -58,6 +58,7 @@ static WCHAR wszIOOther[255];
 static WCHAR wszIOReadBytes[255];
 static WCHAR wszIOWriteBytes[255];
 static WCHAR wszIOOtherBytes[255];
+static WCHAR wszServerCalls[255];
 /* Column Headers; End */
 
 static void load_column_headers(void)
@@ -87,6 +88,7 @@ static void load_column_headers(void)
     LoadStringW(hInst, IDS_IOREADBYTES, wszIOReadBytes, ARRAY_SIZE(wszIOReadBytes));
     LoadStringW(hInst, IDS_IOWRITEBYTES, wszIOWriteBytes, ARRAY_SIZE(wszIOWriteBytes));
     LoadStringW(hInst, IDS_IOOTHERBYTES, wszIOOtherBytes, ARRAY_SIZE(wszIOOtherBytes));
+    LoadStringW(hInst, IDS_SERVERCALLS, wszServerCalls, ARRAY_SIZE(wszServerCalls));
 }
 
 static int InsertColumn(int nCol, LPCWSTR lpszColumnHeading, int nFormat, int nWidth, int nSubItem)
@@ -168,6 +170,8 @@ void AddColumns(void)
         InsertColumn(23, wszIOWriteBytes, LVCFMT_RIGHT, TaskManagerSettings.ColumnSizeArray[23], -1);
     if (TaskManagerSettings.Column_IOOtherBytes)
         InsertColumn(24, wszIOOtherBytes, LVCFMT_RIGHT, TaskManagerSettings.ColumnSizeArray[24], -1);
+    if (TaskManagerSettings.Column_ServerCalls)
+        InsertColumn(25, wszServerCalls, LVCFMT_RIGHT, TaskManagerSettings.ColumnSizeArray[25], -1);
 
     size = SendMessageW(hProcessPageHeaderCtrl, HDM_GETITEMCOUNT, 0, 0);
     SendMessageW(hProcessPageListCtrl, LVM_SETCOLUMNORDERARRAY, (WPARAM) size, (LPARAM) &TaskManagerSettings.ColumnOrderArray);
@@ -232,6 +236,8 @@ static INT_PTR CALLBACK ColumnsDialogWndProc(HWND hDlg, UINT message, WPARAM wPa
             SendMessageW(GetDlgItem(hDlg, IDC_IOWRITEBYTES), BM_SETCHECK, BST_CHECKED, 0);
         if (TaskManagerSettings.Column_IOOtherBytes)
             SendMessageW(GetDlgItem(hDlg, IDC_IOOTHERBYTES), BM_SETCHECK, BST_CHECKED, 0);
+        if (TaskManagerSettings.Column_ServerCalls)
+            SendMessageW(GetDlgItem(hDlg, IDC_SERVERCALLS), BM_SETCHECK, BST_CHECKED, 0);
 
         return TRUE;
 
@@ -270,6 +276,7 @@ static INT_PTR CALLBACK ColumnsDialogWndProc(HWND hDlg, UINT message, WPARAM wPa
             TaskManagerSettings.Column_IOReadBytes = SendMessageW(GetDlgItem(hDlg, IDC_IOREADBYTES), BM_GETCHECK, 0, 0);
             TaskManagerSettings.Column_IOWriteBytes = SendMessageW(GetDlgItem(hDlg, IDC_IOWRITEBYTES), BM_GETCHECK, 0, 0);
             TaskManagerSettings.Column_IOOtherBytes = SendMessageW(GetDlgItem(hDlg, IDC_IOOTHERBYTES), BM_GETCHECK, 0, 0);
+            TaskManagerSettings.Column_ServerCalls = SendMessageW(GetDlgItem(hDlg, IDC_SERVERCALLS), BM_GETCHECK, 0, 0);
 
             EndDialog(hDlg, LOWORD(wParam));
             return TRUE;
@@ -289,7 +296,7 @@ void SaveColumnSettings(void)
     int        size;
 
     /* Reset column data */
-    for (i=0; i<25; i++)
+    for (i=0; i<26; i++)
         TaskManagerSettings.ColumnOrderArray[i] = i;
 
     TaskManagerSettings.Column_ImageName = FALSE;
@@ -317,6 +324,7 @@ void SaveColumnSettings(void)
     TaskManagerSettings.Column_IOWriteBytes = FALSE;
     TaskManagerSettings.Column_IOOther = FALSE;
     TaskManagerSettings.Column_IOOtherBytes = FALSE;
+    TaskManagerSettings.Column_ServerCalls = FALSE;
     TaskManagerSettings.ColumnSizeArray[0] = 105;
     TaskManagerSettings.ColumnSizeArray[1] = 50;
     TaskManagerSettings.ColumnSizeArray[2] = 107;
@@ -342,6 +350,7 @@ void SaveColumnSettings(void)
     TaskManagerSettings.ColumnSizeArray[22] = 70;
     TaskManagerSettings.ColumnSizeArray[23] = 70;
     TaskManagerSettings.ColumnSizeArray[24] = 70;
+    TaskManagerSettings.ColumnSizeArray[25] = 70;
 
     /* Get header order */
     size = SendMessageW(hProcessPageHeaderCtrl, HDM_GETITEMCOUNT, 0, 0);
@@ -482,6 +491,11 @@ void SaveColumnSettings(void)
             TaskManagerSettings.Column_IOOtherBytes = TRUE;
             TaskManagerSettings.ColumnSizeArray[24] = hditem.cxy;
         }
+        if (lstrcmpW(text, wszServerCalls) == 0)
+        {
+            TaskManagerSettings.Column_ServerCalls = TRUE;
+            TaskManagerSettings.ColumnSizeArray[25] = hditem.cxy;
+        }
     }
 }
 
@@ -496,7 +510,7 @@ void ProcessPage_OnViewSelectColumns(void)
             SendMessageW(hProcessPageListCtrl, LVM_DELETECOLUMN, 0, i);
         }
 
-        for (i=0; i<25; i++)
+        for (i=0; i<26; i++)
             TaskManagerSettings.ColumnOrderArray[i] = i;
 
         TaskManagerSettings.ColumnSizeArray[0] = 105;
@@ -524,6 +538,7 @@ void ProcessPage_OnViewSelectColumns(void)
         TaskManagerSettings.ColumnSizeArray[22] = 70;
         TaskManagerSettings.ColumnSizeArray[23] = 70;
         TaskManagerSettings.ColumnSizeArray[24] = 70;
+        TaskManagerSettings.ColumnSizeArray[25] = 70;
 
         AddColumns();
     }
@@ -595,5 +610,7 @@ void UpdateColumnDataHints(void)
             ColumnDataHints[Index] = COLUMN_IOWRITEBYTES;
         if (lstrcmpW(text, wszIOOtherBytes) == 0)
             ColumnDataHints[Index] = COLUMN_IOOTHERBYTES;
+        if (lstrcmpW(text, wszServerCalls) == 0)
+            ColumnDataHints[Index] = COLUMN_SERVERCALLS;
     }
 }
@@ -48,8 +48,9 @@
 #define COLUMN_IOREADBYTES            22
 #define COLUMN_IOWRITEBYTES            23
 #define COLUMN_IOOTHERBYTES            24
+#define COLUMN_SERVERCALLS            25
 
-extern    UINT    ColumnDataHints[25];
+extern    UINT    ColumnDataHints[26];
 
 void ProcessPage_OnViewSelectColumns(void);
 void AddColumns(void);
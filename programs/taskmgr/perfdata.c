@@ -99,6 +99,7 @@ void PerfDataRefresh(void)
     SYSTEM_PERFORMANCE_INFORMATION    SysPerfInfo;
     SYSTEM_TIMEOFDAY_INFORMATION      SysTimeInfo;
     SYSTEM_CACHE_INFORMATION        SysCacheInfo;
+    SYSTEM_WINE_COUNTERS_INFORMATION  WineCountersInfo;
     LPBYTE                            SysHandleInfoData;
     SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *SysProcessorTimeInfo;
     double                            CurrentKernelTime;
@@ -286,6 +287,14 @@ void PerfDataRefresh(void)
         pPerfData[Idx].HandleCount = pSPI->HandleCount;
         pPerfData[Idx].ThreadCount = pSPI->dwThreadCount;
         pPerfData[Idx].SessionId = pSPI->SessionId;
+
+        pPerfData[Idx].ServerCalls = 0;
+        if (TaskManagerSettings.Column_ServerCalls) {
+            memset(&WineCountersInfo, 0, sizeof(WineCountersInfo));
+            WineCountersInfo.ProcessId = (DWORD_PTR)pSPI->UniqueProcessId;
+            if (!pNtQuerySystemInformation(SystemWineCountersInformation, &WineCountersInfo, sizeof(WineCountersInfo), NULL))
+                pPerfData[Idx].ServerCalls = WineCountersInfo.ServerCalls;
+        }
         
         hProcess = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, (DWORD_PTR)pSPI->UniqueProcessId);
         if (hProcess) {
@@ -665,6 +674,22 @@ BOOL PerfDataGetIOCounters(ULONG Index, PIO_COUNTERS pIoCounters)
     return bSuccessful;
 }
 
+ULONGLONG PerfDataGetServerCalls(ULONG Index)
+{
+    ULONGLONG    ServerCalls;
+
+    EnterCriticalSection(&PerfDataCriticalSection);
+
+    if (Index < ProcessCount)
+        ServerCalls = pPerfData[Index].ServerCalls;
+    else
+        ServerCalls = 0;
+
+    LeaveCriticalSection(&PerfDataCriticalSection);
+
+    return ServerCalls;
+}
+
 ULONG PerfDataGetCommitChargeTotalK(void)
 {
     ULONG    Total;
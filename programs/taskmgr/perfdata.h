@@ -44,6 +44,7 @@ typedef struct _PERFDATA
 	ULONG				PageFaultCountDelta;
 	VM_COUNTERS                     vmCounters;
 	IO_COUNTERS			IOCounters;
+	ULONGLONG			ServerCalls;
 
 	TIME				UserTime;
 	TIME				KernelTime;
@@ -98,6 +99,7 @@ ULONG	PerfDataGetThreadCount(ULONG Index);
 ULONG	PerfDataGetUSERObjectCount(ULONG Index);
 ULONG	PerfDataGetGDIObjectCount(ULONG Index);
 BOOL	PerfDataGetIOCounters(ULONG Index, PIO_COUNTERS pIoCounters);
+ULONGLONG	PerfDataGetServerCalls(ULONG Index);
 
 ULONG	PerfDataGetCommitChargeTotalK(void);
 ULONG	PerfDataGetCommitChargeLimitK(void);
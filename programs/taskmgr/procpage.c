@@ -309,6 +309,11 @@ static void ProcessPageOnNotify(LPARAM lParam)
                 _ui64tow(iocounters.OtherTransferCount, pnmdi->item.pszText, 10);
                 CommaSeparateNumberString(pnmdi->item.pszText, pnmdi->item.cchTextMax);
             }
+            if (ColumnDataHints[ColumnIndex] == COLUMN_SERVERCALLS)
+            {
+                _ui64tow(PerfDataGetServerCalls(Index), pnmdi->item.pszText, 10);
+                CommaSeparateNumberString(pnmdi->item.pszText, pnmdi->item.cchTextMax);
+            }
 
             break;
 
@@ -120,6 +120,7 @@
 #define IDC_MEMORY_USAGE_HISTORY_FRAME  1046
 #define IDC_CPU28                       1047
 #define IDC_IOOTHERBYTES                1047
+#define IDC_SERVERCALLS                 1048
 #define IDC_CPU_USAGE_GRAPH             1047
 #define IDC_CPU29                       1048
 #define IDC_MEM_USAGE_GRAPH2            1048
@@ -243,6 +244,7 @@
 #define IDS_APPLICATION_TASK            32870
 #define IDS_APPLICATION_STATUS          32871
 #define IDS_DEBUG_CHANNEL               32872
+#define IDS_SERVERCALLS                 32873
 #define IDC_STATIC                      -1
 
 /*
@@ -316,6 +316,7 @@ static void LoadSettings(void)
     HKEY    hKey;
     int     i;
     DWORD   dwSize;
+    TASKMANAGER_SETTINGS settings;
 
    static const WCHAR    wszSubKey[] = {'S','o','f','t','w','a','r','e','\\',
                                         'W','i','n','e','\\','T','a','s','k','M','a','n','a','g','e','r',0};
@@ -372,8 +373,9 @@ static void LoadSettings(void)
     TaskManagerSettings.Column_IOWriteBytes = FALSE;
     TaskManagerSettings.Column_IOOther = FALSE;
     TaskManagerSettings.Column_IOOtherBytes = FALSE;
+    TaskManagerSettings.Column_ServerCalls = FALSE;
 
-    for (i = 0; i < 25; i++) {
+    for (i = 0; i < 26; i++) {
         TaskManagerSettings.ColumnOrderArray[i] = i;
     }
     TaskManagerSettings.ColumnSizeArray[0] = 105;
@@ -401,6 +403,7 @@ static void LoadSettings(void)
     TaskManagerSettings.ColumnSizeArray[22] = 70;
     TaskManagerSettings.ColumnSizeArray[23] = 70;
     TaskManagerSettings.ColumnSizeArray[24] = 70;
+    TaskManagerSettings.ColumnSizeArray[25] = 70;
 
     TaskManagerSettings.SortColumn = 1;
     TaskManagerSettings.SortAscending = TRUE;
@@ -413,9 +416,11 @@ static void LoadSettings(void)
     /* @@ Wine registry key: HKCU\Software\Wine\TaskManager */
     if (RegOpenKeyExW(HKEY_CURRENT_USER, wszSubKey, 0, KEY_READ, &hKey) != ERROR_SUCCESS)
         return;
-    /* Read the settings */
+    /* Read the settings, ignoring them if they were saved with a different layout */
     dwSize = sizeof(TASKMANAGER_SETTINGS);
-    RegQueryValueExW(hKey, wszPreferences, NULL, NULL, (LPBYTE)&TaskManagerSettings, &dwSize);
+    if (!RegQueryValueExW(hKey, wszPreferences, NULL, NULL, (LPBYTE)&settings, &dwSize) &&
+        dwSize == sizeof(TASKMANAGER_SETTINGS))
+        TaskManagerSettings = settings;
 
     /* Close the key */
     RegCloseKey(hKey);
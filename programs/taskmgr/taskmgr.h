@@ -102,8 +102,9 @@ typedef struct
 	BOOL	Column_IOWriteBytes;
 	BOOL	Column_IOOther;
 	BOOL	Column_IOOtherBytes;
-	int	ColumnOrderArray[25];
-	int	ColumnSizeArray[25];
+	BOOL	Column_ServerCalls;
+	int	ColumnOrderArray[26];
+	int	ColumnSizeArray[26];
 	int	SortColumn;
 	BOOL	SortAscending;
 
@@ -54,6 +54,7 @@ static void usage( FILE *fh )
     fprintf(fh, "   -h,    --help            display this help message\n");
     fprintf(fh, "   -k[n], --kill[=n]        kill the current wineserver, optionally with signal n\n");
     fprintf(fh, "   -p[n], --persistent[=n]  make server persistent, optionally for n seconds\n");
+    fprintf(fh, "   -s,    --stats           print the request statistics of the current wineserver\n");
     fprintf(fh, "   -v,    --version         display version information and exit\n");
     fprintf(fh, "   -w,    --wait            wait until the current wineserver terminates\n");
     fprintf(fh, "\n");
@@ -70,6 +71,7 @@ static void parse_args( int argc, char *argv[] )
         {"help",        0, NULL, 'h'},
         {"kill",        2, NULL, 'k'},
         {"persistent",  2, NULL, 'p'},
+        {"stats",       0, NULL, 's'},
         {"version",     0, NULL, 'v'},
         {"wait",        0, NULL, 'w'},
         { NULL,         0, NULL, 0}
@@ -77,7 +79,7 @@ static void parse_args( int argc, char *argv[] )
 
     server_argv0 = argv[0];
 
-    while ((optc = getopt_long( argc, argv, "d::fhk::p::vw", long_options, NULL )) != -1)
+    while ((optc = getopt_long( argc, argv, "d::fhk::p::svw", long_options, NULL )) != -1)
     {
         switch(optc)
         {
@@ -106,6 +108,8 @@ static void parse_args( int argc, char *argv[] )
                 else
                     master_socket_timeout = TIMEOUT_INFINITE;
                 break;
+            case 's':
+                exit( !print_request_stats() );
             case 'v':
                 fprintf( stderr, "%s\n", PACKAGE_STRING );
                 exit(0);
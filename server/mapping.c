@@ -122,6 +122,45 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* copy of a PE image relocated to a given address, shared by all processes loading it there */
+struct image_cache
+{
+    struct list          entry;      /* entry in global image cache list */
+    dev_t                dev;        /* device of the PE file */
+    ino_t                ino;        /* inode of the PE file */
+    time_t               mtime;      /* modification time of the PE file */
+    file_pos_t           file_size;  /* size of the PE file */
+    client_ptr_t         base;       /* address the image is relocated to */
+    struct file         *file;       /* temp file holding the relocated image, NULL until built */
+    struct image_build  *build;      /* state of the copy while it is being built */
+};
+
+/* relocated copy of an image being built from the PE file, one step at a time */
+struct image_build
+{
+    struct fd            *source;     /* fd of the PE file */
+    struct timeout_user  *timeout;    /* timeout for the next build step */
+    int                   fd;         /* unix fd of the temp file */
+    char                 *ptr;        /* mapping of the temp file */
+    size_t                size;       /* size of the image */
+    IMAGE_SECTION_HEADER *sec;        /* section headers */
+    unsigned int          nb_sec;     /* number of sections */
+    unsigned int          cur_sec;    /* section being copied */
+    size_t                sec_pos;    /* amount of the current section already copied */
+    IMAGE_DATA_DIRECTORY  relocs;     /* base relocations directory */
+    size_t                reloc_pos;  /* position of the next relocation block */
+    long long             delta;      /* difference between the load address and the preferred base */
+    int                   is_64bit;   /* whether the image is a 64-bit one */
+    size_t                base_pos;   /* position of OptionalHeader.ImageBase in the image */
+};
+
+static struct list image_cache_list = LIST_INIT( image_cache_list );
+static unsigned int image_cache_count;
+
+#define MAX_IMAGE_CACHE_COUNT 64                  /* max number of cached images */
+#define MAX_IMAGE_CACHE_SIZE  (64 * 1024 * 1024)  /* max size of a cached image */
+#define IMAGE_CACHE_STEP_SIZE (1024 * 1024)       /* amount of image built in each step */
+
 /* memory view mapped in client address space */
 struct memory_view
 {
@@ -530,6 +569,270 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     return 0;
 }
 
+/* check whether an image is worth caching when relocated to the given base */
+static int is_image_cacheable( struct mapping *mapping, client_ptr_t base )
+{
+    /* only DLLs that the client would relocate are worth caching */
+    return base && !(base & 0xffff) && base != mapping->image.base &&
+           (mapping->image.image_charact & IMAGE_FILE_DLL) &&
+           !(mapping->image.image_flags & (IMAGE_FLAGS_ImageMappedFlat | IMAGE_FLAGS_ComPlusILOnly)) &&
+           !mapping->shared && mapping->image.map_size <= MAX_IMAGE_CACHE_SIZE;
+}
+
+/* apply a block of base relocations to the copy of an image */
+static int relocate_image_block( char *ptr, size_t size, const IMAGE_BASE_RELOCATION *rel,
+                                 long long delta, int is_64bit )
+{
+    const unsigned short *relocs = (const unsigned short *)(rel + 1);
+    unsigned int i, count = (rel->SizeOfBlock - sizeof(*rel)) / sizeof(*relocs);
+    size_t offset;
+
+    if (rel->VirtualAddress >= size) return 0;
+
+    for (i = 0; i < count; i++)
+    {
+        offset = rel->VirtualAddress + (relocs[i] & 0xfff);
+        switch (relocs[i] >> 12)
+        {
+        case IMAGE_REL_BASED_ABSOLUTE:
+            break;
+        case IMAGE_REL_BASED_HIGH:
+            if (offset + sizeof(short) > size) return 0;
+            *(short *)(ptr + offset) += (unsigned short)(delta >> 16);
+            break;
+        case IMAGE_REL_BASED_LOW:
+            if (offset + sizeof(short) > size) return 0;
+            *(short *)(ptr + offset) += (unsigned short)delta;
+            break;
+        case IMAGE_REL_BASED_HIGHLOW:
+            if (offset + sizeof(int) > size) return 0;
+            *(int *)(ptr + offset) += delta;
+            break;
+        case IMAGE_REL_BASED_DIR64:
+            if (!is_64bit || offset + sizeof(long long) > size) return 0;
+            *(long long *)(ptr + offset) += delta;
+            break;
+        default:
+            return 0;  /* leave it to the client */
+        }
+    }
+    return 1;
+}
+
+static void free_image_build( struct image_build *build )
+{
+    if (build->timeout) remove_timeout_user( build->timeout );
+    if (build->ptr) munmap( build->ptr, build->size );
+    if (build->fd != -1) close( build->fd );
+    release_object( build->source );
+    free( build->sec );
+    free( build );
+}
+
+/* copy the next part of the sections and then of the relocations; return 1 when done */
+static int image_build_step( struct image_build *build, int unix_fd )
+{
+    const IMAGE_BASE_RELOCATION *rel;
+    size_t map_size, file_size, len, done = 0;
+    size_t end = build->relocs.VirtualAddress + build->relocs.Size;
+    off_t file_start;
+
+    while (build->cur_sec < build->nb_sec && done < IMAGE_CACHE_STEP_SIZE)
+    {
+        IMAGE_SECTION_HEADER *sec = &build->sec[build->cur_sec];
+
+        get_section_sizes( sec, &map_size, &file_start, &file_size );
+        if (!sec->PointerToRawData) file_size = 0;
+        len = min( file_size - build->sec_pos, IMAGE_CACHE_STEP_SIZE - done );
+        if (len && pread( unix_fd, build->ptr + sec->VirtualAddress + build->sec_pos,
+                          len, file_start + build->sec_pos ) == -1)
+            return -1;
+        done += len;
+        if ((build->sec_pos += len) < file_size) continue;
+        build->cur_sec++;
+        build->sec_pos = 0;
+    }
+
+    while (build->cur_sec == build->nb_sec && done < IMAGE_CACHE_STEP_SIZE)
+    {
+        if (build->reloc_pos + sizeof(*rel) >= end) return 1;
+        rel = (const IMAGE_BASE_RELOCATION *)(build->ptr + build->reloc_pos);
+        if (!rel->SizeOfBlock) return 1;
+        if (rel->SizeOfBlock < sizeof(*rel) || rel->SizeOfBlock > end - build->reloc_pos) return -1;
+        if (!relocate_image_block( build->ptr, build->size, rel, build->delta, build->is_64bit )) return -1;
+        build->reloc_pos += rel->SizeOfBlock;
+        done += 4096;  /* a block covers at most a page */
+    }
+    return 0;
+}
+
+static void image_build_timeout( void *private );
+
+/* build the next part of a cached image, and publish it once complete */
+static void build_image_cache( struct image_cache *cache )
+{
+    struct image_build *build = cache->build;
+    struct stat st;
+    int unix_fd, ret = -1;
+
+    if ((unix_fd = get_unix_fd( build->source )) != -1) ret = image_build_step( build, unix_fd );
+
+    if (!ret)
+    {
+        if ((build->timeout = add_timeout_user( 0, image_build_timeout, cache ))) return;
+        ret = -1;
+    }
+    if (ret == 1 && fstat( unix_fd, &st ) != -1 && st.st_mtime == cache->mtime && st.st_size == cache->file_size)
+    {
+        if (build->is_64bit) *(unsigned long long *)(build->ptr + build->base_pos) = cache->base;
+        else *(unsigned int *)(build->ptr + build->base_pos) = cache->base;
+        munmap( build->ptr, build->size );
+        build->ptr = NULL;
+        if ((cache->file = create_file_for_fd( build->fd, FILE_GENERIC_READ, 0 ))) build->fd = -1;
+    }
+    free_image_build( build );
+    cache->build = NULL;  /* a null file now records that the copy could not be built */
+}
+
+static void image_build_timeout( void *private )
+{
+    struct image_cache *cache = private;
+
+    cache->build->timeout = NULL;
+    build_image_cache( cache );
+}
+
+/* start building a copy of an image relocated to the given base, laid out as the client would map it */
+static struct image_build *start_image_build( struct mapping *mapping, int unix_fd, file_pos_t file_size,
+                                              client_ptr_t base )
+{
+    static const unsigned int sector_align = 0x1ff;
+
+    IMAGE_DOS_HEADER dos;
+    struct
+    {
+        DWORD Signature;
+        IMAGE_FILE_HEADER FileHeader;
+        union
+        {
+            IMAGE_OPTIONAL_HEADER32 hdr32;
+            IMAGE_OPTIONAL_HEADER64 hdr64;
+        } opt;
+    } *nt;
+    struct image_build *build;
+    size_t header_size, map_size, sec_file_size;
+    off_t pos, file_start;
+    unsigned int i;
+
+    if (pread( unix_fd, &dos, sizeof(dos), 0 ) != sizeof(dos)) return NULL;
+    pos = dos.e_lfanew;
+    header_size = min( mapping->image.header_size, file_size );
+    if (header_size > mapping->image.map_size || pos < 0 || pos + sizeof(*nt) > header_size) return NULL;
+
+    if (!(build = mem_alloc( sizeof(*build) ))) return NULL;
+    memset( build, 0, sizeof(*build) );
+    build->source = (struct fd *)grab_object( mapping->fd );
+    build->size   = mapping->image.map_size;
+    if ((build->fd = create_temp_file( build->size )) == -1) goto error;
+    if ((build->ptr = mmap( NULL, build->size, PROT_READ | PROT_WRITE, MAP_SHARED, build->fd, 0 )) == MAP_FAILED)
+    {
+        build->ptr = NULL;
+        goto error;
+    }
+
+    if (pread( unix_fd, build->ptr, header_size, 0 ) != header_size) goto error;
+    nt = (void *)(build->ptr + pos);
+    if (nt->FileHeader.Characteristics & IMAGE_FILE_RELOCS_STRIPPED) goto error;
+    build->is_64bit = (nt->opt.hdr32.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC);
+    if (build->is_64bit)
+    {
+        build->relocs   = nt->opt.hdr64.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+        build->delta    = base - nt->opt.hdr64.ImageBase;
+        build->base_pos = (char *)&nt->opt.hdr64.ImageBase - build->ptr;
+    }
+    else
+    {
+        build->relocs   = nt->opt.hdr32.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+        build->delta    = base - nt->opt.hdr32.ImageBase;
+        build->base_pos = (char *)&nt->opt.hdr32.ImageBase - build->ptr;
+    }
+    if (!build->relocs.Size || !build->relocs.VirtualAddress) goto error;
+    if (build->relocs.VirtualAddress >= build->size ||
+        build->relocs.Size > build->size - build->relocs.VirtualAddress) goto error;
+    build->reloc_pos = build->relocs.VirtualAddress;
+
+    build->nb_sec = nt->FileHeader.NumberOfSections;
+    pos += sizeof(nt->Signature) + sizeof(nt->FileHeader) + nt->FileHeader.SizeOfOptionalHeader;
+    if (pos + build->nb_sec * sizeof(*build->sec) > header_size) goto error;
+    if (!(build->sec = memdup( build->ptr + pos, build->nb_sec * sizeof(*build->sec) ))) goto error;
+
+    /* same checks as the client-side image mapping */
+    for (i = 0; i < build->nb_sec; i++)
+    {
+        get_section_sizes( &build->sec[i], &map_size, &file_start, &sec_file_size );
+        if (build->sec[i].VirtualAddress > build->size ||
+            map_size > build->size - build->sec[i].VirtualAddress) goto error;
+        if (!build->sec[i].PointerToRawData || !sec_file_size) continue;
+        if (build->sec[i].PointerToRawData >= file_size ||
+            file_start + sec_file_size > ((file_size + sector_align) & ~sector_align))
+            goto error;
+    }
+    return build;
+
+error:
+    free_image_build( build );
+    return NULL;
+}
+
+/* find the relocated copy of an image; a null base returns the most recent usable one */
+static struct image_cache *find_image_cache( const struct stat *st, client_ptr_t base )
+{
+    struct image_cache *cache;
+
+    LIST_FOR_EACH_ENTRY( cache, &image_cache_list, struct image_cache, entry )
+    {
+        if (cache->dev != st->st_dev || cache->ino != st->st_ino) continue;
+        if (cache->mtime != st->st_mtime || cache->file_size != st->st_size) continue;
+        if (base ? cache->base != base : !cache->file) continue;
+        list_remove( &cache->entry );
+        list_add_head( &image_cache_list, &cache->entry );
+        return cache;
+    }
+    return NULL;
+}
+
+/* add a cache entry for an image relocated to the given base, and start building the copy */
+static void add_image_cache( struct mapping *mapping, int unix_fd, const struct stat *st, client_ptr_t base )
+{
+    struct image_cache *cache;
+
+    if (!(cache = mem_alloc( sizeof(*cache) ))) return;
+    cache->dev       = st->st_dev;
+    cache->ino       = st->st_ino;
+    cache->mtime     = st->st_mtime;
+    cache->file_size = st->st_size;
+    cache->base      = base;
+    cache->file      = NULL;
+    cache->build     = start_image_build( mapping, unix_fd, st->st_size, base );
+    list_add_head( &image_cache_list, &cache->entry );
+
+    if (cache->build && !(cache->build->timeout = add_timeout_user( 0, image_build_timeout, cache )))
+    {
+        free_image_build( cache->build );
+        cache->build = NULL;
+    }
+
+    if (++image_cache_count > MAX_IMAGE_CACHE_COUNT)
+    {
+        struct image_cache *old = LIST_ENTRY( list_tail( &image_cache_list ), struct image_cache, entry );
+        list_remove( &old->entry );
+        if (old->build) free_image_build( old->build );
+        if (old->file) release_object( old->file );
+        free( old );
+        image_cache_count--;
+    }
+}
+
 /* load the CLR header from its section */
 static int load_clr_header( IMAGE_COR20_HEADER *hdr, size_t va, size_t size, int unix_fd,
                             IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
@@ -957,6 +1260,30 @@ int get_page_size(void)
     return page_mask + 1;
 }
 
+/* retrieve the size of the host huge pages, used as the large page minimum */
+static ULONG get_large_page_size(void)
+{
+#ifdef linux
+    FILE *f;
+    char line[256];
+    unsigned long value;
+
+    if ((f = fopen( "/proc/meminfo", "r" )))
+    {
+        while (fgets( line, sizeof(line), f ))
+        {
+            if (sscanf( line, "Hugepagesize: %lu", &value ) == 1 && value)
+            {
+                fclose( f );
+                return value * 1024;
+            }
+        }
+        fclose( f );
+    }
+#endif
+    return 2 * 1024 * 1024;
+}
+
 struct object *create_user_data_mapping( struct object *root, const struct unicode_str *name,
                                         unsigned int attr, const struct security_descriptor *sd )
 {
@@ -970,6 +1297,24 @@ struct object *create_user_data_mapping( struct object *root, const struct unico
     {
         user_shared_data = ptr;
         user_shared_data->SystemCallPad[0] = 1;
+        user_shared_data->LargePageMinimum = get_large_page_size();
+    }
+    return &mapping->obj;
+}
+
+/* create an anonymous mapping that the server keeps mapped for writing */
+struct object *create_shared_mapping( mem_size_t size, void **ptr )
+{
+    struct mapping *mapping;
+
+    if (!(mapping = create_mapping( NULL, NULL, 0, size, SEC_COMMIT, 0,
+                                    FILE_READ_DATA | FILE_WRITE_DATA, NULL ))) return NULL;
+    *ptr = mmap( NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, get_unix_fd( mapping->fd ), 0 );
+    if (*ptr == MAP_FAILED)
+    {
+        release_object( mapping );
+        set_error( STATUS_NO_MEMORY );
+        return NULL;
     }
     return &mapping->obj;
 }
@@ -1033,6 +1378,40 @@ DECL_HANDLER(get_mapping_info)
     release_object( mapping );
 }
 
+/* get a copy of an image mapping relocated to a given address */
+DECL_HANDLER(get_image_cache)
+{
+    struct mapping *mapping;
+    struct image_cache *cache;
+    struct stat st;
+    int unix_fd;
+
+    if (!(mapping = get_mapping_obj( current->process, req->mapping, SECTION_MAP_READ ))) return;
+
+    if (!(mapping->flags & SEC_IMAGE)) set_error( STATUS_INVALID_PARAMETER );
+    else if ((unix_fd = get_unix_fd( mapping->fd )) == -1) ;
+    else if (fstat( unix_fd, &st ) == -1) file_set_error();
+    else if ((cache = find_image_cache( &st, req->base )))
+    {
+        if (cache->file)
+        {
+            reply->base = cache->base;
+            if (req->base) reply->file = alloc_handle( current->process, cache->file, FILE_GENERIC_READ, 0 );
+        }
+        else if (cache->build) set_error( STATUS_PENDING );
+        else set_error( STATUS_NOT_SUPPORTED );
+    }
+    else if (!req->base) set_error( STATUS_NOT_FOUND );
+    else if (!is_image_cacheable( mapping, req->base )) set_error( STATUS_NOT_SUPPORTED );
+    else
+    {
+        /* the copy is built from the file in the background, this client maps the image itself */
+        add_image_cache( mapping, unix_fd, &st, req->base );
+        set_error( STATUS_PENDING );
+    }
+    release_object( mapping );
+}
+
 /* add a memory view in the current process */
 DECL_HANDLER(map_view)
 {
@@ -530,6 +530,7 @@ struct process *create_process( int fd, struct process *parent, int inherit_all,
     process->peb             = 0;
     process->ldt_copy        = 0;
     process->dir_cache       = NULL;
+    process->req_stats       = NULL;
     process->winstation      = 0;
     process->desktop         = 0;
     process->token           = NULL;
@@ -628,6 +629,7 @@ static void process_destroy( struct object *obj )
     if (process->id) free_ptid( process->id );
     if (process->token) release_object( process->token );
     free( process->dir_cache );
+    free( process->req_stats );
 }
 
 /* dump a process on stdout for debugging purposes */
@@ -760,6 +762,15 @@ struct process *get_process_from_id( process_id_t id )
     return NULL;
 }
 
+/* dump the request statistics of all running processes */
+void dump_all_process_request_stats(void)
+{
+    struct process *process;
+
+    LIST_FOR_EACH_ENTRY( process, &process_list, struct process, entry )
+        dump_process_request_stats( process );
+}
+
 /* get a process from a handle (and increment the refcount) */
 struct process *get_process_from_handle( obj_handle_t handle, unsigned int access )
 {
@@ -1524,6 +1535,32 @@ DECL_HANDLER(get_process_vm_counters)
     release_object( process );
 }
 
+/* retrieve the TEB addresses of the threads of a process */
+DECL_HANDLER(get_process_tebs)
+{
+    struct process *process = get_process_from_handle( req->handle, PROCESS_QUERY_LIMITED_INFORMATION );
+    struct thread *thread;
+    client_ptr_t *tebs;
+    data_size_t i = 0, max_count;
+
+    if (!process) return;
+
+    LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
+        if (thread->state != TERMINATED && thread->teb) reply->count++;
+
+    max_count = min( reply->count, get_reply_max_size() / sizeof(*tebs) );
+    if (max_count && (tebs = set_reply_data_size( max_count * sizeof(*tebs) )))
+    {
+        LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
+        {
+            if (thread->state == TERMINATED || !thread->teb) continue;
+            if (i == max_count) break;
+            tebs[i++] = thread->teb;
+        }
+    }
+    release_object( process );
+}
+
 static void set_process_affinity( struct process *process, affinity_t affinity )
 {
     struct thread *thread;
@@ -378,8 +378,9 @@ static struct message *alloc_hardware_message( lparam_t info, struct hw_msg_sour
     return msg;
 }
 
-static int update_desktop_cursor_pos( struct desktop *desktop, int x, int y )
+static int update_desktop_cursor_pos( struct desktop *desktop, int x, int y, unsigned int time, lparam_t info )
 {
+    struct cursor_pos *pos;
     int updated;
 
     x = max( min( x, desktop->cursor.clip.right - 1 ), desktop->cursor.clip.left );
@@ -389,6 +390,15 @@ static int update_desktop_cursor_pos( struct desktop *desktop, int x, int y )
     desktop->cursor.y = y;
     desktop->cursor.last_change = get_tick_count();
 
+    /* keep every position, even when the mouse messages get merged */
+    if (updated)
+    {
+        pos = &desktop->cursor.history[desktop->cursor.history_pos++ % ARRAY_SIZE(desktop->cursor.history)];
+        pos->x    = x;
+        pos->y    = y;
+        pos->time = time ? time : desktop->cursor.last_change;
+        pos->info = info;
+    }
     return updated;
 }
 
@@ -401,7 +411,7 @@ static void set_cursor_pos( struct desktop *desktop, int x, int y )
     if (current->process->rawinput_mouse &&
         current->process->rawinput_mouse->flags & RIDEV_NOLEGACY)
     {
-        update_desktop_cursor_pos( desktop, x, y );
+        update_desktop_cursor_pos( desktop, x, y, 0, 0 );
         return;
     }
 
@@ -1410,7 +1420,7 @@ static void update_desktop_mouse_state( struct desktop *desktop, unsigned int fl
                                         int x, int y, lparam_t wparam )
 {
     if (flags & MOUSEEVENTF_MOVE)
-        update_desktop_cursor_pos( desktop, x, y );
+        update_desktop_cursor_pos( desktop, x, y, 0, 0 );
     if (flags & MOUSEEVENTF_LEFTDOWN)
         update_key_state( desktop, desktop->keystate, WM_LBUTTONDOWN, wparam );
     if (flags & MOUSEEVENTF_LEFTUP)
@@ -1601,7 +1611,9 @@ static void queue_hardware_message( struct desktop *desktop, struct message *msg
     {
         if (msg->msg == WM_MOUSEMOVE)
         {
-            if (update_desktop_cursor_pos( desktop, msg->x, msg->y )) always_queue = 1;
+            struct hardware_msg_data *data = msg->data;
+            if (update_desktop_cursor_pos( desktop, msg->x, msg->y, msg->time, data->info ))
+                always_queue = 1;
         }
         if (desktop->keystate[VK_LBUTTON] & 0x80)  msg->wparam |= MK_LBUTTON;
         if (desktop->keystate[VK_MBUTTON] & 0x80)  msg->wparam |= MK_MBUTTON;
@@ -3376,6 +3388,26 @@ DECL_HANDLER(set_cursor)
     reply->last_change = input->desktop->cursor.last_change;
 }
 
+/* retrieve the history of the cursor positions */
+DECL_HANDLER(get_cursor_history)
+{
+    struct desktop *desktop;
+    struct cursor_pos *pos;
+    unsigned int i, count;
+
+    if (!(desktop = get_thread_desktop( current, 0 ))) return;
+
+    count = min( desktop->cursor.history_pos, ARRAY_SIZE(desktop->cursor.history) );
+    count = min( count, get_reply_max_size() / sizeof(*pos) );
+    if ((pos = set_reply_data_size( count * sizeof(*pos) )))
+    {
+        for (i = 0; i < count; i++)
+            pos[i] = desktop->cursor.history[(desktop->cursor.history_pos - i - 1) %
+                                             ARRAY_SIZE(desktop->cursor.history)];
+    }
+    release_object( desktop );
+}
+
 DECL_HANDLER(update_rawinput_devices)
 {
     const struct rawinput_device *devices = get_req_data();
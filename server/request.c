@@ -294,11 +294,114 @@ static void send_reply( union generic_reply *reply )
         fatal_protocol_error( current, "reply write: %s\n", strerror( errno ));
 }
 
+/* global request statistics */
+static struct request_stat request_stats[REQ_NB_REQUESTS];
+
+/* get a time stamp in nanoseconds for request statistics */
+static inline timeout_t get_stats_clock(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && !defined(__APPLE__)
+    struct timespec ts;
+
+    if (!clock_gettime( CLOCK_MONOTONIC, &ts )) return (timeout_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    return monotonic_counter() * 100;
+}
+
+/* update the statistics of a request */
+static void add_request_stat( struct request_stat *stat, timeout_t time, data_size_t in, data_size_t out )
+{
+    unsigned int bucket = 0;
+    timeout_t t;
+
+    for (t = time >> 8; t && bucket < REQUEST_HISTOGRAM_SIZE - 1; t >>= 1) bucket++;
+    stat->count++;
+    stat->bytes_in += in;
+    stat->bytes_out += out;
+    stat->time += time;
+    stat->histogram[bucket]++;
+}
+
+/* get an upper bound of the handler time of a given percentage of the calls */
+static timeout_t get_request_percentile( const struct request_stat *stat, unsigned int percent )
+{
+    unsigned int i, total = 0, limit = ((unsigned __int64)stat->count * percent + 99) / 100;
+
+    for (i = 0; i < REQUEST_HISTOGRAM_SIZE - 1; i++)
+        if ((total += stat->histogram[i]) >= limit) break;
+    return (timeout_t)1 << (i + 8);
+}
+
+/* compare request statistics by decreasing total time */
+static int compare_request_stats( const void *p1, const void *p2 )
+{
+    const struct request_stat *stat1 = *(const struct request_stat * const *)p1;
+    const struct request_stat *stat2 = *(const struct request_stat * const *)p2;
+
+    if (stat1->time != stat2->time) return stat1->time > stat2->time ? -1 : 1;
+    return stat1->request - stat2->request;
+}
+
+/* dump an array of request statistics */
+static void dump_stats_array( FILE *out, const struct request_stat *stats, unsigned int size )
+{
+    const struct request_stat *sorted[REQ_NB_REQUESTS];
+    unsigned int i, count = 0;
+
+    for (i = 0; i < size && count < REQ_NB_REQUESTS; i++) if (stats[i].count) sorted[count++] = &stats[i];
+    qsort( sorted, count, sizeof(sorted[0]), compare_request_stats );
+
+    fprintf( out, "  %-32s %10s %12s %8s %8s %12s %12s\n",
+             "request", "count", "total(us)", "p50(us)", "p99(us)", "bytes in", "bytes out" );
+    for (i = 0; i < count; i++)
+        fprintf( out, "  %-32s %10u %12llu %8llu %8llu %12llu %12llu\n",
+                 get_req_name( sorted[i]->request ), sorted[i]->count,
+                 (unsigned long long)sorted[i]->time / 1000,
+                 (unsigned long long)get_request_percentile( sorted[i], 50 ) / 1000,
+                 (unsigned long long)get_request_percentile( sorted[i], 99 ) / 1000,
+                 (unsigned long long)sorted[i]->bytes_in, (unsigned long long)sorted[i]->bytes_out );
+}
+
+/* dump the global request statistics to stderr */
+void dump_request_stats(void)
+{
+    fprintf( stderr, "wineserver: request statistics\n" );
+    dump_stats_array( stderr, request_stats, REQ_NB_REQUESTS );
+    dump_all_process_request_stats();
+}
+
+/* dump the request statistics of a process to stderr */
+void dump_process_request_stats( struct process *process )
+{
+    if (!process->req_stats) return;
+    fprintf( stderr, "wineserver: request statistics for process %04x\n", process->id );
+    dump_stats_array( stderr, process->req_stats, REQ_NB_REQUESTS );
+}
+
+/* account for a request in the global and per-process statistics */
+static void update_request_stats( enum request req, struct process *process, timeout_t time,
+                                  data_size_t in, data_size_t out )
+{
+    request_stats[req].request = req;
+    add_request_stat( &request_stats[req], time, in, out );
+    if (!process) return;
+    if (!process->req_stats)
+    {
+        unsigned int i;
+
+        if (!(process->req_stats = calloc( REQ_NB_REQUESTS, sizeof(*process->req_stats) ))) return;
+        for (i = 0; i < REQ_NB_REQUESTS; i++) process->req_stats[i].request = i;
+    }
+    add_request_stat( &process->req_stats[req], time, in, out );
+}
+
 /* call a request handler */
 static void call_req_handler( struct thread *thread )
 {
     union generic_reply reply;
     enum request req = thread->req.request_header.req;
+    data_size_t in = sizeof(thread->req) + thread->req.request_header.request_size;
+    timeout_t start;
 
     current = thread;
     current->reply_size = 0;
@@ -308,7 +411,12 @@ static void call_req_handler( struct thread *thread )
     if (debug_level) trace_request();
 
     if (req < REQ_NB_REQUESTS)
+    {
+        start = get_stats_clock();
         req_handlers[req]( &current->req, &reply );
+        update_request_stats( req, current ? current->process : NULL, get_stats_clock() - start,
+                              in, current ? sizeof(reply) + current->reply_size : 0 );
+    }
     else
         set_error( STATUS_NOT_IMPLEMENTED );
 
@@ -330,6 +438,31 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
+/* retrieve the server request statistics */
+DECL_HANDLER(get_request_stats)
+{
+    const struct request_stat *stats = request_stats;
+    struct request_stat *data;
+    struct process *process = NULL;
+    unsigned int i, count = 0;
+
+    if (req->pid)
+    {
+        if (!(process = get_process_from_id( req->pid ))) return;
+        stats = process->req_stats;
+    }
+    if (stats)
+    {
+        for (i = 0; i < REQ_NB_REQUESTS; i++) if (stats[i].count) count++;
+        if (count * sizeof(*data) > get_reply_max_size()) set_error( STATUS_BUFFER_TOO_SMALL );
+        else if ((data = set_reply_data_size( count * sizeof(*data) )))
+        {
+            for (i = 0; i < REQ_NB_REQUESTS; i++) if (stats[i].count) *data++ = stats[i];
+        }
+    }
+    if (process) release_object( process );
+}
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
@@ -796,6 +929,189 @@ int kill_lock_owner( int sig )
     return ret;
 }
 
+/* send an fd to the server when acting as a client */
+static int send_server_fd( int socket_fd, int fd )
+{
+    struct send_fd data;
+    struct msghdr msghdr;
+    struct iovec vec;
+
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    msghdr.msg_accrights    = (void *)&fd;
+    msghdr.msg_accrightslen = sizeof(fd);
+#else  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+    char cmsg_buffer[256];
+    struct cmsghdr *cmsg;
+    msghdr.msg_control    = cmsg_buffer;
+    msghdr.msg_controllen = sizeof(cmsg_buffer);
+    msghdr.msg_flags      = 0;
+    cmsg = CMSG_FIRSTHDR( &msghdr );
+    cmsg->cmsg_len   = CMSG_LEN( sizeof(fd) );
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    *(int *)CMSG_DATA(cmsg) = fd;
+    msghdr.msg_controllen = cmsg->cmsg_len;
+#endif  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+
+    msghdr.msg_name    = NULL;
+    msghdr.msg_namelen = 0;
+    msghdr.msg_iov     = &vec;
+    msghdr.msg_iovlen  = 1;
+
+    vec.iov_base = (void *)&data;
+    vec.iov_len  = sizeof(data);
+
+    data.tid = 0;  /* first thread of the process */
+    data.fd  = fd;
+
+    return sendmsg( socket_fd, &msghdr, 0 ) == sizeof(data) ? 0 : -1;
+}
+
+/* receive the request fd from the server when acting as a client */
+static int receive_server_fd( int socket_fd, obj_handle_t *handle )
+{
+    struct msghdr msghdr;
+    struct iovec vec;
+    int fd = -1;
+
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    msghdr.msg_accrights    = (void *)&fd;
+    msghdr.msg_accrightslen = sizeof(fd);
+#else  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+    char cmsg_buffer[256];
+    struct cmsghdr *cmsg;
+    msghdr.msg_control    = cmsg_buffer;
+    msghdr.msg_controllen = sizeof(cmsg_buffer);
+    msghdr.msg_flags      = 0;
+#endif  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+
+    msghdr.msg_name    = NULL;
+    msghdr.msg_namelen = 0;
+    msghdr.msg_iov     = &vec;
+    msghdr.msg_iovlen  = 1;
+
+    vec.iov_base = (void *)handle;
+    vec.iov_len  = sizeof(*handle);
+
+    if (recvmsg( socket_fd, &msghdr, 0 ) != sizeof(*handle)) return -1;
+#ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    for (cmsg = CMSG_FIRSTHDR( &msghdr ); cmsg; cmsg = CMSG_NXTHDR( &msghdr, cmsg ))
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) fd = *(int *)CMSG_DATA(cmsg);
+#endif
+    return fd;
+}
+
+/* read the whole of a server reply */
+static int read_server_reply( int fd, void *buffer, size_t size )
+{
+    ssize_t ret;
+
+    while (size)
+    {
+        if ((ret = read( fd, buffer, size )) > 0)
+        {
+            buffer = (char *)buffer + ret;
+            size -= ret;
+        }
+        else if (!ret || errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+/* send a request to the server when acting as a client, and wait for the reply */
+static unsigned int call_server( int request_fd, int reply_fd, union generic_request *req,
+                                 void *data, data_size_t size )
+{
+    union generic_reply reply;
+
+    req->request_header.request_size = 0;
+    req->request_header.reply_size = size;
+    if (write( request_fd, req, sizeof(*req) ) != sizeof(*req)) return STATUS_PIPE_DISCONNECTED;
+    if (read_server_reply( reply_fd, &reply, sizeof(reply) )) return STATUS_PIPE_DISCONNECTED;
+    if (reply.reply_header.reply_size > size) return STATUS_INVALID_PARAMETER;
+    if (read_server_reply( reply_fd, data, reply.reply_header.reply_size )) return STATUS_PIPE_DISCONNECTED;
+    return reply.reply_header.error;
+}
+
+/* connect to the running server and print its request statistics on stdout */
+int print_request_stats(void)
+{
+    static struct request_stat stats[REQ_NB_REQUESTS];
+    union generic_request req;
+    struct sockaddr_un addr;
+    unsigned int status, cpu_mask;
+    int socket_fd, request_fd = -1, reply_pipe[2] = { -1, -1 }, wait_pipe[2] = { -1, -1 }, slen, ret = 0;
+    enum cpu_type cpu;
+    obj_handle_t version;
+
+    server_dir = create_server_dir( 0 );
+    if (!server_dir) return 0;  /* no server dir, so no server */
+
+    signal( SIGPIPE, SIG_IGN );
+
+    if ((socket_fd = socket( AF_UNIX, SOCK_STREAM, 0 )) == -1) return 0;
+    addr.sun_family = AF_UNIX;
+    strcpy( addr.sun_path, server_socket_name );
+    slen = sizeof(addr) - sizeof(addr.sun_path) + strlen(addr.sun_path) + 1;
+#ifdef HAVE_STRUCT_SOCKADDR_UN_SUN_LEN
+    addr.sun_len = slen;
+#endif
+    if (connect( socket_fd, (struct sockaddr *)&addr, slen ) == -1) goto done;
+
+    if ((request_fd = receive_server_fd( socket_fd, &version )) == -1) goto done;
+    if (version != SERVER_PROTOCOL_VERSION)
+    {
+        fprintf( stderr, "wineserver: version mismatch %u/%u\n", version, SERVER_PROTOCOL_VERSION );
+        goto done;
+    }
+
+    if (pipe( reply_pipe ) == -1 || pipe( wait_pipe ) == -1) goto done;
+    if (send_server_fd( socket_fd, reply_pipe[1] ) == -1) goto done;
+    if (send_server_fd( socket_fd, wait_pipe[1] ) == -1) goto done;
+    /* keep only the server copies, so that reads fail if the server goes away */
+    close( reply_pipe[1] );
+    close( wait_pipe[1] );
+
+    /* the prefix isn't known here, so only the 32-bit cpus are returned, which
+     * are accepted by the server with any prefix */
+    cpu_mask = get_supported_cpu_mask();
+    for (cpu = CPU_x86; cpu < CPU_ARM64; cpu++) if (cpu_mask & CPU_FLAG(cpu)) break;
+
+    memset( &req, 0, sizeof(req) );
+    req.init_thread_request.__header.req = REQ_init_thread;
+    req.init_thread_request.unix_pid = getpid();
+    req.init_thread_request.unix_tid = -1;
+    req.init_thread_request.teb      = (unsigned long)&stats;  /* there's no teb, any valid address will do */
+    req.init_thread_request.reply_fd = reply_pipe[1];
+    req.init_thread_request.wait_fd  = wait_pipe[1];
+    req.init_thread_request.cpu      = cpu;
+    if ((status = call_server( request_fd, reply_pipe[0], &req, NULL, 0 )))
+    {
+        fprintf( stderr, "wineserver: init_thread failed with status %x\n", status );
+        goto done;
+    }
+
+    memset( &req, 0, sizeof(req) );
+    req.get_request_stats_request.__header.req = REQ_get_request_stats;
+    req.get_request_stats_request.pid = 0;
+    if ((status = call_server( request_fd, reply_pipe[0], &req, stats, sizeof(stats) )))
+    {
+        fprintf( stderr, "wineserver: get_request_stats failed with status %x\n", status );
+        goto done;
+    }
+
+    printf( "wineserver: request statistics\n" );
+    dump_stats_array( stdout, stats, REQ_NB_REQUESTS );
+    ret = 1;
+
+done:
+    if (request_fd != -1) close( request_fd );
+    if (reply_pipe[0] != -1) close( reply_pipe[0] );
+    if (wait_pipe[0] != -1) close( wait_pipe[0] );
+    close( socket_fd );
+    return ret;
+}
+
 /* acquire the main server lock */
 static void acquire_lock(void)
 {
@@ -60,11 +60,15 @@ extern void close_master_socket( timeout_t timeout );
 extern void shutdown_master_socket(void);
 extern int wait_for_lock(void);
 extern int kill_lock_owner( int sig );
+extern int print_request_stats(void);
 extern char *server_dir;
 extern int server_dir_fd, config_dir_fd;
 
 extern void trace_request(void);
 extern void trace_reply( enum request req, const union generic_reply *reply );
+extern const char *get_req_name( enum request req );
+extern void dump_request_stats(void);
+extern void dump_process_request_stats( struct process *process );
 
 /* get current tick count to return to client */
 static inline unsigned int get_tick_count(void)
@@ -130,6 +134,7 @@ DECL_HANDLER(terminate_process);
 DECL_HANDLER(terminate_thread);
 DECL_HANDLER(get_process_info);
 DECL_HANDLER(get_process_vm_counters);
+DECL_HANDLER(get_process_tebs);
 DECL_HANDLER(set_process_info);
 DECL_HANDLER(get_thread_info);
 DECL_HANDLER(get_thread_times);
@@ -209,6 +214,7 @@ DECL_HANDLER(read_change);
 DECL_HANDLER(create_mapping);
 DECL_HANDLER(open_mapping);
 DECL_HANDLER(get_mapping_info);
+DECL_HANDLER(get_image_cache);
 DECL_HANDLER(map_view);
 DECL_HANDLER(unmap_view);
 DECL_HANDLER(get_mapping_file);
@@ -286,6 +292,7 @@ DECL_HANDLER(get_desktop_window);
 DECL_HANDLER(set_window_owner);
 DECL_HANDLER(get_window_info);
 DECL_HANDLER(set_window_info);
+DECL_HANDLER(get_shared_window_table);
 DECL_HANDLER(set_parent);
 DECL_HANDLER(get_window_parents);
 DECL_HANDLER(get_window_children);
@@ -415,6 +422,7 @@ DECL_HANDLER(set_window_layered_info);
 DECL_HANDLER(alloc_user_handle);
 DECL_HANDLER(free_user_handle);
 DECL_HANDLER(set_cursor);
+DECL_HANDLER(get_cursor_history);
 DECL_HANDLER(get_rawinput_devices);
 DECL_HANDLER(update_rawinput_devices);
 DECL_HANDLER(create_job);
@@ -427,6 +435,7 @@ DECL_HANDLER(terminate_job);
 DECL_HANDLER(suspend_process);
 DECL_HANDLER(resume_process);
 DECL_HANDLER(get_system_info);
+DECL_HANDLER(get_request_stats);
 
 #ifdef WANT_REQUEST_HANDLERS
 
@@ -444,6 +453,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_terminate_thread,
     (req_handler)req_get_process_info,
     (req_handler)req_get_process_vm_counters,
+    (req_handler)req_get_process_tebs,
     (req_handler)req_set_process_info,
     (req_handler)req_get_thread_info,
     (req_handler)req_get_thread_times,
@@ -523,6 +533,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_create_mapping,
     (req_handler)req_open_mapping,
     (req_handler)req_get_mapping_info,
+    (req_handler)req_get_image_cache,
     (req_handler)req_map_view,
     (req_handler)req_unmap_view,
     (req_handler)req_get_mapping_file,
@@ -600,6 +611,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_window_owner,
     (req_handler)req_get_window_info,
     (req_handler)req_set_window_info,
+    (req_handler)req_get_shared_window_table,
     (req_handler)req_set_parent,
     (req_handler)req_get_window_parents,
     (req_handler)req_get_window_children,
@@ -729,6 +741,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_alloc_user_handle,
     (req_handler)req_free_user_handle,
     (req_handler)req_set_cursor,
+    (req_handler)req_get_cursor_history,
     (req_handler)req_get_rawinput_devices,
     (req_handler)req_update_rawinput_devices,
     (req_handler)req_create_job,
@@ -741,6 +754,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_suspend_process,
     (req_handler)req_resume_process,
     (req_handler)req_get_system_info,
+    (req_handler)req_get_request_stats,
 };
 
 C_ASSERT( sizeof(abstime_t) == 8 );
@@ -864,6 +878,10 @@ C_ASSERT( FIELD_OFFSET(struct get_process_vm_counters_reply, working_set_size) =
 C_ASSERT( FIELD_OFFSET(struct get_process_vm_counters_reply, pagefile_usage) == 40 );
 C_ASSERT( FIELD_OFFSET(struct get_process_vm_counters_reply, peak_pagefile_usage) == 48 );
 C_ASSERT( sizeof(struct get_process_vm_counters_reply) == 56 );
+C_ASSERT( FIELD_OFFSET(struct get_process_tebs_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_process_tebs_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_process_tebs_reply, count) == 8 );
+C_ASSERT( sizeof(struct get_process_tebs_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_process_info_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_process_info_request, mask) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_process_info_request, priority) == 20 );
@@ -1346,6 +1364,12 @@ C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, size) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, flags) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, shared_file) == 20 );
 C_ASSERT( sizeof(struct get_mapping_info_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_image_cache_request, mapping) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_image_cache_request, base) == 16 );
+C_ASSERT( sizeof(struct get_image_cache_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_image_cache_reply, base) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_image_cache_reply, file) == 16 );
+C_ASSERT( sizeof(struct get_image_cache_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, mapping) == 12 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, base) == 24 );
@@ -1772,6 +1796,9 @@ C_ASSERT( FIELD_OFFSET(struct set_window_info_reply, old_user_data) == 24 );
 C_ASSERT( FIELD_OFFSET(struct set_window_info_reply, old_extra_value) == 32 );
 C_ASSERT( FIELD_OFFSET(struct set_window_info_reply, old_id) == 40 );
 C_ASSERT( sizeof(struct set_window_info_reply) == 48 );
+C_ASSERT( sizeof(struct get_shared_window_table_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_window_table_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_shared_window_table_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_parent_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_parent_request, parent) == 16 );
 C_ASSERT( sizeof(struct set_parent_request) == 24 );
@@ -2484,6 +2511,8 @@ C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, new_y) == 28 );
 C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, new_clip) == 32 );
 C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, last_change) == 48 );
 C_ASSERT( sizeof(struct set_cursor_reply) == 56 );
+C_ASSERT( sizeof(struct get_cursor_history_request) == 16 );
+C_ASSERT( sizeof(struct get_cursor_history_reply) == 8 );
 C_ASSERT( sizeof(struct get_rawinput_devices_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_rawinput_devices_reply, device_count) == 8 );
 C_ASSERT( sizeof(struct get_rawinput_devices_reply) == 16 );
@@ -2523,6 +2552,9 @@ C_ASSERT( FIELD_OFFSET(struct get_system_info_reply, processes) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_system_info_reply, threads) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_system_info_reply, handles) == 16 );
 C_ASSERT( sizeof(struct get_system_info_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_request_stats_request, pid) == 12 );
+C_ASSERT( sizeof(struct get_request_stats_request) == 16 );
+C_ASSERT( sizeof(struct get_request_stats_reply) == 8 );
 
 #endif  /* WANT_REQUEST_HANDLERS */
 
@@ -41,6 +41,7 @@
 
 #define MAX_SUBAUTH_COUNT 1
 
+const LUID SeLockMemoryPrivilege           = {  4, 0 };
 const LUID SeIncreaseQuotaPrivilege        = {  5, 0 };
 const LUID SeSecurityPrivilege             = {  8, 0 };
 const LUID SeTakeOwnershipPrivilege        = {  9, 0 };
@@ -899,6 +900,7 @@ struct token *token_create_admin( void )
             { SeManageVolumePrivilege        , 0                    },
             { SeImpersonatePrivilege         , SE_PRIVILEGE_ENABLED },
             { SeCreateGlobalPrivilege        , SE_PRIVILEGE_ENABLED },
+            { SeLockMemoryPrivilege          , 0                    },
         };
         /* note: we don't include non-builtin groups here for the user -
          * telling us these is the job of a client-side program */
@@ -1227,6 +1227,44 @@ static void dump_varargs_rawinput_devices(const char *prefix, data_size_t size )
     fputc( '}', stderr );
 }
 
+static void dump_varargs_cursor_positions( const char *prefix, data_size_t size )
+{
+    const struct cursor_pos *pos;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*pos))
+    {
+        pos = cur_data;
+        fprintf( stderr, "{x=%d,y=%d,time=%u", pos->x, pos->y, pos->time );
+        dump_uint64( ",info=", &pos->info );
+        fputc( '}', stderr );
+        size -= sizeof(*pos);
+        remove_data( sizeof(*pos) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
+static void dump_varargs_request_stats( const char *prefix, data_size_t size )
+{
+    const struct request_stat *stat;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*stat))
+    {
+        stat = cur_data;
+        fprintf( stderr, "{request=%u,count=%u", stat->request, stat->count );
+        dump_uint64( ",bytes_in=", &stat->bytes_in );
+        dump_uint64( ",bytes_out=", &stat->bytes_out );
+        dump_uint64( ",time=", (const unsigned __int64 *)&stat->time );
+        fputc( '}', stderr );
+        size -= sizeof(*stat);
+        remove_data( sizeof(*stat) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 static void dump_varargs_handle_infos( const char *prefix, data_size_t size )
 {
     const struct handle_info *handle;
@@ -1409,6 +1447,17 @@ static void dump_get_process_vm_counters_reply( const struct get_process_vm_coun
     dump_uint64( ", peak_pagefile_usage=", &req->peak_pagefile_usage );
 }
 
+static void dump_get_process_tebs_request( const struct get_process_tebs_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_get_process_tebs_reply( const struct get_process_tebs_reply *req )
+{
+    fprintf( stderr, " count=%d", req->count );
+    dump_varargs_uints64( ", tebs=", cur_size );
+}
+
 static void dump_set_process_info_request( const struct set_process_info_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2346,6 +2395,18 @@ static void dump_get_mapping_info_reply( const struct get_mapping_info_reply *re
     dump_varargs_pe_image_info( ", image=", cur_size );
 }
 
+static void dump_get_image_cache_request( const struct get_image_cache_request *req )
+{
+    fprintf( stderr, " mapping=%04x", req->mapping );
+    dump_uint64( ", base=", &req->base );
+}
+
+static void dump_get_image_cache_reply( const struct get_image_cache_reply *req )
+{
+    dump_uint64( " base=", &req->base );
+    fprintf( stderr, ", file=%04x", req->file );
+}
+
 static void dump_map_view_request( const struct map_view_request *req )
 {
     fprintf( stderr, " mapping=%04x", req->mapping );
@@ -3177,6 +3238,15 @@ static void dump_set_window_info_reply( const struct set_window_info_reply *req
     fprintf( stderr, ", old_id=%08x", req->old_id );
 }
 
+static void dump_get_shared_window_table_request( const struct get_shared_window_table_request *req )
+{
+}
+
+static void dump_get_shared_window_table_reply( const struct get_shared_window_table_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_set_parent_request( const struct set_parent_request *req )
 {
     fprintf( stderr, " handle=%08x", req->handle );
@@ -4630,6 +4700,15 @@ static void dump_set_cursor_reply( const struct set_cursor_reply *req )
     fprintf( stderr, ", last_change=%08x", req->last_change );
 }
 
+static void dump_get_cursor_history_request( const struct get_cursor_history_request *req )
+{
+}
+
+static void dump_get_cursor_history_reply( const struct get_cursor_history_reply *req )
+{
+    dump_varargs_cursor_positions( " history=", cur_size );
+}
+
 static void dump_get_rawinput_devices_request( const struct get_rawinput_devices_request *req )
 {
 }
@@ -4721,6 +4800,16 @@ static void dump_get_system_info_reply( const struct get_system_info_reply *req
     fprintf( stderr, ", handles=%08x", req->handles );
 }
 
+static void dump_get_request_stats_request( const struct get_request_stats_request *req )
+{
+    fprintf( stderr, " pid=%04x", req->pid );
+}
+
+static void dump_get_request_stats_reply( const struct get_request_stats_reply *req )
+{
+    dump_varargs_request_stats( " stats=", cur_size );
+}
+
 static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_new_process_request,
     (dump_func)dump_exec_process_request,
@@ -4733,6 +4822,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_terminate_thread_request,
     (dump_func)dump_get_process_info_request,
     (dump_func)dump_get_process_vm_counters_request,
+    (dump_func)dump_get_process_tebs_request,
     (dump_func)dump_set_process_info_request,
     (dump_func)dump_get_thread_info_request,
     (dump_func)dump_get_thread_times_request,
@@ -4812,6 +4902,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_mapping_request,
     (dump_func)dump_open_mapping_request,
     (dump_func)dump_get_mapping_info_request,
+    (dump_func)dump_get_image_cache_request,
     (dump_func)dump_map_view_request,
     (dump_func)dump_unmap_view_request,
     (dump_func)dump_get_mapping_file_request,
@@ -4889,6 +4980,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_window_owner_request,
     (dump_func)dump_get_window_info_request,
     (dump_func)dump_set_window_info_request,
+    (dump_func)dump_get_shared_window_table_request,
     (dump_func)dump_set_parent_request,
     (dump_func)dump_get_window_parents_request,
     (dump_func)dump_get_window_children_request,
@@ -5018,6 +5110,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_alloc_user_handle_request,
     (dump_func)dump_free_user_handle_request,
     (dump_func)dump_set_cursor_request,
+    (dump_func)dump_get_cursor_history_request,
     (dump_func)dump_get_rawinput_devices_request,
     (dump_func)dump_update_rawinput_devices_request,
     (dump_func)dump_create_job_request,
@@ -5030,6 +5123,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_suspend_process_request,
     (dump_func)dump_resume_process_request,
     (dump_func)dump_get_system_info_request,
+    (dump_func)dump_get_request_stats_request,
 };
 
 static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
@@ -5044,6 +5138,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_terminate_thread_reply,
     (dump_func)dump_get_process_info_reply,
     (dump_func)dump_get_process_vm_counters_reply,
+    (dump_func)dump_get_process_tebs_reply,
     NULL,
     (dump_func)dump_get_thread_info_reply,
     (dump_func)dump_get_thread_times_reply,
@@ -5123,6 +5218,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_mapping_reply,
     (dump_func)dump_open_mapping_reply,
     (dump_func)dump_get_mapping_info_reply,
+    (dump_func)dump_get_image_cache_reply,
     NULL,
     NULL,
     (dump_func)dump_get_mapping_file_reply,
@@ -5200,6 +5296,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_window_owner_reply,
     (dump_func)dump_get_window_info_reply,
     (dump_func)dump_set_window_info_reply,
+    (dump_func)dump_get_shared_window_table_reply,
     (dump_func)dump_set_parent_reply,
     (dump_func)dump_get_window_parents_reply,
     (dump_func)dump_get_window_children_reply,
@@ -5329,6 +5426,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_alloc_user_handle_reply,
     NULL,
     (dump_func)dump_set_cursor_reply,
+    (dump_func)dump_get_cursor_history_reply,
     (dump_func)dump_get_rawinput_devices_reply,
     NULL,
     (dump_func)dump_create_job_reply,
@@ -5341,6 +5439,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     NULL,
     (dump_func)dump_get_system_info_reply,
+    (dump_func)dump_get_request_stats_reply,
 };
 
 static const char * const req_names[REQ_NB_REQUESTS] = {
@@ -5355,6 +5454,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "terminate_thread",
     "get_process_info",
     "get_process_vm_counters",
+    "get_process_tebs",
     "set_process_info",
     "get_thread_info",
     "get_thread_times",
@@ -5434,6 +5534,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "create_mapping",
     "open_mapping",
     "get_mapping_info",
+    "get_image_cache",
     "map_view",
     "unmap_view",
     "get_mapping_file",
@@ -5511,6 +5612,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_window_owner",
     "get_window_info",
     "set_window_info",
+    "get_shared_window_table",
     "set_parent",
     "get_window_parents",
     "get_window_children",
@@ -5640,6 +5742,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "alloc_user_handle",
     "free_user_handle",
     "set_cursor",
+    "get_cursor_history",
     "get_rawinput_devices",
     "update_rawinput_devices",
     "create_job",
@@ -5652,6 +5755,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "suspend_process",
     "resume_process",
     "get_system_info",
+    "get_request_stats",
 };
 
 static const struct
@@ -5863,6 +5967,11 @@ void trace_request(void)
     else fprintf( stderr, "%04x: %d(?)\n", current->id, req );
 }
 
+const char *get_req_name( enum request req )
+{
+    return req < REQ_NB_REQUESTS ? req_names[req] : "?";
+}
+
 void trace_reply( enum request req, const union generic_reply *reply )
 {
     if (req < REQ_NB_REQUESTS)
@@ -18,6 +18,18 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
+#include "config.h"
+#include "wine/port.h"
+
+#include <stdarg.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+
+#include "file.h"
+#include "handle.h"
 #include "thread.h"
 #include "user.h"
 #include "request.h"
@@ -34,6 +46,9 @@ static struct user_handle *freelist;
 static int nb_handles;
 static int allocated_handles;
 
+static struct object *shared_window_mapping;  /* mapping of the shared window table */
+static struct shared_window *shared_windows;  /* shared window table, once a client asked for it */
+
 static struct user_handle *handle_to_entry( user_handle_t handle )
 {
     unsigned short generation;
@@ -79,6 +94,41 @@ static inline struct user_handle *alloc_user_entry(void)
     return handle;
 }
 
+/* start updating a shared table entry; the sequence count is odd until the update is done */
+static struct shared_window *begin_shared_entry_update( struct user_handle *ptr )
+{
+    struct shared_window *shared;
+
+    if (!shared_windows) return NULL;
+    shared = &shared_windows[ptr - handles];
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    return shared;
+}
+
+/* finish updating a shared table entry */
+static void end_shared_entry_update( struct shared_window *shared )
+{
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_RELEASE );
+}
+
+/* publish the type and generation of a handle entry in the shared table */
+static void update_shared_entry( struct user_handle *ptr )
+{
+    struct shared_window *shared;
+
+    if (!(shared = begin_shared_entry_update( ptr ))) return;
+    shared->type       = ptr->type;
+    shared->generation = ptr->generation;
+    if (!ptr->type)
+    {
+        shared->tid = shared->pid = 0;
+        shared->style = shared->ex_style = 0;
+        shared->parent = shared->owner = 0;
+    }
+    end_shared_entry_update( shared );
+}
+
 static inline void *free_user_entry( struct user_handle *ptr )
 {
     void *ret;
@@ -86,6 +136,7 @@ static inline void *free_user_entry( struct user_handle *ptr )
     ptr->ptr  = freelist;
     ptr->type = 0;
     freelist  = ptr;
+    update_shared_entry( ptr );
     return ret;
 }
 
@@ -97,9 +148,25 @@ user_handle_t alloc_user_handle( void *ptr, enum user_object type )
     entry->ptr  = ptr;
     entry->type = type;
     if (++entry->generation >= 0xffff) entry->generation = 1;
+    update_shared_entry( entry );
     return entry_to_handle( entry );
 }
 
+/* start updating the shared table entry of a window, return NULL if there is no shared table */
+struct shared_window *begin_shared_window_update( user_handle_t handle )
+{
+    struct user_handle *entry;
+
+    if (!shared_windows || !(entry = handle_to_entry( handle ))) return NULL;
+    return begin_shared_entry_update( entry );
+}
+
+/* finish updating the shared table entry of a window */
+void end_shared_window_update( struct shared_window *shared )
+{
+    end_shared_entry_update( shared );
+}
+
 /* return a pointer to a user object from its handle */
 void *get_user_object( user_handle_t handle, enum user_object type )
 {
@@ -176,6 +243,31 @@ void free_process_user_handles( struct process *process )
             free_user_entry( &handles[i] );
 }
 
+/* get a read-only mapping of the shared window table, creating it on first use */
+DECL_HANDLER(get_shared_window_table)
+{
+    if (!shared_window_mapping)
+    {
+        void *ptr;
+        int i;
+
+        if (!(shared_window_mapping = create_shared_mapping( SHARED_WINDOW_COUNT * sizeof(*shared_windows),
+                                                             &ptr )))
+            return;
+        make_object_static( shared_window_mapping );
+        shared_windows = ptr;
+
+        /* publish the existing handles */
+        for (i = 0; i < nb_handles; i++)
+        {
+            if (!handles[i].type) continue;
+            update_shared_entry( &handles[i] );
+            if (handles[i].type == USER_WINDOW) update_shared_window( handles[i].ptr );
+        }
+    }
+    reply->handle = alloc_handle( current->process, shared_window_mapping, SECTION_QUERY | SECTION_MAP_READ, 0 );
+}
+
 /* allocate an arbitrary user handle */
 DECL_HANDLER(alloc_user_handle)
 {
@@ -60,6 +60,8 @@ struct global_cursor
     unsigned int         clip_msg;         /* message to post for cursor clip changes */
     unsigned int         last_change;      /* time of last position change */
     user_handle_t        win;              /* window that contains the cursor */
+    unsigned int         history_pos;      /* next position to write in the history */
+    struct cursor_pos    history[64];      /* history of the cursor positions */
 };
 
 struct desktop
@@ -88,6 +90,8 @@ extern user_handle_t get_user_full_handle( user_handle_t handle );
 extern void *free_user_handle( user_handle_t handle );
 extern void *next_user_handle( user_handle_t *handle, enum user_object type );
 extern void free_process_user_handles( struct process *process );
+extern struct shared_window *begin_shared_window_update( user_handle_t handle );
+extern void end_shared_window_update( struct shared_window *shared );
 
 /* clipboard functions */
 
@@ -155,6 +159,7 @@ extern void get_top_window_rectangle( struct desktop *desktop, rectangle_t *rect
 extern void post_desktop_message( struct desktop *desktop, unsigned int message,
                                   lparam_t wparam, lparam_t lparam );
 extern void destroy_window( struct window *win );
+extern void update_shared_window( struct window *win );
 extern void destroy_thread_windows( struct thread *thread );
 extern int is_child_window( user_handle_t parent, user_handle_t child );
 extern int is_valid_foreground_window( user_handle_t window );
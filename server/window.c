@@ -189,6 +189,24 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+/* publish the window information in the shared window table */
+void update_shared_window( struct window *win )
+{
+    struct shared_window *shared;
+
+    if (!(shared = begin_shared_window_update( win->handle ))) return;
+    shared->tid      = win->thread ? get_thread_id( win->thread ) : 0;
+    shared->pid      = win->thread ? get_process_id( win->thread->process ) : 0;
+    shared->style    = win->style;
+    shared->ex_style = win->ex_style;
+    shared->parent   = win->parent ? win->parent->handle : 0;
+    shared->owner    = win->owner;
+    shared->dpi      = win->dpi;
+    shared->window   = win->window_rect;
+    shared->client   = win->client_rect;
+    end_shared_window_update( shared );
+}
+
 /* link a window at the right place in the siblings list */
 static void link_window( struct window *win, struct window *previous )
 {
@@ -242,6 +260,7 @@ static void link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    update_shared_window( win );
 }
 
 /* change the parent of a window (or unlink the window if the new parent is NULL) */
@@ -284,6 +303,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
     }
+    update_shared_window( win );
     return 1;
 }
 
@@ -422,6 +442,7 @@ static void detach_window_thread( struct window *win )
     /* destroyed when the desktop ref count reaches zero */
     release_object( win->desktop );
     win->thread = NULL;
+    update_shared_window( win );
 }
 
 /* get the process owning the top window of a given desktop */
@@ -1721,8 +1742,10 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_shared_window( child );
         }
     }
+    update_shared_window( win );
 
     /* reset cursor clip rectangle when the desktop changes size */
     if (win == win->desktop->top_window) win->desktop->cursor.clip = *window_rect;
@@ -1891,6 +1914,7 @@ void destroy_window( struct window *win )
     {
         struct region *vis_rgn = get_visible_region( win, DCX_WINDOW );
         win->style &= ~WS_VISIBLE;
+        update_shared_window( win );
         if (vis_rgn)
         {
             struct region *exposed_rgn = expose_window( win, &win->window_rect, vis_rgn );
@@ -1980,6 +2004,8 @@ DECL_HANDLER(create_window)
         win->dpi = req->dpi;
     }
 
+    update_shared_window( win );
+
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
     reply->owner     = win->owner;
@@ -2041,6 +2067,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shared_window( desktop->top_window );
         }
     }
 
@@ -2053,6 +2080,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shared_window( desktop->msg_window );
         }
     }
 
@@ -2088,6 +2116,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_shared_window( win );
 }
 
 
@@ -2162,6 +2191,7 @@ DECL_HANDLER(set_window_info)
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE)) update_shared_window( win );
 }
 
 